@@ -2,8 +2,129 @@
 #ifndef GENERATE_3AC_H
 #define GENERATE_3AC_H
 
+#include <stdio.h>
 #include "ast.h"
+#include "symtab.h"
+#include "bytecode.h"
+#include "bounds.h"
 
-void generate3AC(ASTNode* root);
+// Operand of a quadruple
+typedef enum {
+    OPND_NONE,
+    OPND_TEMP,      // t<value>
+    OPND_VAR,       // names[value], declared variables keep their slot as index
+    OPND_LITERAL,   // integer literal (value, base)
+    OPND_CHAR,      // character literal
+    OPND_CONST,     // bare integer used by conditional jumps
+    OPND_HIDDEN     // integer counter of a for loop over the char variable names[value]
+} OperandKind;
 
-#endif
\ No newline at end of file
+typedef struct {
+    OperandKind kind;
+    int value;
+    int base;
+} Operand;
+
+typedef enum {
+    TAC_COPY,       // result := arg1
+    TAC_BINARY,     // result := arg1 op arg2, arithmetic or relational; OPR_DIV_ASSIGN reports division by zero
+    TAC_IF,         // if arg1 op arg2 goto label
+    TAC_GOTO,       // goto label
+    TAC_LABEL,      // label:
+    TAC_PRINT,      // print io[label]
+    TAC_SCAN,       // scan io[label]
+    TAC_MSG,        // diagnostic msgs[label], exits if it is fatal
+    TAC_LOAD,       // result := element arg1 of the array in slot label
+    TAC_STORE,      // element arg1 of the array in slot label := arg2
+    TAC_NOP         // removed by the optimizer, dropped when the code is compacted
+} TACOpcode;
+
+typedef struct {
+    TACOpcode opcode;
+    Operator op;
+    Operand result, arg1, arg2;
+    int label;          // jump target, or the io / message index
+    int marks;          // 1 if the result variable is marked as assigned (the := path)
+    int unchecked;      // TAC_LOAD and TAC_STORE: the index is known to be in bounds
+} Quad;
+
+// Three address code of one program, temps and labels are numbered from 1
+typedef struct {
+    Quad* code;
+    int ncode;
+    int cap;
+    int ntemps;
+    int nlabels;
+    int unoptimized;    // instruction count before optimizeTAC
+    // set by allocateRegisters: t1..t<registers> are registers, the spill slots follow
+    int unallocated;    // temps before allocation, 0 if the temps were not allocated
+    int registers;
+    int spillSlots;
+    int pressure;       // most temps live at one point
+    // set by reduceInductionVariables
+    int reducedMuls;    // multiplications by induction variables removed from loops
+    int reducedLoops;
+    int runningAdds;    // additions that keep the running values
+    int mulsPerIteration;   // removed multiplications that ran on every iteration, summed over the loops
+    ASTNode* fastLoops[MAX_HOISTED_LOOPS];  // loops whose copy without bounds checks is being generated
+    int nfastLoops;
+
+    // variable names, the first nvars are the declared slots, undeclared uses follow
+    char** names;
+    int nnames;
+    int nvars;
+    int namesCap;
+    SymbolTable* symbols;
+
+    IODesc* io;
+    int nio;
+    int ioCap;
+    Message* msgs;
+    int nmsgs;
+    int msgsCap;
+} TACProgram;
+
+// Optimization passes, combined as a bit mask
+typedef enum {
+    PASS_PROPAGATE = 1 << 0,    // copy and constant propagation, constant folding
+    PASS_CSE       = 1 << 1,    // common subexpressions within a basic block
+    PASS_DCE       = 1 << 2,    // unused temps, unreachable code and unused labels
+    PASS_PEEPHOLE  = 1 << 3,    // compare-and-branch fusion, copy coalescing, jump cleanup
+    PASS_SCCP      = 1 << 4,    // constants and unreachable branches over an SSA form
+    PASS_LICM      = 1 << 5,    // loop-invariant computations move in front of their loops
+    PASS_STRENGTH  = 1 << 6,    // multiplications by induction variables become running additions
+    PASS_ALL       = (1 << 7) - 1
+} TACPass;
+
+#define TAC_REGISTERS 16    // default register count of allocateRegisters
+
+// Generation and printing
+TACProgram* generate3AC(ASTNode* root, SymbolTable* symbols);
+void printTAC(TACProgram* prog, FILE* out);
+void freeTAC(TACProgram* prog);
+
+// Execution: the quadruples are assembled into the register VM's flat code
+BytecodeProgram* assembleTAC(TACProgram* prog);
+
+// C backend: writes a standalone program to be built with gcc -O2
+void generateC(TACProgram* prog, FILE* out);
+
+// Optimization
+void optimizeTAC(TACProgram* prog, int passes);
+int parseTACPasses(const char* list);
+
+// Sparse conditional constant propagation (PASS_SCCP), returns 1 if the code changed
+int propagateConditionalConstants(TACProgram* prog);
+
+// Loop-invariant code motion (PASS_LICM), returns 1 if the code changed
+int hoistLoopInvariants(TACProgram* prog);
+
+// Induction variable strength reduction (PASS_STRENGTH), returns 1 if the code changed.
+// Runs after the other passes: running values are temps with several definitions.
+int reduceInductionVariables(TACProgram* prog);
+
+// Register allocation, after optimization: linear scan over live intervals onto
+// nregs registers, temps that do not fit get spill slots
+void allocateRegisters(TACProgram* prog, int nregs);
+
+#endif
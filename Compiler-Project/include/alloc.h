@@ -0,0 +1,15 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+
+// Heap arrays for tables that are freed one by one rather than with an arena.
+// Both exit on allocation failure.
+
+// Function to allocate count zeroed elements, at least one
+void* allocArray(size_t count, size_t elem);
+
+// Function to make room for needed elements, doubling *cap from 64
+void* growArray(void* array, int* cap, int needed, size_t elem);
+
+#endif // ALLOC_H
@@ -0,0 +1,25 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator: memory is handed out from large blocks and released all at once
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;
+    size_t allocated; // bytes handed out, for statistics
+} Arena;
+
+void arenaInit(Arena* arena);
+void* arenaAlloc(Arena* arena, size_t size);
+void* arenaCalloc(Arena* arena, size_t size);
+char* arenaStrdup(Arena* arena, const char* str);
+void arenaFree(Arena* arena);
+
+#endif // ARENA_H
@@ -1,6 +1,11 @@
 #ifndef AST_H
 #define AST_H
 
+#include "arena.h"
+#include "intern.h"
+
+#define MAX_ARRAY_LENGTH (1 << 24)  // elements of one array
+
 typedef enum {
     NODE_PROG,     // For program begin
     NODE_VARDEC,   // For each var decl
@@ -18,16 +23,44 @@ typedef enum {
     NODE_RELOP, // > < <= >= <> ==
     NODE_VAR,
     NODE_SCAN,
-    NODE_PRINT
+    NODE_PRINT,
+    NODE_INDEX     // array element
 } NodeType;
 
+// Operators of NODE_OP, NODE_RELOP, NODE_ASSIGN, NODE_INC and NODE_DEC nodes
+typedef enum {
+    OPR_ADD,        // +
+    OPR_SUB,        // -
+    OPR_MUL,        // *
+    OPR_DIV,        // /
+    OPR_MOD,        // %
+    OPR_LT,         // <
+    OPR_GT,         // >
+    OPR_LE,         // <=
+    OPR_GE,         // >=
+    OPR_EQ,         // =
+    OPR_NE,         // <>
+    OPR_ASSIGN,     // :=
+    OPR_ADD_ASSIGN, // +=
+    OPR_SUB_ASSIGN, // -=
+    OPR_MUL_ASSIGN, // *=
+    OPR_DIV_ASSIGN, // /=
+    OPR_MOD_ASSIGN, // %=
+    OPR_INC,        // inc
+    OPR_DEC         // dec
+} Operator;
+
 typedef struct ll {
     char* string;
+    int name; // interned id of string
+    int slot; // frame slot set by the resolver, -1 if undeclared
     struct ll* next;
 }ll;
 
 typedef struct ASTNode {
     NodeType type;
+    int line, column;   // source position of a statement (1 based), set by the parser, 0 elsewhere
+    int profile;        // entry of a statement in a profile, set by createProfile
     union {
         // basic constants character and integer
         struct {
@@ -41,7 +74,7 @@ typedef struct ASTNode {
         struct {
             struct ASTNode* left;
             struct ASTNode* right;
-            char* operator;
+            Operator op;
         } operator;
         
         // program Node
@@ -57,10 +90,11 @@ typedef struct ASTNode {
             struct ASTNode* next;
         } var_list;
 
-        // statements
+        // statements, a growable array living in the unit's arena
         struct {
-            struct ASTNode* statements[100]; // Assuming a maximum of 1000 statements in the statement block
-            int count; 
+            struct ASTNode** statements;
+            int count;
+            int capacity;
         } statements;
 
         // if-else block
@@ -82,45 +116,76 @@ typedef struct ASTNode {
             struct ASTNode* limit;
             struct ASTNode* update;
             struct ASTNode* stmts;
+            // set by hoistBoundsChecks: the body has a fast copy without bounds checks,
+            // entered when the counter and the limit lie in [low, high] (see bounds.h)
+            int hoisted;
+            int low, high;
+            // set by markCountedLoops: the limit is invariant and the step is the literal
+            // step (> 0), so the trip count can be computed on entry
+            int counted;
+            int step;
+            // set by markParallelLoops: the iterations are independent (see parallel.h),
+            // NULL if they may depend on each other
+            struct ParallelLoop* parallel;
         } for_loop_block;
 
         // print and scan statements
         struct {
-            char* keyword;
             char* string;
             ll* args;
             int count;
+            struct PrintTemplate* print;    // compiled print, set by the resolver
+            struct ScanTemplate* scan;      // compiled scan, set by the resolver
         }print_scan_stmt;
 
-        // Variable Name
-        char* identifier;
+        // Variable Name and the frame slot set by the resolver (-1 if undeclared)
+        struct {
+            char* identifier;
+            int name;   // interned id of identifier
+            int slot;
+            int length; // element count of an array declaration, 0 otherwise
+        } var;
+
+        // array element, loop is the for loop whose fast copy needs no bounds check
+        struct {
+            struct ASTNode* array;
+            struct ASTNode* index;
+            struct ASTNode* loop;
+        } index;
 
     } data;
 } ASTNode;
 
 
 
-// Basic node creation
-ASTNode* createASTNode();
-ASTNode* createNumberNode(int value, int base);
-ASTNode* createCharacterNode(char value);
-ASTNode* createVariable(char* value);
+// Basic node creation, nodes are allocated from the compilation unit's arena
+ASTNode* createASTNode(Arena* arena);
+ASTNode* createNumberNode(Arena* arena, int value, int base);
+ASTNode* createCharacterNode(Arena* arena, char value);
+ASTNode* createVariable(Arena* arena, Interner* names, int name);
+ASTNode* createArrayVariable(Arena* arena, Interner* names, int name, int length);
+ASTNode* createIndexNode(Arena* arena, ASTNode* array, ASTNode* index);
 
 // Complex node creation
-ASTNode* createStatementsNode();
-ASTNode* addStatement(ASTNode* stmts, ASTNode* stmt);
-ll* createArgList(char* arg, ll* next);
-ASTNode* createPrintOrScanNode(NodeType type, char* keyword, char* string, ll* args, int count);
-ASTNode* createForLoopNode(NodeType type, ASTNode* id, ASTNode* init, ASTNode* limit, ASTNode* update, ASTNode* stmts);
-ASTNode* createIfOrWhileLoopNode(NodeType type, ASTNode* condition, ASTNode* stmts);
-ASTNode* createIfElseLadderNode(NodeType type, ASTNode* condition, ASTNode* stmts, ASTNode* elsepart);
-ASTNode* createOperatorNode(NodeType type, ASTNode* left, ASTNode* right, char* operator);
-ASTNode* createVarDeclNode(NodeType type, char* dtype, ASTNode* variable, ASTNode* next);
-ASTNode* createProgramNode(NodeType type, ASTNode* VarDecl, ASTNode* StmtBlock);
-
-// AST operations
+ASTNode* createStatementsNode(Arena* arena);
+ASTNode* addStatement(Arena* arena, ASTNode* stmts, ASTNode* stmt);
+ll* createArgList(Arena* arena, char* arg, int name, ll* next);
+ASTNode* createPrintOrScanNode(Arena* arena, NodeType type, char* string, ll* args, int count);
+ASTNode* createForLoopNode(Arena* arena, NodeType type, ASTNode* init, ASTNode* limit, ASTNode* update, ASTNode* stmts);
+ASTNode* createIfOrWhileLoopNode(Arena* arena, NodeType type, ASTNode* condition, ASTNode* stmts);
+ASTNode* createIfElseLadderNode(Arena* arena, NodeType type, ASTNode* condition, ASTNode* stmts, ASTNode* elsepart);
+ASTNode* createOperatorNode(Arena* arena, NodeType type, ASTNode* left, ASTNode* right, Operator op);
+ASTNode* createVarDeclNode(Arena* arena, NodeType type, char* dtype, ASTNode* variable, ASTNode* next);
+ASTNode* createProgramNode(Arena* arena, NodeType type, ASTNode* VarDecl, ASTNode* StmtBlock);
+ASTNode* reverseVarDeclList(ASTNode* list);
+ASTNode* setLocation(ASTNode* node, int line, int column);
+
+// Operator helpers
+const char* operatorName(Operator op);
+Operator compoundBaseOperator(Operator op);
+
+// AST operations (the tree is released with its arena, see unit.h)
 void printAST(ASTNode* node);
-void freeAST(ASTNode* node);
 void printASTHelper(ASTNode* node, int indent);
 
 #endif // AST_H
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "ast.h"
+#include "symtab.h"
+
+#define MAX_HOISTED_LOOPS 2     // nested loops with a fast copy, each one doubles the code of its body
+#define MAX_OFFSET (1 << 20)    // largest step and index offset that is considered
+
+// Helpers of the loop analyses, shared with the parallel loop analysis
+
+// Function to list the children of a node other than a statement block
+int childNodes(ASTNode* node, ASTNode* out[4]);
+
+// Function to read a valid integer literal
+int literalValue(ASTNode* node, int* value);
+
+// Function to match an index of the form counter, counter + k, k + counter or counter - k
+int counterOffset(ASTNode* index, int counter, int* offset);
+
+// Counted for loops, found once after resolution. A loop is counted when its
+// counter is only changed by the loop itself, the step is a positive literal and
+// the limit is built from literals and int variables the body does not change.
+void markCountedLoops(ASTNode* root, SymbolTable* symbols);
+
+// Bounds check hoisting for counted for loops, run once after resolution.
+// A counted loop over an int counter with a step of at most 2^20 qualifies; every
+// access a[counter + k] in its body is then in bounds for all iterations whenever,
+// on entry,
+//     inc: counter >= low && limit <= high
+//     dec: limit >= low && counter <= high
+// The engines test this once and run a copy of the loop in which those accesses
+// (NODE_INDEX nodes whose loop field is the loop) are not checked; the original,
+// checked loop runs otherwise.
+void hoistBoundsChecks(ASTNode* root, SymbolTable* symbols);
+
+#endif // BOUNDS_H
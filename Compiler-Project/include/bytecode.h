@@ -0,0 +1,137 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "ast.h"
+#include "symtab.h"
+
+// Opcodes of the register VM. Operands a, b, c are frame slots unless noted.
+// Arrays are named by their variable slot, their elements live in a separate block
+// of ints at the offsets recorded in the symbol table.
+typedef enum {
+    OP_HALT,
+    OP_MOV,     // r[a] = r[b]
+    OP_SET,     // r[a] = r[b] and mark variable a as assigned (the := path)
+    OP_ADD,     // r[a] = r[b] + r[c]
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_DIVZ,    // r[a] = r[b] / r[c], reports division by zero (the /= path)
+    OP_SLT,     // r[a] = r[b] <  r[c]
+    OP_SLE,
+    OP_SGT,
+    OP_SGE,
+    OP_SEQ,
+    OP_SNE,
+    OP_LOAD,    // r[a] = element r[b] of array c, reports an index out of bounds
+    OP_LOADU,   // r[a] = element r[b] of array c, the index is known to be in bounds
+    OP_STORE,   // element r[b] of array a = r[c], reports an index out of bounds
+    OP_STOREU,  // element r[b] of array a = r[c], the index is known to be in bounds
+    OP_JMP,     // goto a
+    OP_JLT,     // if r[b] <  r[c] goto a
+    OP_JLE,
+    OP_JGT,
+    OP_JGE,
+    OP_JEQ,
+    OP_JNE,
+    OP_PRINT,   // run print descriptor a
+    OP_SCAN,    // run scan descriptor a
+    OP_MSG,     // emit diagnostic a, exits if it is fatal
+    OP_PFOR,    // split parallel loop a across the worker pool and goto b, or fall into the loop
+    OP_COUNT
+} OpCode;
+
+typedef struct {
+    int op;
+    int a, b, c;
+} Instr;
+
+// Resolved arguments of a print or scan statement
+typedef struct {
+    const char* format;
+    int count;          // argument count recorded by the parser
+    ll* args;           // resolved argument list
+    const struct PrintTemplate* print;  // compiled print, NULL for scans
+    const struct ScanTemplate* scan;    // compiled scan, NULL for prints
+} IODesc;
+
+// Diagnostic raised by OP_MSG
+typedef struct {
+    char* text;
+    int to_stderr;
+    int fatal;
+} Message;
+
+// A parallel loop (parallel.h) lowered for OP_PFOR. The loop code after OP_PFOR
+// runs it on the calling thread; the chunk code runs iterations on a copy of the
+// frame registers: body, step, then back to the body while the counter has not
+// reached chunkEnd, then halt.
+typedef struct {
+    struct ParallelLoop* loop;
+    int counter;        // slot of the int counter, set to its start before OP_PFOR
+    int limit;          // slot holding the limit, computed right before OP_PFOR
+    int step;           // change of the counter per iteration, negative for dec
+    int chunk;          // first instruction of the chunk code
+    int chunkEnd;       // hidden slot with the counter value that ends a chunk
+} ParallelDesc;
+
+// A compiled program: flat code plus everything the frame needs
+typedef struct {
+    Instr* code;
+    int ncode;
+
+    // Frame layout: [variables | hidden | temporaries | constants]
+    SymbolTable* symbols;
+    int nvars;          // declared variables, slots 0 .. nvars - 1
+    int nhidden;        // extra zero-initialised slots (char loop counters)
+    int ntemps;
+    int nconsts;
+    int nslots;
+    int* consts;
+
+    IODesc* io;
+    int nio;
+    Message* msgs;
+    int nmsgs;
+    ParallelDesc* parallel;
+    int nparallel;
+} BytecodeProgram;
+
+// Open addressing map from constant value to its index in a program's constants,
+// used by both lowerings to give every distinct value one constant
+typedef struct {
+    int* keys;
+    int* idx;
+    int hashCap;
+    int cap;            // capacity of the program's constant array
+} ConstPool;
+
+// Function to find or append a constant, returns its index
+int internConst(ConstPool* pool, BytecodeProgram* prog, int value);
+void freeConstPool(ConstPool* pool);
+
+// Lowering and execution
+BytecodeProgram* compileBytecode(ASTNode* root, SymbolTable* symbols);
+void runBytecode(BytecodeProgram* prog, Frame* frame);
+void printBytecode(BytecodeProgram* prog);
+void freeBytecode(BytecodeProgram* prog);
+
+// Runtime shared by the VM and the native code
+void vmPrint(BytecodeProgram* p, IODesc* d, int* r, FILE* out);
+void vmScan(BytecodeProgram* p, IODesc* d, int* r, unsigned char* assigned);
+void storeFrame(BytecodeProgram* p, int* r, unsigned char* assigned, int* elements, Frame* frame);
+
+// Runs the chunk code of a parallel loop on one thread's copy of the frame registers
+typedef void (*ChunkCode)(void* engine, const ParallelDesc* d, int* r, unsigned char* assigned, FILE* out);
+
+// Function to split the loop of an OP_PFOR across the worker pool when splitThreads
+// agrees. Returns 0 without running anything if the loop is to run sequentially.
+int runParallelFor(BytecodeProgram* p, const ParallelDesc* d, int* r, unsigned char* assigned, ChunkCode run, void* engine);
+
+// Native code for x86-64 Linux; compileNative returns NULL on other platforms
+typedef struct NativeCode NativeCode;
+NativeCode* compileNative(BytecodeProgram* prog);
+void runNative(NativeCode* native, Frame* frame);
+void freeNative(NativeCode* native);
+
+#endif // BYTECODE_H
@@ -0,0 +1,24 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "unit.h"
+#include "driver.h"
+
+// Compiled-artifact cache. A unit that parsed is stored after constant folding
+// as its AST and interned names, in a compact binary file named after the path of
+// the source, the compiler version and the options that shape the tree. Later
+// runs map that file and rebuild the tree from it instead of scanning and parsing.
+// The file is trusted when the device, inode, size and mtime of the source are
+// the stored ones; otherwise the source is hashed and compared with the stored hash.
+#define CACHE_FORMAT 2      // bump when the encoding changes
+
+// Function to find the cache directory of the user, NULL if there is none
+const char* defaultCacheDir(void);
+
+// Loads a unit from options->cacheDir or parses it, folds it and stores it there.
+// The source is hashed at most once. Name resolution and the later phases run on
+// every load (analyzeUnit).
+// Returns what parseUnit returns.
+int parseOrLoadUnit(CompilationUnit* unit, const CompileOptions* options);
+
+#endif // CACHE_H
@@ -0,0 +1,57 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "3_ac.h"
+
+// Basic blocks of the quadruple array. A block starts at a label (a run of labels
+// starts one block), at the first quadruple and after a jump; it falls through to
+// the next block unless it ends with a goto.
+typedef struct {
+    int first, last;        // quadruples of the block
+    int succ[2];            // fall-through and jump target blocks, -1 if none
+    int* preds;
+    int npreds;
+    int idom;               // immediate dominator, -1 for the entry and unreachable blocks
+    int rpo;                // reverse postorder number, -1 if unreachable
+} BasicBlock;
+
+typedef struct {
+    BasicBlock* blocks;
+    int nblocks;
+    int* blockOf;           // quadruple -> block
+    int* order;             // reachable blocks in reverse postorder, the entry first
+    int nreachable;
+    int* predStore;
+} CFG;
+
+// Natural loop: a header and every block that reaches a back edge to it (an edge
+// into a block that dominates its source) without passing the header
+typedef struct {
+    int header;
+    int* blocks;            // blocks of the loop, in code order
+    int nblocks;
+    int parent;             // innermost enclosing loop, -1 if none
+} Loop;
+
+// Function to build the blocks and edges of a program, with dominators
+CFG* buildCFG(TACProgram* prog);
+void freeCFG(CFG* cfg);
+
+// Returns 1 if every path from the entry to block b passes through block a
+int dominates(CFG* cfg, int a, int b);
+
+// Function to find the natural loops, outer loops before the loops they contain.
+// Back edges to one header make one loop. Returns the number of loops.
+int findLoops(CFG* cfg, Loop** loops);
+void freeLoops(Loop* loops, int nloops);
+int loopContains(Loop* loop, int block);
+
+// Preheaders: code placed in front of a loop header runs once per entry of the loop
+// if the code before the header does not fall through into it from inside the loop
+// and jumps from outside the loop go to a label in front of that code.
+int hasPreheaderSpot(CFG* cfg, Loop* loop);
+// Function to send the jumps entering the loops with wanted[l] set to new labels;
+// label[l] is the new label of loop l, 0 if no jump enters it
+void enterThroughPreheaders(TACProgram* prog, CFG* cfg, Loop* loops, int nloops, const int* wanted, int* label);
+
+#endif // CFG_H
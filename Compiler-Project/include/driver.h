@@ -0,0 +1,24 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "unit.h"
+
+// Options shared by every unit of a run, read-only once compilation starts
+typedef struct {
+    int fold;       // constant folding on the AST
+    int passes;     // TACPass mask for the 3AC optimizer
+    int hoist;      // bounds checks of counted loops tested once on entry
+    int registers;  // registers for 3AC temps (allocateRegisters), 0 to keep every temp
+    const char* cacheDir;   // compiled-artifact cache (cache.h), NULL to always parse
+    int parallel;   // mark the loops a run may split across worker threads (parallel.h)
+} CompileOptions;
+
+// Phases of a parsed unit, each one runs at most once
+void analyzeUnit(CompilationUnit* unit, const CompileOptions* options);
+TACProgram* unitTAC(CompilationUnit* unit, const CompileOptions* options);
+
+// Compiles every file on a pool of worker threads and prints one status line per
+// file, in the order given. Returns the number of files that failed.
+int compileBatch(char** files, int nfiles, int threads, const CompileOptions* options);
+
+#endif // DRIVER_H
@@ -0,0 +1,16 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "ast.h"
+
+// Constant folding pass, run once between parsing and execution or 3AC generation.
+// Literals become base 10, constant sub-expressions collapse into a single literal
+// and if/else/while statements with a known condition are pruned.
+// Returns the node that replaces the given one, new nodes come from the arena.
+ASTNode* foldConstants(Arena* arena, ASTNode* node);
+
+// Arithmetic and relational operators on constants, shared with the 3AC optimizer.
+// Returns 0 for operations that have to fail at run time (division by zero).
+int foldBinaryOperator(Operator op, int left, int right, int* result);
+
+#endif // FOLD_H
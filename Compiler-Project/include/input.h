@@ -0,0 +1,40 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdio.h>
+#include "arena.h"
+#include "ast.h"
+#include "symtab.h"
+
+// Program input. stdin is mapped when it is a regular file and read in large
+// blocks otherwise; nothing else may read stdin through stdio.
+// The scan functions return what the scanf call with the same format would.
+int inputChar(void);                            // getchar()
+int inputScanInt(int* value);                   // scanf("%d")
+int inputScanChar(char* c);                     // scanf(" %c")
+int inputScanPair(int* value, int* base);       // scanf("(%d, %d)")
+
+// One literal run of a scan format and the variable read after it
+typedef struct {
+    const char* text;       // characters that must match, not NUL terminated
+    int length;
+    int slot;
+    int is_char;
+} ScanPart;
+
+// A scan statement compiled into a matcher, like PrintTemplate
+typedef struct ScanTemplate {
+    ScanPart* parts;
+    int nparts;
+    const char* tail;       // literal text after the last variable
+    int tailLength;
+    const char* notice;     // written to stdout after matching, NULL if none
+    const char* error;      // fatal diagnostic after matching, NULL if the statement is valid
+} ScanTemplate;
+
+ScanTemplate* compileScan(Arena* arena, SymbolTable* symbols, const char* format, ll* args);
+
+// Values go to ints[slot], or chars[slot] for char variables when chars is given
+void runScan(const ScanTemplate* t, int* ints, char* chars, unsigned char* assigned);
+
+#endif // INPUT_H
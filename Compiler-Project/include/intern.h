@@ -0,0 +1,27 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include "arena.h"
+
+// Interned strings of a compilation unit. Each distinct identifier or string
+// constant is stored once in the unit's arena and numbered from 0, so later
+// passes can compare names by id (or by pointer) and index arrays with them.
+typedef struct {
+    Arena* arena;
+    char** strings;         // id -> NUL terminated string
+    unsigned* hashes;       // id -> hash of the string
+    int count;
+    int cap;
+
+    // open addressing index from hash to id + 1 (0 marks an empty bucket)
+    int* index;
+    int indexCap;
+} Interner;
+
+void internInit(Interner* interner, Arena* arena);
+int intern(Interner* interner, const char* text, size_t length);
+char* internString(Interner* interner, const char* text, size_t length);
+void internFree(Interner* interner);
+
+#endif // INTERN_H
@@ -0,0 +1,39 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "arena.h"
+#include "ast.h"
+#include "symtab.h"
+
+// One literal run of a print format and the value printed after it
+typedef struct {
+    const char* text;       // points into the format string, not NUL terminated
+    int length;
+    int slot;
+    int is_char;
+} PrintPart;
+
+// A print statement split once into literal segments and resolved argument slots
+typedef struct PrintTemplate {
+    PrintPart* parts;
+    int nparts;
+    const char* tail;       // text after the last value
+    int tailLength;
+    const char* error;      // fatal diagnostic after the output, NULL if the statement is valid
+} PrintTemplate;
+
+// Output channel of the engines: stdout, with a large buffer when it is not a terminal
+void initOutput(void);
+void flushOutputForInput(void);
+
+// Diagnostics of bad print and scan arguments: fmt with the argument name, allocated from the arena
+char* formatArgumentError(Arena* arena, const char* fmt, const char* name);
+
+PrintTemplate* compilePrint(Arena* arena, SymbolTable* symbols, const char* format, ll* args, int count);
+
+// Values come from ints[slot], or chars[slot] for char variables when chars is given
+void runPrint(const PrintTemplate* t, const int* ints, const char* chars);
+// Same as runPrint, printing to out instead of stdout
+void writePrint(FILE* out, const PrintTemplate* t, const int* ints, const char* chars);
+
+#endif // OUTPUT_H
@@ -0,0 +1,65 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdio.h>
+#include "arena.h"
+#include "ast.h"
+#include "symtab.h"
+
+#define PARALLEL_MIN_WORK 50000     // estimated nodes evaluated by a loop before it is split
+#define PARALLEL_CHUNKS 4           // chunks of iterations per thread, taken in turn by idle threads
+
+// How a scalar written by a parallel loop gets its value after the loop
+typedef enum {
+    PARALLEL_PRIVATE,   // assigned before it is read in every iteration: value of the last iteration
+    PARALLEL_SUM,       // only changed by += and -=: sum of the partial results of the threads
+    PARALLEL_PRODUCT    // only changed by *=: product of the partial results
+} ParallelKind;
+
+// A counted for loop whose iterations do not depend on each other. Every array
+// access of the body is a[counter + k], and an array that is written is accessed
+// with one k only, so two iterations never touch the same element unless both
+// only read it. The accesses are all in bounds when, on entry, every value of the
+// counter lies in [low, high].
+typedef struct ParallelLoop {
+    int* slots;             // scalars the body writes
+    ParallelKind* kinds;
+    int nslots;
+    int low, high;
+    int work;               // estimated nodes evaluated by one iteration
+} ParallelLoop;
+
+// Dependence analysis, run once after markCountedLoops. A counted loop over an int
+// counter is parallel when its body cannot fail (no scan, no undeclared or
+// mistyped variables, no division by anything but a literal other than 0 and -1,
+// no print with an error, no index other than counter + k) and every scalar it
+// writes is private to an iteration or a reduction.
+void markParallelLoops(Arena* arena, ASTNode* root, SymbolTable* symbols);
+
+// Threads a parallel loop may be split across, 1 to run every loop on the calling
+// thread. The workers are started by the first split loop.
+void setWorkerThreads(int threads);
+
+// Function to get the threads to split a parallel loop across when its counter
+// starts at start and changes by step, trips times. Returns 0 if the loop is too
+// short to be worth splitting or its accesses would leave an array.
+int splitThreads(ParallelLoop* loop, int start, int step, long long trips);
+
+// Runs iterations [first, end) of a split loop on the state of thread t, printing into out
+typedef void (*ChunkRunner)(void* context, int t, long long first, long long end, FILE* out);
+
+// Function to run the trips iterations of a split loop in chunks on threads threads,
+// the calling thread being thread 0. Output reaches stdout in iteration order.
+// Returns the thread that ran the last iteration.
+int runSplitLoop(long long trips, int threads, ChunkRunner run, void* context);
+
+// Function to fold the partial result of one thread into a reduction, wrapping like
+// the sequential loop; partial results start at 0 for sums and 1 for products
+int combinePartial(ParallelKind kind, int total, int part);
+
+// Function to run the iterations of a parallel loop in the AST walker, see splitThreads.
+// Returns 0 without running anything if the loop is not split.
+// Output is printed in iteration order and the frame ends as after a sequential run.
+int runParallelLoop(ASTNode* node, Frame* frame, int start, int step, long long trips);
+
+#endif // PARALLEL_H
@@ -0,0 +1,45 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "symtab.h"
+
+#define PROFILE_REPORT_LINES 20     // hottest statements listed in the report
+
+// Counters of one statement. Times include the statements nested in it; the
+// part spent in nested statements is kept apart so the self time can be shown.
+typedef struct {
+    ASTNode* node;
+    int parent;                 // enclosing statement, -1 at the top level
+    int body;                   // first statement of a loop body (its count gives the iterations), -1 if none
+    long long count;            // executions
+    long long total_ns;
+    long long nested_ns;
+    long long started_ns;       // start of the execution in progress
+} ProfileEntry;
+
+// Statement profile of one run of the AST walker. Statements are numbered in
+// source order (ASTNode.profile) when the profile is created; a frame with a
+// profile runs every statement through profileStatement.
+typedef struct Profile {
+    ProfileEntry* entries;
+    int count;
+    int current;                // statement running now, -1 outside of all
+    long long start_ns;
+    const char* path;           // machine readable copy of the report, NULL for none
+} Profile;
+
+Profile* createProfile(ASTNode* root, const char* path);
+void freeProfile(Profile* profile);
+
+// Function to run one statement of a block and charge its time to it
+void profileStatement(Profile* profile, ASTNode* stmt, Frame* frame);
+
+// Prints the hot spots to out and writes the full profile to profile->path.
+// A profile that is still attached to a run when the program exits on a
+// run-time error is reported at exit.
+void startProfile(Profile* profile);
+void finishProfile(Profile* profile, FILE* out);
+
+#endif // PROFILE_H
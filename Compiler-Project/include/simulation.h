@@ -1,32 +1,28 @@
-#ifndef SYMBOL_TABLE_H
-#define SYMBOL_TABLE_H
+#ifndef SIMULATION_H
+#define SIMULATION_H
 
+#include <stddef.h>
 #include "ast.h"
+#include "symtab.h"
 
-// Symbol Table Entry
-typedef struct Symbol {
-    char name[100];
-    int int_value;
-    char char_value;
-    int is_char; // 1 if variable is char, 0 if int
-    int assigned; // 1 if value is assigned
-    struct Symbol* next;
-} Symbol;
+// Execution engines selectable at run time
+typedef enum {
+    ENGINE_VM,      // bytecode dispatch loop (default)
+    ENGINE_TAC,     // optimized three address code, run as flat quadruples
+    ENGINE_JIT,     // bytecode translated to x86-64 machine code
+    ENGINE_TREE     // reference tree walker
+} ExecEngine;
 
-// Global Symbol Table
-extern Symbol* symbol_table;
-
-// Symbol Table Functions
-void updateSymbolTable(char* name, int is_char, int int_val, char char_val);
-void declareSymbol(char* name, int is_char);
-int getIntValue(char* name);
+// Literal and input helpers shared by the engines
+int tryConvertToDecimal(int value, int base, int* result, char* msg, size_t size);
+int convertToDecimal(int value, int base);
+int scanIntValue();
+char scanCharValue();
+void reportIndexError(const char* name, int index, int length);
 
 // AST Evaluation Functions
-int evaluateExpression(ASTNode* node);
-int evaluateCondition(ASTNode* node);
-void evaluateAST(ASTNode* node);
-
-// Utility to Print Symbol Table
-void printSymbolTable();
+int evaluateExpression(ASTNode* node, Frame* frame);
+int evaluateCondition(ASTNode* node, Frame* frame);
+void evaluateAST(ASTNode* node, Frame* frame);
 
-#endif // SYMBOL_TABLE_H
+#endif // SIMULATION_H
@@ -0,0 +1,56 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "intern.h"
+
+#define SYMBOL_TABLE_ELEMENTS 10    // array elements shown by printSymbolTable
+
+// Declared variables, one dense slot each. Names are only kept for
+// printing the table and for diagnostics.
+typedef struct {
+    char** names;           // slot -> name, in declaration order
+    unsigned char* is_char; // slot -> 1 if char, 0 if int
+    int* length;            // slot -> element count of an array, 0 for scalars
+    int* offset;            // slot -> first element of an array in the element storage
+    int count;
+    int cap;
+    int nelements;          // elements of all arrays
+
+    int* slotOf;            // interned name -> slot + 1 (0 if not declared)
+    int nnames;
+} SymbolTable;
+
+// Runtime values of one execution, indexed by slot
+typedef struct {
+    SymbolTable* symbols;
+    int* int_value;
+    char* char_value;
+    unsigned char* assigned; // 1 if a value was assigned
+    int* int_elements;      // array elements, indexed by offset + index
+    char* char_elements;
+    struct Profile* profile; // statement counters of the AST walker, NULL unless profiling
+    FILE* output;           // where the AST walker prints, stdout unless a loop worker buffers it
+    int sequential;         // 1 if for loops must run on the calling thread (frames of loop workers)
+} Frame;
+
+// Symbol Table Functions
+SymbolTable* createSymbolTable(int nnames);
+int declareSymbol(SymbolTable* table, int name, char* text, int is_char, int length);
+int lookupSymbol(SymbolTable* table, int name);
+void freeSymbolTable(SymbolTable* table);
+
+// Resolution pass: declares the VarDecl block, maps every variable use to its slot
+// and compiles the print and scan statements into templates allocated from the arena
+SymbolTable* resolveProgram(Arena* arena, const Interner* names, ASTNode* root);
+
+// Frame Functions
+Frame* createFrame(SymbolTable* table);
+void resetSlot(Frame* frame, int slot);
+void freeFrame(Frame* frame);
+
+// Utility to Print Symbol Table
+void printSymbolTable(Frame* frame);
+
+#endif // SYMTAB_H
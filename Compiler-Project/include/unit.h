@@ -0,0 +1,52 @@
+#ifndef UNIT_H
+#define UNIT_H
+
+#include "arena.h"
+#include "ast.h"
+#include "symtab.h"
+#include "3_ac.h"
+#include "bytecode.h"
+
+// Source file mapped copy on write for scanning in place. The text is followed
+// by the two NUL bytes that flex's yy_scan_buffer expects. It lives only while
+// the unit is parsed; the tree keeps interned copies of the names it needs.
+typedef struct {
+    char* text;
+    size_t length;      // bytes of source
+    size_t mapped;      // bytes of address space reserved
+    size_t released;    // scanned bytes already given back
+} SourceMap;
+
+// Everything produced while compiling one source file. Units share no state, so
+// separate units can be compiled on separate threads.
+typedef struct {
+    const char* path;
+    Arena arena;                // owns the AST nodes, their strings and argument lists
+    Interner names;             // identifiers and string constants, stored once each
+    ASTNode* root;
+    char error[256];            // first syntax error, empty if the source parsed
+    SourceMap source;           // mapped source text, only while parsing
+    int folded;                 // constants already folded (by parseOrLoadUnit, see cache.h)
+    int cached;                 // the tree was loaded from the cache
+
+    // later phases, built on demand and released with the unit
+    SymbolTable* symbols;
+    TACProgram* tac;
+    BytecodeProgram* program;
+    NativeCode* native;
+} CompilationUnit;
+
+CompilationUnit* createCompilationUnit(const char* path);
+void freeCompilationUnit(CompilationUnit* unit);
+
+// Returns 0 on success, 1 if the file cannot be mapped (not a regular file),
+// -1 if it cannot be opened
+int mapSourceFile(const char* path, SourceMap* map);
+void releaseScannedSource(SourceMap* map, const char* position);
+void unmapSourceFile(SourceMap* map);
+
+// Parses the unit's file with a scanner of its own (parser.y).
+// Returns 0 on success, 1 on a syntax error (see unit->error), -1 if the file cannot be opened.
+int parseUnit(CompilationUnit* unit);
+
+#endif // UNIT_H
@@ -1,217 +1,398 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "alloc.h"
 #include "ast.h"
+#include "3_ac.h"
+#include "simulation.h"
 
-int tempCount = 1;
-int labelCount = 1;
+static const Operand noOperand = {OPND_NONE, 0, 0};
+
+// Function to append a quadruple
+static Quad* emitQuad(TACProgram* p, TACOpcode opcode, Operator op, Operand result, Operand arg1, Operand arg2, int label) {
+    p->code = growArray(p->code, &p->cap, p->ncode + 1, sizeof(Quad));
+    p->code[p->ncode] = (Quad){opcode, op, result, arg1, arg2, label, 0, 0};
+    return &p->code[p->ncode++];
+}
+
+static void emitJump(TACProgram* p, TACOpcode opcode, int label) {
+    emitQuad(p, opcode, OPR_ASSIGN, noOperand, noOperand, noOperand, label);
+}
+
+// Emits a diagnostic that fires when (and only when) this point is executed
+static void emitMessage(TACProgram* p, int to_stderr, int fatal, const char* fmt, const char* arg) {
+    int size = snprintf(NULL, 0, fmt, arg) + 1;
+    char* text = malloc(size);
+    snprintf(text, size, fmt, arg);
+    p->msgs = growArray(p->msgs, &p->msgsCap, p->nmsgs + 1, sizeof(Message));
+    p->msgs[p->nmsgs] = (Message){text, to_stderr, fatal};
+    emitQuad(p, TAC_MSG, OPR_ASSIGN, noOperand, noOperand, noOperand, p->nmsgs++);
+}
+
+static void emitIO(TACProgram* p, TACOpcode opcode, ASTNode* node) {
+    p->io = growArray(p->io, &p->ioCap, p->nio + 1, sizeof(IODesc));
+    p->io[p->nio] = (IODesc){node->data.print_scan_stmt.string, node->data.print_scan_stmt.count,
+                                node->data.print_scan_stmt.args, node->data.print_scan_stmt.print,
+                                node->data.print_scan_stmt.scan};
+    emitQuad(p, opcode, OPR_ASSIGN, noOperand, noOperand, noOperand, p->nio++);
+}
 
 // Function to create new temporary variables
-char* newTemp() {
-    char* temp = (char*)malloc(10);
-    sprintf(temp, "t%d", tempCount++);
-    return temp;
+static Operand newTemp(TACProgram* p) {
+    return (Operand){OPND_TEMP, ++p->ntemps, 0};
 }
 
 // Function to create new labels
-char* newLabel() {
-    char* label = (char*)malloc(10);
-    sprintf(label, "L%d", labelCount++);
-    return label;
+static int newLabel(TACProgram* p) {
+    return ++p->nlabels;
 }
 
-// Function to generate 3AC recursively
-char* generate3AC(ASTNode* node) {
-    if (node == NULL) return NULL;
+// Function to turn a literal into an operand, reporting what evaluating it would report
+static Operand literalOperand(TACProgram* p, ASTNode* node) {
+    if (node->type == NODE_CHAR) {
+        emitMessage(p, 1, 1, "Unknown expression type!\n", NULL);
+        return (Operand){OPND_CHAR, node->data.value, 0};
+    }
+    int value;
+    char msg[128];
+    if (!tryConvertToDecimal(node->data.integer.value, node->data.integer.base, &value, msg, sizeof(msg)))
+        emitMessage(p, 0, 1, "%s", msg);
+    return (Operand){OPND_LITERAL, node->data.integer.value, node->data.integer.base};
+}
 
-    switch (node->type) {
-        case NODE_NUMBER: {
-            char* temp = newTemp();
-            // printf("// NUMBER NODE: %d (base %d)\n", node->data.integer.value, node->data.integer.base);
-            printf("%s := (%d, %d)\n", temp, node->data.integer.value, node->data.integer.base);
-            return temp;
-        }
+// Function to map a variable to its name index, undeclared names are added after the declared slots.
+// Names are interned, so equal names are the same pointer.
+static Operand varOperand(TACProgram* p, ASTNode* node) {
+    if (node->data.var.slot >= 0) return (Operand){OPND_VAR, node->data.var.slot, 0};
+    for (int i = p->nvars; i < p->nnames; i++) {
+        if (p->names[i] == node->data.var.identifier) return (Operand){OPND_VAR, i, 0};
+    }
+    p->names = growArray(p->names, &p->namesCap, p->nnames + 1, sizeof(char*));
+    p->names[p->nnames] = node->data.var.identifier;
+    return (Operand){OPND_VAR, p->nnames++, 0};
+}
+
+static Operand genExpr(TACProgram* p, ASTNode* node);
+
+// An access needs no bounds check in the fast copy of the loop it was hoisted to
+static int uncheckedAccess(TACProgram* p, ASTNode* node) {
+    for (int i = 0; i < p->nfastLoops; i++) {
+        if (p->fastLoops[i] == node->data.index.loop) return 1;
+    }
+    return 0;
+}
+
+static void emitElement(TACProgram* p, TACOpcode opcode, int array, Operand result, Operand index, Operand value, int unchecked) {
+    emitQuad(p, opcode, OPR_ASSIGN, result, index, value, array)->unchecked = unchecked;
+}
 
+// Literals used as the right operand are used in place
+static Operand genOperand(TACProgram* p, ASTNode* node) {
+    if (node->type == NODE_CHAR || node->type == NODE_NUMBER) return literalOperand(p, node);
+    return genExpr(p, node);
+}
+
+// Function to generate 3AC for an expression, returns where its value lives
+static Operand genExpr(TACProgram* p, ASTNode* node) {
+    switch (node->type) {
+        case NODE_NUMBER:
         case NODE_CHAR: {
-            char* temp = newTemp();
-            // printf("// CHAR NODE: '%c'\n", node->data.value);
-            printf("%s := '%c'\n", temp, node->data.value);
+            Operand value = literalOperand(p, node);
+            Operand temp = newTemp(p);
+            emitQuad(p, TAC_COPY, OPR_ASSIGN, temp, value, noOperand, 0);
             return temp;
         }
 
         case NODE_VAR: {
-            // printf("// VARIABLE NODE: %s\n", node->data.identifier);
-            return strdup(node->data.identifier);
+            int v = node->data.var.slot;
+            if (v >= 0 && p->symbols->length[v]) {
+                emitMessage(p, 1, 1, "Type Error: Cannot use array '%s' without an index\n", node->data.var.identifier);
+                return newTemp(p);
+            }
+            if (v == -1)
+                emitMessage(p, 1, 1, "Variable %s not declared!\n", node->data.var.identifier);
+            else if (p->symbols->is_char[v])
+                emitMessage(p, 1, 1, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", node->data.var.identifier);
+            return varOperand(p, node);
         }
 
-        case NODE_OP:
-        case NODE_RELOP: {
-            char* left = generate3AC(node->data.operator.left);
-            char right[32];
-        
-            if (node->data.operator.right->type == NODE_CHAR) {
-                char* temp = newTemp();
-                sprintf(right, "'%c'", node->data.operator.right->data.value);
-                printf("%s := %s %s %s\n", temp, left, node->data.operator.operator, right);
-                return temp;
-            } else if (node->data.operator.right->type == NODE_NUMBER) {
-                char* temp = newTemp();
-                sprintf(right, "(%d, %d)", node->data.operator.right->data.integer.value, node->data.operator.right->data.integer.base); 
-                printf("%s := %s %s %s\n", temp, left, node->data.operator.operator, right);
-                return temp;
-            } else {
-                char* rightExp = generate3AC(node->data.operator.right);
-                char* temp = newTemp();
-                printf("%s := %s %s %s\n", temp, left, node->data.operator.operator, rightExp);
+        case NODE_INDEX: {
+            ASTNode* array = node->data.index.array;
+            int v = array->data.var.slot;
+            if (v == -1)
+                emitMessage(p, 1, 1, "Variable %s not declared!\n", array->data.var.identifier);
+            else if (!p->symbols->length[v])
+                emitMessage(p, 1, 1, "Type Error: Variable '%s' is not an array\n", array->data.var.identifier);
+            else if (p->symbols->is_char[v])
+                emitMessage(p, 1, 1, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", array->data.var.identifier);
+            else {
+                Operand index = genOperand(p, node->data.index.index);
+                Operand temp = newTemp(p);
+                emitElement(p, TAC_LOAD, v, temp, index, noOperand, uncheckedAccess(p, node));
                 return temp;
             }
-        }        
-        case NODE_ASSIGN: {
-            char* left = generate3AC(node->data.operator.left);
-            char right[32];
-            if(strcmp(node->data.operator.operator, ":=") != 0){
-                if (node->data.operator.right->type == NODE_CHAR) {
-                    sprintf(right, "'%c'", node->data.operator.right->data.value);
-                    printf("%s := %s %c %s\n", left, left, node->data.operator.operator[0], right);
-                    return left;
-                } else if (node->data.operator.right->type == NODE_NUMBER) {
-                    sprintf(right, "(%d, %d)", node->data.operator.right->data.integer.value, node->data.operator.right->data.integer.base); 
-                    printf("%s := %s %c %s\n", left, left, node->data.operator.operator[0], right);
-                    return left;
-                } else {
-                    char* rightExp = generate3AC(node->data.operator.right);
-                    printf("%s := %s %c %s\n", left, left, node->data.operator.operator[0], rightExp);
-                    return left;
-                }
-            }else{
-                if (node->data.operator.right->type == NODE_CHAR) {
-                    sprintf(right, "'%c'", node->data.operator.right->data.value);
-                    printf("%s := %s\n", left, right);
-                    return left;
-                } else if (node->data.operator.right->type == NODE_NUMBER) {
-                    sprintf(right, "(%d, %d)", node->data.operator.right->data.integer.value, node->data.operator.right->data.integer.base); 
-                    printf("%s := %s\n", left, right);
-                    return left;
-                } else {
-                    char* rightExp = generate3AC(node->data.operator.right);
-                    printf("%s := %s\n", left, rightExp);
-                    return left;
-                }
-            }
-        }        
+            return newTemp(p);
+        }
+
+        case NODE_OP:
+        case NODE_RELOP: {
+            Operand left = genExpr(p, node->data.operator.left);
+            Operand right = genOperand(p, node->data.operator.right);
+            Operand temp = newTemp(p);
+            emitQuad(p, TAC_BINARY, node->data.operator.op, temp, left, right, 0);
+            return temp;
+        }
+
+        default:
+            emitMessage(p, 1, 1, "Unknown expression type!\n", NULL);
+            return newTemp(p);
+    }
+}
+
+// Function to generate an assignment to an array element: index, value, then the bounds check
+static void genElementAssign(TACProgram* p, ASTNode* node) {
+    ASTNode* target = node->data.operator.left;
+    ASTNode* right = node->data.operator.right;
+    char* name = target->data.index.array->data.var.identifier;
+    int v = target->data.index.array->data.var.slot;
+
+    if (v == -1) {
+        emitMessage(p, 0, 0, "Error: Variable %s not declared\n", name);
+        return;
+    }
+    if (!p->symbols->length[v]) {
+        emitMessage(p, 1, 1, "Type Error: Variable '%s' is not an array\n", name);
+        return;
+    }
+    if (right->type == NODE_CHAR && !p->symbols->is_char[v]) {
+        emitMessage(p, 1, 1, "Type Error: Cannot assign char to int variable '%s'\n", name);
+        return;
+    }
+    if (right->type != NODE_CHAR && p->symbols->is_char[v]) {
+        emitMessage(p, 1, 1, "Type Error: Cannot assign int to char variable '%s'\n", name);
+        return;
+    }
+
+    int unchecked = uncheckedAccess(p, target);
+    Operand index = genOperand(p, target->data.index.index);
+    if (right->type == NODE_CHAR) {
+        emitElement(p, TAC_STORE, v, noOperand, index, (Operand){OPND_CHAR, right->data.value, 0}, unchecked);
+        return;
+    }
+    Operand value = genOperand(p, right);
+    Operator op = node->data.operator.op;
+    if (op == OPR_ASSIGN) {
+        emitElement(p, TAC_STORE, v, noOperand, index, value, unchecked);
+        return;
+    }
+    Operand element = newTemp(p);
+    Operand result = newTemp(p);
+    emitElement(p, TAC_LOAD, v, element, index, noOperand, unchecked);
+    emitQuad(p, TAC_BINARY, op == OPR_DIV_ASSIGN ? op : compoundBaseOperator(op), result, element, value, 0);
+    emitElement(p, TAC_STORE, v, noOperand, index, result, 1);
+}
+
+// Function to generate an assignment, with the checks the simulator makes before evaluating it
+static void genAssign(TACProgram* p, ASTNode* node) {
+    ASTNode* target = node->data.operator.left;
+    ASTNode* right = node->data.operator.right;
+    if (target->type == NODE_INDEX) {
+        genElementAssign(p, node);
+        return;
+    }
+    char* name = target->data.var.identifier;
+    int v = target->data.var.slot;
+
+    if (v == -1) {
+        emitMessage(p, 0, 0, "Error: Variable %s not declared\n", name);
+        return;
+    }
+    if (p->symbols->length[v]) {
+        emitMessage(p, 1, 1, "Type Error: Cannot use array '%s' without an index\n", name);
+        return;
+    }
+    Operand left = varOperand(p, target);
+    if (right->type == NODE_CHAR) {
+        if (!p->symbols->is_char[v]) {
+            emitMessage(p, 1, 1, "Type Error: Cannot assign char to int variable '%s'\n", name);
+            return;
+        }
+        emitQuad(p, TAC_COPY, OPR_ASSIGN, left, (Operand){OPND_CHAR, right->data.value, 0}, noOperand, 0)->marks = 1;
+        return;
+    }
+    if (p->symbols->is_char[v]) {
+        emitMessage(p, 1, 1, "Type Error: Cannot assign int to char variable '%s'\n", name);
+        return;
+    }
+
+    Operand value = genOperand(p, right);
+    Operator op = node->data.operator.op;
+    if (op == OPR_ASSIGN) {
+        emitQuad(p, TAC_COPY, OPR_ASSIGN, left, value, noOperand, 0)->marks = 1;
+    } else {
+        // /= keeps its own operator, it reports division by zero instead of trapping
+        emitQuad(p, TAC_BINARY, op == OPR_DIV_ASSIGN ? op : compoundBaseOperator(op), left, left, value, 0);
+    }
+}
+
+static void gen(TACProgram* p, ASTNode* node);
+
+// Function to generate a for loop: runs while the counter is below the limit (above it
+// for dec), the limit is evaluated before and the step after every iteration
+static void genCountedLoop(TACProgram* p, ASTNode* node, Operand i) {
+    ASTNode* update = node->data.for_loop_block.update;
+    int inc = update->type == NODE_INC;
+    int labelStart = newLabel(p);
+    int labelEnd = newLabel(p);
+
+    emitJump(p, TAC_LABEL, labelStart);
+    Operand limit = genOperand(p, node->data.for_loop_block.limit);
+    emitQuad(p, TAC_IF, inc ? OPR_GE : OPR_LE, noOperand, i, limit, labelEnd);
+    gen(p, node->data.for_loop_block.stmts);
+    Operand step = genOperand(p, update->data.operator.left);
+    emitQuad(p, TAC_BINARY, inc ? OPR_ADD : OPR_SUB, i, i, step, 0);
+    emitJump(p, TAC_GOTO, labelStart);
+    emitJump(p, TAC_LABEL, labelEnd);
+}
+
+// Function to generate 3AC recursively
+static void gen(TACProgram* p, ASTNode* node) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_ASSIGN:
+            genAssign(p, node);
+            break;
 
         case NODE_IF: {
-            // printf("// IF STATEMENT\n");
-            char* condition = generate3AC(node->data.if_while_block.condition);
-            char* labelEnd = newLabel();
-
-            printf("if %s == 0 goto %s\n", condition, labelEnd);
-            generate3AC(node->data.if_while_block.stmts);
-            printf("%s:\n", labelEnd);
-            return NULL;
+            Operand condition = genExpr(p, node->data.if_while_block.condition);
+            int labelEnd = newLabel(p);
+
+            emitQuad(p, TAC_IF, OPR_EQ, noOperand, condition, (Operand){OPND_CONST, 0, 0}, labelEnd);
+            gen(p, node->data.if_while_block.stmts);
+            emitJump(p, TAC_LABEL, labelEnd);
+            break;
         }
 
         case NODE_IF_ELSE: {
-            // printf("// IF-ELSE STATEMENT\n");
-            char* condition = generate3AC(node->data.if_else_block.condition);
-
-            char* labelFalse = newLabel();
-            char* labelEnd = newLabel();
-
-            printf("if %s == 0 goto %s\n", condition, labelFalse);
-            generate3AC(node->data.if_else_block.stmts);
-            printf("goto %s\n", labelEnd);
-            printf("%s:\n", labelFalse);
-            generate3AC(node->data.if_else_block.else_part);
-            printf("%s:\n", labelEnd);
-            return NULL;
+            Operand condition = genExpr(p, node->data.if_else_block.condition);
+            int labelFalse = newLabel(p);
+            int labelEnd = newLabel(p);
+
+            emitQuad(p, TAC_IF, OPR_EQ, noOperand, condition, (Operand){OPND_CONST, 0, 0}, labelFalse);
+            gen(p, node->data.if_else_block.stmts);
+            emitJump(p, TAC_GOTO, labelEnd);
+            emitJump(p, TAC_LABEL, labelFalse);
+            gen(p, node->data.if_else_block.else_part);
+            emitJump(p, TAC_LABEL, labelEnd);
+            break;
         }
 
         case NODE_WHILE: {
-            // printf("// WHILE LOOP\n");
-            char* labelStart = newLabel();
-            char* labelEnd = newLabel();
-
-            printf("%s:\n", labelStart);
-            char* condition = generate3AC(node->data.if_while_block.condition);
-            printf("if %s == 0 goto %s\n", condition, labelEnd);
-
-            generate3AC(node->data.if_while_block.stmts);
-            printf("goto %s\n", labelStart);
-            printf("%s:\n", labelEnd);
-            return NULL;
+            int labelStart = newLabel(p);
+            int labelEnd = newLabel(p);
+
+            emitJump(p, TAC_LABEL, labelStart);
+            Operand condition = genExpr(p, node->data.if_while_block.condition);
+            emitQuad(p, TAC_IF, OPR_EQ, noOperand, condition, (Operand){OPND_CONST, 0, 0}, labelEnd);
+            gen(p, node->data.if_while_block.stmts);
+            emitJump(p, TAC_GOTO, labelStart);
+            emitJump(p, TAC_LABEL, labelEnd);
+            break;
         }
 
         case NODE_FOR: {
-            // printf("// FOR LOOP\n");
-            char* labelStart = newLabel();
-            char* labelEnd = newLabel();
-            
-            ASTNode* u = node->data.for_loop_block.update->data.operator.left;
-            ASTNode* i = node->data.for_loop_block.init->data.operator.left;
-            char* iord = node->data.for_loop_block.update->data.operator.operator; 
-
-            generate3AC(node->data.for_loop_block.init);
-            printf("%s:\n", labelStart);
-            char* condition = generate3AC(node->data.for_loop_block.limit);
-            char* update = newTemp();
-            char* check = newTemp();
-            printf("%s := (%d, %d)\n", update, u->data.integer.value, u->data.integer.base);
-            printf("%s := %s > %s\n", check, i->data.identifier, condition );
-            printf("if %s == 1 goto %s\n", check, labelEnd);
-            generate3AC(node->data.for_loop_block.stmts);
-
-            char* updation = newTemp();
-            if(strcmp(iord, "inc")== 0){
-                printf("%s := %s + %s\n",updation, i->data.identifier, update);
-            }else{
-                printf("%s := %s - %s\n",updation, i->data.identifier, update);
+            ASTNode* init = node->data.for_loop_block.init;
+            genAssign(p, init);
+
+            ASTNode* var = init->data.operator.left;
+            int v = var->data.var.slot;
+            if (v == -1) {
+                emitMessage(p, 0, 0, "Error: Variable %s not declared\n", var->data.var.identifier);
+                break;
             }
-            printf("%s := %s\n", i->data.identifier,updation);
-            printf("goto %s\n", labelStart);
-            printf("%s:\n", labelEnd);
-            return NULL;
+            // an array counter was reported by the initialization
+            if (p->symbols->length[v]) break;
+            // a char loop variable counts in its (otherwise unused) integer value
+            Operand i = p->symbols->is_char[v] ? (Operand){OPND_HIDDEN, v, 0} : varOperand(p, var);
+            if (!node->data.for_loop_block.hoisted) {
+                genCountedLoop(p, node, i);
+                break;
+            }
+
+            // the bounds are tested once: the fast copy of the loop runs when the
+            // counter and the limit lie in the range where every access is in bounds
+            int labelChecked = newLabel(p);
+            int labelDone = newLabel(p);
+            Operand low = {OPND_CONST, node->data.for_loop_block.low, 0};
+            Operand high = {OPND_CONST, node->data.for_loop_block.high, 0};
+            if (node->data.for_loop_block.update->type == NODE_INC) {
+                emitQuad(p, TAC_IF, OPR_LT, noOperand, i, low, labelChecked);
+                Operand limit = genOperand(p, node->data.for_loop_block.limit);
+                emitQuad(p, TAC_IF, OPR_GT, noOperand, limit, high, labelChecked);
+            } else {
+                Operand limit = genOperand(p, node->data.for_loop_block.limit);
+                emitQuad(p, TAC_IF, OPR_LT, noOperand, limit, low, labelChecked);
+                emitQuad(p, TAC_IF, OPR_GT, noOperand, i, high, labelChecked);
+            }
+            p->fastLoops[p->nfastLoops++] = node;
+            genCountedLoop(p, node, i);
+            p->nfastLoops--;
+            emitJump(p, TAC_GOTO, labelDone);
+            emitJump(p, TAC_LABEL, labelChecked);
+            genCountedLoop(p, node, i);
+            emitJump(p, TAC_LABEL, labelDone);
+            break;
         }
 
-        case NODE_STMTS: {
-            // printf("// STATEMENTS BLOCK\n");
+        case NODE_PRINT:
+            emitIO(p, TAC_PRINT, node);
+            break;
+
+        case NODE_SCAN:
+            emitIO(p, TAC_SCAN, node);
+            break;
+
+        case NODE_STMTS:
             for (int i = 0; i < node->data.statements.count; i++) {
-                generate3AC(node->data.statements.statements[i]);
+                gen(p, node->data.statements.statements[i]);
             }
-            return NULL;
-        }
+            break;
 
-        case NODE_PROG: {
-            // printf("// PROGRAM START\n");
-            generate3AC(node->data.program.varDecl);
-            generate3AC(node->data.program.stmtblock);
-            // printf("// PROGRAM END\n");
-            return NULL;
-        }
+        case NODE_PROG:
+            gen(p, node->data.program.varDecl);
+            gen(p, node->data.program.stmtblock);
+            break;
 
         default:
-            // printf("// UNKNOWN NODE TYPE\n");
-            return NULL;
+            break;
     }
 }
 
-// Main function for testing
-// int main() {
-//     // Example: you can create any AST here manually
-//     ASTNode* a = createVariable("a");
-//     ASTNode* b = createVariable("b");
-//     ASTNode* five = createNumberNode(5, 10);
-//     ASTNode* assign = createOperatorNode(NODE_ASSIGN, a, five, "=");
-//     ASTNode* stmts = createStatementsNode();
-//     addStatement(stmts, assign);
-
-//     ASTNode* prog = createProgramNode(NODE_PROG, NULL, stmts);
+// Function to lower a program to three address code, numbering starts fresh for every call
+TACProgram* generate3AC(ASTNode* root, SymbolTable* symbols) {
+    TACProgram* p = calloc(1, sizeof(TACProgram));
+    if (!p) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    p->symbols = symbols;
+    p->nvars = symbols->count;
+    p->names = growArray(p->names, &p->namesCap, p->nvars, sizeof(char*));
+    if (p->nvars) memcpy(p->names, symbols->names, p->nvars * sizeof(char*));
+    p->nnames = p->nvars;
 
-//     printf("=== AST PRINT ===\n");
-//     printAST(prog);
-//     printf("\n=== 3AC OUTPUT ===\n");
-//     generate3AC(prog);
+    gen(p, root);
+    p->unoptimized = p->ncode;
+    return p;
+}
 
-//     freeAST(prog);
-//     return 0;
-// }
+void freeTAC(TACProgram* prog) {
+    if (!prog) return;
+    for (int i = 0; i < prog->nmsgs; i++) free(prog->msgs[i].text);
+    free(prog->msgs);
+    free(prog->io);
+    free(prog->code);
+    free(prog->names);
+    free(prog);
+}
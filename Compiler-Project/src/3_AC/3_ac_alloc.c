@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "3_ac.h"
+#include "cfg.h"
+
+// Register allocation for temps. Liveness is computed over the basic blocks of the
+// quadruple array, every temp gets one live interval and a linear scan maps the
+// intervals onto a fixed set of registers; intervals that do not fit go to spill
+// slots, which are shared the same way. Afterwards temps are numbered
+// t1..t<registers> for registers and the spill slots follow.
+//
+// Program points: quadruple i reads its operands at 2i and writes its result at
+// 2i + 1, so a temp last read by i and one written by i can share a register.
+
+typedef struct {
+    int start, end;     // program points, start > end if the temp never occurs
+} Interval;
+
+static int readsTemp(Operand o) {
+    return o.kind == OPND_TEMP;
+}
+
+static int writesTemp(Quad* q) {
+    return (q->opcode == TAC_COPY || q->opcode == TAC_BINARY || q->opcode == TAC_LOAD) && q->result.kind == OPND_TEMP;
+}
+
+static void extend(Interval* in, int point) {
+    if (point < in->start) in->start = point;
+    if (point > in->end) in->end = point;
+}
+
+// Function to give every temp the interval from its first to its last live point.
+// Only temps read in a block before being written there are live across blocks;
+// they get dense numbers and bit sets for the dataflow, all others are local.
+static Interval* liveIntervals(TACProgram* p) {
+    CFG* cfg = buildCFG(p);
+    BasicBlock* blocks = cfg->blocks;
+    int nblocks = cfg->nblocks;
+    Interval* intervals = allocArray(p->ntemps + 1, sizeof(Interval));
+    for (int t = 0; t <= p->ntemps; t++) intervals[t] = (Interval){1 << 30, -1};
+
+    // global temps, found with a per-block "written here" mark
+    int* globalOf = allocArray(p->ntemps + 1, sizeof(int));
+    int* writtenIn = allocArray(p->ntemps + 1, sizeof(int));
+    int nglobals = 0;
+    for (int b = 0; b < nblocks; b++) {
+        for (int i = blocks[b].first; i <= blocks[b].last; i++) {
+            Quad* q = &p->code[i];
+            Operand args[2] = {q->arg1, q->arg2};
+            for (int k = 0; k < 2; k++) {
+                if (!readsTemp(args[k])) continue;
+                extend(&intervals[args[k].value], 2 * i);
+                int t = args[k].value;
+                if (writtenIn[t] != b + 1 && !globalOf[t]) globalOf[t] = ++nglobals;
+            }
+            if (writesTemp(q)) {
+                extend(&intervals[q->result.value], 2 * i + 1);
+                writtenIn[q->result.value] = b + 1;
+            }
+        }
+    }
+
+    if (nglobals) {
+        // use and kill sets, then live-in = use | (live-out & ~kill) until nothing changes
+        size_t words = (size_t)(nglobals + 63) / 64;
+        unsigned long long* use = allocArray(nblocks * words, sizeof(unsigned long long));
+        unsigned long long* kill = allocArray(nblocks * words, sizeof(unsigned long long));
+        unsigned long long* in = allocArray(nblocks * words, sizeof(unsigned long long));
+        unsigned long long* out = allocArray(nblocks * words, sizeof(unsigned long long));
+        for (int b = 0; b < nblocks; b++) {
+            unsigned long long* u = use + b * words;
+            unsigned long long* k = kill + b * words;
+            for (int i = blocks[b].first; i <= blocks[b].last; i++) {
+                Quad* q = &p->code[i];
+                Operand args[2] = {q->arg1, q->arg2};
+                for (int a = 0; a < 2; a++) {
+                    int g = readsTemp(args[a]) ? globalOf[args[a].value] - 1 : -1;
+                    if (g >= 0 && !(k[g / 64] >> (g % 64) & 1)) u[g / 64] |= 1ULL << (g % 64);
+                }
+                int g = writesTemp(q) ? globalOf[q->result.value] - 1 : -1;
+                if (g >= 0) k[g / 64] |= 1ULL << (g % 64);
+            }
+        }
+        int changed = 1;
+        while (changed) {
+            changed = 0;
+            for (int b = nblocks - 1; b >= 0; b--) {
+                unsigned long long* o = out + b * words;
+                for (int s = 0; s < 2; s++) {
+                    if (blocks[b].succ[s] < 0) continue;
+                    unsigned long long* si = in + blocks[b].succ[s] * words;
+                    for (size_t w = 0; w < words; w++) o[w] |= si[w];
+                }
+                unsigned long long* bi = in + b * words;
+                for (size_t w = 0; w < words; w++) {
+                    unsigned long long v = use[b * words + w] | (o[w] & ~kill[b * words + w]);
+                    if (v != bi[w]) {
+                        bi[w] = v;
+                        changed = 1;
+                    }
+                }
+            }
+        }
+        int* tempOf = allocArray(nglobals, sizeof(int));
+        for (int t = 1; t <= p->ntemps; t++) {
+            if (globalOf[t]) tempOf[globalOf[t] - 1] = t;
+        }
+        for (int b = 0; b < nblocks; b++) {
+            for (size_t w = 0; w < words; w++) {
+                for (unsigned long long bits = in[b * words + w]; bits; bits &= bits - 1)
+                    extend(&intervals[tempOf[w * 64 + __builtin_ctzll(bits)]], 2 * blocks[b].first);
+                for (unsigned long long bits = out[b * words + w]; bits; bits &= bits - 1)
+                    extend(&intervals[tempOf[w * 64 + __builtin_ctzll(bits)]], 2 * blocks[b].last + 1);
+            }
+        }
+        free(tempOf);
+        free(use);
+        free(kill);
+        free(in);
+        free(out);
+    }
+
+    free(globalOf);
+    free(writtenIn);
+    freeCFG(cfg);
+    return intervals;
+}
+
+// Min-heap of (end, location) pairs: the intervals holding a register or a slot
+typedef struct {
+    int* end;
+    int* where;
+    int count;
+} Active;
+
+static void heapSwap(Active* h, int a, int b) {
+    int e = h->end[a], w = h->where[a];
+    h->end[a] = h->end[b];
+    h->where[a] = h->where[b];
+    h->end[b] = e;
+    h->where[b] = w;
+}
+
+static void heapPush(Active* h, int end, int where) {
+    int i = h->count++;
+    h->end[i] = end;
+    h->where[i] = where;
+    while (i > 0 && h->end[(i - 1) / 2] > h->end[i]) {
+        heapSwap(h, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void heapRemove(Active* h, int i) {
+    heapSwap(h, i, --h->count);
+    if (i == h->count) return;
+    // the moved entry may need to go either way
+    while (i > 0 && h->end[(i - 1) / 2] > h->end[i]) {
+        heapSwap(h, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= h->count) break;
+        if (c + 1 < h->count && h->end[c + 1] < h->end[c]) c++;
+        if (h->end[c] >= h->end[i]) break;
+        heapSwap(h, i, c);
+        i = c;
+    }
+}
+
+// A temp and the start of its interval, sorted without reaching the intervals
+typedef struct {
+    int start;
+    int temp;
+} StartOrder;
+
+static int compareStarts(const void* a, const void* b) {
+    const StartOrder* x = a;
+    const StartOrder* y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return x->temp - y->temp;
+}
+
+// Function to sort temps by the start of their intervals, ties by number
+static void sortByStart(Interval* intervals, int* temps, int n) {
+    StartOrder* pairs = allocArray(n, sizeof(StartOrder));
+    for (int k = 0; k < n; k++) pairs[k] = (StartOrder){intervals[temps[k]].start, temps[k]};
+    qsort(pairs, n, sizeof(StartOrder), compareStarts);
+    for (int k = 0; k < n; k++) temps[k] = pairs[k].temp;
+    free(pairs);
+}
+
+// Function to map temps onto nregs registers and as few spill slots as possible
+void allocateRegisters(TACProgram* p, int nregs) {
+    Interval* intervals = liveIntervals(p);
+    int* order = allocArray(p->ntemps + 1, sizeof(int));
+    int n = 0;
+    for (int t = 1; t <= p->ntemps; t++) {
+        if (intervals[t].start <= intervals[t].end) order[n++] = t;
+    }
+    sortByStart(intervals, order, n);
+
+    // registers: free ones on a stack with register 1 on top, taken ones in a heap by end
+    // (the interval to spill is the one ending last, found by a scan of the nregs entries)
+    int* location = allocArray(p->ntemps + 1, sizeof(int));    // register, or -1 - spill slot
+    int* freeRegs = allocArray(nregs, sizeof(int));
+    int nfree = nregs;
+    for (int r = 0; r < nregs; r++) freeRegs[r] = nregs - r;
+    Active regs = {allocArray(nregs, sizeof(int)), allocArray(nregs, sizeof(int)), 0};
+    int* holder = allocArray(nregs + 1, sizeof(int));           // temp in each register
+    int* spilled = allocArray(n + 1, sizeof(int));
+    int nspilled = 0, usedRegs = 0, pressure = 0;
+    Active live = {allocArray(n + 1, sizeof(int)), allocArray(n + 1, sizeof(int)), 0};
+
+    for (int k = 0; k < n; k++) {
+        int t = order[k];
+        int start = intervals[t].start;
+        while (live.count && live.end[0] < start) heapRemove(&live, 0);
+        heapPush(&live, intervals[t].end, t);
+        if (live.count > pressure) pressure = live.count;
+
+        while (regs.count && regs.end[0] < start) {
+            freeRegs[nfree++] = regs.where[0];
+            heapRemove(&regs, 0);
+        }
+        if (nfree) {
+            int r = freeRegs[--nfree];
+            if (r > usedRegs) usedRegs = r;
+            location[t] = r;
+            holder[r] = t;
+            heapPush(&regs, intervals[t].end, r);
+            continue;
+        }
+        int last = 0;
+        for (int i = 1; i < regs.count; i++) {
+            if (regs.end[i] > regs.end[last]) last = i;
+        }
+        if (regs.count && regs.end[last] > intervals[t].end) {
+            // the register goes to the interval that ends sooner
+            int r = regs.where[last];
+            spilled[nspilled++] = holder[r];
+            heapRemove(&regs, last);
+            location[t] = r;
+            holder[r] = t;
+            heapPush(&regs, intervals[t].end, r);
+        } else {
+            spilled[nspilled++] = t;
+        }
+    }
+
+    // spill slots are shared by spilled intervals that do not overlap
+    sortByStart(intervals, spilled, nspilled);
+    int* freeSlots = allocArray(nspilled + 1, sizeof(int));
+    int nfreeSlots = 0, nslots = 0;
+    Active slots = {allocArray(nspilled + 1, sizeof(int)), allocArray(nspilled + 1, sizeof(int)), 0};
+    for (int k = 0; k < nspilled; k++) {
+        int t = spilled[k];
+        while (slots.count && slots.end[0] < intervals[t].start) {
+            freeSlots[nfreeSlots++] = slots.where[0];
+            heapRemove(&slots, 0);
+        }
+        int s = nfreeSlots ? freeSlots[--nfreeSlots] : nslots++;
+        location[t] = -1 - s;
+        heapPush(&slots, intervals[t].end, s);
+    }
+
+    for (int i = 0; i < p->ncode; i++) {
+        Operand* operands[3] = {&p->code[i].result, &p->code[i].arg1, &p->code[i].arg2};
+        for (int k = 0; k < 3; k++) {
+            Operand* o = operands[k];
+            if (o->kind != OPND_TEMP) continue;
+            int at = location[o->value];
+            o->value = at > 0 ? at : usedRegs + 1 + (-1 - at);
+        }
+    }
+    p->unallocated = p->ntemps;
+    p->ntemps = usedRegs + nslots;
+    p->registers = usedRegs;
+    p->spillSlots = nslots;
+    p->pressure = pressure;
+
+    free(intervals);
+    free(order);
+    free(location);
+    free(freeRegs);
+    free(regs.end);
+    free(regs.where);
+    free(holder);
+    free(spilled);
+    free(live.end);
+    free(live.where);
+    free(freeSlots);
+    free(slots.end);
+    free(slots.where);
+}
@@ -0,0 +1,468 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "3_ac.h"
+#include "simulation.h"
+
+// C backend: the optimized three address code becomes the body of main(), one C
+// statement per quadruple. Variables are typed locals, literals are converted to
+// base 10 here, and every print and scan is expanded into straight-line I/O code.
+// Only the runtime helpers the program needs are emitted.
+
+// Runtime pieces, emitted on demand
+enum {
+    NEED_DIVIDE = 1 << 0,
+    NEED_MODULO = 1 << 1,
+    NEED_SCAN_INT = 1 << 2,
+    NEED_SCAN_CHAR = 1 << 3,
+    NEED_EXPECT = 1 << 4,
+    NEED_INDEX = 1 << 5
+};
+
+static const char* divideRuntime =
+    "// division traps on zero and overflow, like the simulator's machine division\n"
+    "static int divide(int a, int b) {\n"
+    "    if (b == 0 || (a == INT_MIN && b == -1)) raise(SIGFPE);\n"
+    "    return a / b;\n"
+    "}\n\n";
+
+static const char* moduloRuntime =
+    "static int modulo(int a, int b) {\n"
+    "    if (b == 0 || (a == INT_MIN && b == -1)) raise(SIGFPE);\n"
+    "    return a % b;\n"
+    "}\n\n";
+
+static const char* scanIntRuntime =
+    "static int scanInt(void) {\n"
+    "    int value = 0, base = 0;\n"
+    "    if (scanf(\"(%d, %d)\", &value, &base) != 2) {\n"
+    "        printf(\"Error: Invalid input format for int. Expected (value, base)\\n\");\n"
+    "        printf(\"%d %d \", value, base);\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    if (base != 2 && base != 8 && base != 10) {\n"
+    "        printf(\"Base encountered: %d, expected values: 2, 8, 10\\n\", base);\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    if (base == 10) return value;\n"
+    "    int temp = value, decimal = 0, multiplier = 1;\n"
+    "    while (value > 0) {\n"
+    "        if (value % 10 >= base) {\n"
+    "            printf(\"Expected digit < base %d, in the integer (%d, %d)\\n\", base, temp, base);\n"
+    "            exit(EXIT_FAILURE);\n"
+    "        }\n"
+    "        decimal += value % 10 * multiplier;\n"
+    "        multiplier *= base;\n"
+    "        value /= 10;\n"
+    "    }\n"
+    "    return decimal;\n"
+    "}\n\n";
+
+// same check as the simulator's scanCharValue, which never accepts its input
+static const char* scanCharRuntime =
+    "static char scanChar(void) {\n"
+    "    char input = 0;\n"
+    "    if (scanf(\" %c\", &input) != 2) {\n"
+    "        printf(\"Error: Invalid input for char\\n\");\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    return input;\n"
+    "}\n\n";
+
+static const char* expectRuntime =
+    "static void expect(char expected) {\n"
+    "    char c = '\\0';\n"
+    "    scanf(\"%c\", &c);\n"
+    "    if (c != expected) {\n"
+    "        fprintf(stderr, \"Scan format mismatch! Expected '%c', but got '%c'.\\n\", expected, c);\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "}\n\n";
+
+static const char* indexRuntime =
+    "static int checkIndex(int index, int length, const char* name) {\n"
+    "    if ((unsigned)index >= (unsigned)length) {\n"
+    "        fprintf(stderr, \"Error: Index %d out of bounds for array '%s' of size %d\\n\", index, name, length);\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    return index;\n"
+    "}\n\n";
+
+// Function to write one character of a C literal, percent signs are doubled for printf formats
+static void putCChar(FILE* out, unsigned char c, char quote, int format) {
+    if (c == quote || c == '\\') fprintf(out, "\\%c", c);
+    else if (c == '\n') fputs("\\n", out);
+    else if (c == '%' && format) fputs("%%", out);
+    else if (c < ' ' || c >= 127) fprintf(out, "\\%03o", c);
+    else fputc(c, out);
+}
+
+static void putCString(FILE* out, const char* s) {
+    fputc('"', out);
+    for (size_t i = 0; s[i] != '\0'; i++) putCChar(out, (unsigned char)s[i], '"', 0);
+    fputc('"', out);
+}
+
+static void putInt(FILE* out, int value) {
+    if (value == INT_MIN) fputs("(-2147483647 - 1)", out);
+    else if (value < 0) fprintf(out, "(%d)", value);
+    else fprintf(out, "%d", value);
+}
+
+static void putOperand(FILE* out, TACProgram* p, Operand o) {
+    int value;
+    char msg[128];
+    switch (o.kind) {
+        case OPND_TEMP:
+            fprintf(out, "t%d", o.value);
+            break;
+        case OPND_VAR:
+            if (o.value < p->nvars) fprintf(out, "v_%s", p->names[o.value]);
+            else fprintf(out, "u%d", o.value);
+            break;
+        case OPND_HIDDEN:
+            fprintf(out, "h_%s", p->names[o.value]);
+            break;
+        case OPND_LITERAL:
+            // invalid literals are only reached after their fatal diagnostic
+            if (!tryConvertToDecimal(o.value, o.base, &value, msg, sizeof(msg))) value = 0;
+            putInt(out, value);
+            break;
+        case OPND_CHAR:
+        case OPND_CONST:
+            putInt(out, o.value);
+            break;
+        default:
+            fputc('0', out);
+            break;
+    }
+}
+
+static const char* cOperator(Operator op) {
+    switch (op) {
+        case OPR_LT: return "<";
+        case OPR_LE: return "<=";
+        case OPR_GT: return ">";
+        case OPR_GE: return ">=";
+        case OPR_EQ: return "==";
+        case OPR_NE: return "!=";
+        default: return NULL;
+    }
+}
+
+// Function to write a diagnostic and exit, the text is formatted at translation time
+static void putFatal(FILE* out, const char* fmt, const char* arg, int to_stderr) {
+    char text[256];
+    snprintf(text, sizeof(text), fmt, arg);
+    fputs("    fputs(", out);
+    putCString(out, text);
+    fprintf(out, ", %s);\n    exit(EXIT_FAILURE);\n", to_stderr ? "stderr" : "stdout");
+}
+
+// Function to expand a print statement into a single printf with a fixed format
+static void genPrint(FILE* out, TACProgram* p, IODesc* d) {
+    const char* format = d->format;
+    const char* error = NULL;
+    const char* errorArg = NULL;
+    ll* arg_node = d->args;
+    int arg = 0;
+    size_t end;
+
+    // the statement stops at the end of the format or at its first bad placeholder
+    for (end = 0; format[end] != '\0'; end++) {
+        if (format[end] != '@') continue;
+        if (!arg_node) {
+            error = "Error: Too few arguments provided for placeholders in print\n";
+            break;
+        }
+        if (arg_node->slot == -1) {
+            error = "Error: Variable %s not declared\n";
+            errorArg = arg_node->string;
+            break;
+        }
+        if (p->symbols->length[arg_node->slot]) {
+            error = "Type Error: Cannot use array '%s' without an index\n";
+            errorArg = arg_node->string;
+            break;
+        }
+        arg_node = arg_node->next;
+        arg++;
+    }
+    if (!error && arg < d->count) error = "Error: Too many arguments passed to print\n";
+
+    fputs("    printf(\"", out);
+    arg_node = d->args;
+    for (size_t i = 0; i < end; i++) {
+        if (format[i] == '@') {
+            fputs(p->symbols->is_char[arg_node->slot] ? "%c" : "%d", out);
+            arg_node = arg_node->next;
+        } else {
+            putCChar(out, (unsigned char)format[i], '"', 1);
+        }
+    }
+    if (!error) fputs("\\n", out);
+    fputc('"', out);
+    arg_node = d->args;
+    for (int i = 0; i < arg; i++, arg_node = arg_node->next) fprintf(out, ", v_%s", p->names[arg_node->slot]);
+    fputs(");\n", out);
+    if (error) putFatal(out, error, errorArg, 1);
+}
+
+// Function to expand a scan statement, format characters are matched one by one.
+// With out == NULL only the runtime helpers it needs are returned.
+static int genScan(FILE* out, TACProgram* p, IODesc* d) {
+    const char* format = d->format;
+    ll* arg_node = d->args;
+    int needs = 0;
+
+    for (int i = 1; format[i] != '"'; i++) {
+        if (format[i] == '@') {
+            if (!arg_node) {
+                if (out) putFatal(out, "Error: Too few arguments provided for placeholders in scan\n", NULL, 1);
+                return needs;
+            }
+            int slot = arg_node->slot;
+            if (slot == -1) {
+                // reported on stdout, the leftover argument then fails the statement
+                if (out) {
+                    char text[256];
+                    snprintf(text, sizeof(text), "Error: Variable %s not declared\n", arg_node->string);
+                    fputs("    fputs(", out);
+                    putCString(out, text);
+                    fputs(", stdout);\n", out);
+                    putFatal(out, "Error: Too many arguments provided for placeholders in scan\n", NULL, 1);
+                }
+                return needs;
+            }
+            if (p->symbols->length[slot]) {
+                if (out) putFatal(out, "Type Error: Cannot use array '%s' without an index\n", arg_node->string, 1);
+                return needs;
+            }
+            int is_char = p->symbols->is_char[slot];
+            if (out) fprintf(out, "    v_%s = %s(); a_%s = 1;\n", p->names[slot], is_char ? "scanChar" : "scanInt", p->names[slot]);
+            needs |= is_char ? NEED_SCAN_CHAR : NEED_SCAN_INT;
+            arg_node = arg_node->next;
+        } else {
+            if (out) {
+                fputs("    expect('", out);
+                putCChar(out, (unsigned char)format[i], '\'', 0);
+                fputs("');\n", out);
+            }
+            needs |= NEED_EXPECT;
+        }
+    }
+    if (arg_node != NULL && out)
+        putFatal(out, "Error: Too many arguments provided for placeholders in scan\n", NULL, 1);
+    return needs;
+}
+
+// Function to write an array element, checked accesses go through checkIndex
+static void putElement(FILE* out, TACProgram* p, Quad* q) {
+    fprintf(out, "v_%s[", p->names[q->label]);
+    if (!q->unchecked) fputs("checkIndex(", out);
+    putOperand(out, p, q->arg1);
+    if (!q->unchecked) fprintf(out, ", %d, \"%s\")", p->symbols->length[q->label], p->names[q->label]);
+    fputc(']', out);
+}
+
+static void genQuad(FILE* out, TACProgram* p, Quad* q) {
+    switch (q->opcode) {
+        case TAC_COPY:
+            fputs("    ", out);
+            putOperand(out, p, q->result);
+            fputs(" = ", out);
+            putOperand(out, p, q->arg1);
+            fputs(";", out);
+            break;
+
+        case TAC_BINARY: {
+            const char* relop = cOperator(q->op);
+            fputs("    ", out);
+            if (q->op == OPR_DIV_ASSIGN) {
+                fputs("if (", out);
+                putOperand(out, p, q->arg2);
+                fputs(" == 0) {\n        fputs(\"Error: Division by zero\\n\", stderr);\n"
+                      "        exit(EXIT_FAILURE);\n    }\n    ", out);
+            }
+            putOperand(out, p, q->result);
+            fputs(" = ", out);
+            if (relop) {
+                putOperand(out, p, q->arg1);
+                fprintf(out, " %s ", relop);
+                putOperand(out, p, q->arg2);
+            } else if (q->op == OPR_DIV || q->op == OPR_DIV_ASSIGN || q->op == OPR_MOD) {
+                fputs(q->op == OPR_MOD ? "modulo(" : "divide(", out);
+                putOperand(out, p, q->arg1);
+                fputs(", ", out);
+                putOperand(out, p, q->arg2);
+                fputs(")", out);
+            } else {
+                // wrapping arithmetic, like the other engines
+                fputs("(int)((unsigned)", out);
+                putOperand(out, p, q->arg1);
+                fprintf(out, " %s (unsigned)", operatorName(q->op));
+                putOperand(out, p, q->arg2);
+                fputs(")", out);
+            }
+            fputs(";", out);
+            break;
+        }
+
+        case TAC_LOAD:
+            fputs("    ", out);
+            putOperand(out, p, q->result);
+            fputs(" = ", out);
+            putElement(out, p, q);
+            fputs(";", out);
+            break;
+
+        case TAC_STORE:
+            fputs("    ", out);
+            putElement(out, p, q);
+            fputs(" = ", out);
+            putOperand(out, p, q->arg2);
+            fputs(";\n", out);
+            return;
+
+        case TAC_IF:
+            fputs("    if (", out);
+            putOperand(out, p, q->arg1);
+            fprintf(out, " %s ", cOperator(q->op));
+            putOperand(out, p, q->arg2);
+            fprintf(out, ") goto L%d;\n", q->label);
+            return;
+
+        case TAC_GOTO:
+            fprintf(out, "    goto L%d;\n", q->label);
+            return;
+
+        case TAC_LABEL:
+            fprintf(out, "L%d: ;\n", q->label);
+            return;
+
+        case TAC_PRINT:
+            genPrint(out, p, &p->io[q->label]);
+            return;
+
+        case TAC_SCAN:
+            genScan(out, p, &p->io[q->label]);
+            return;
+
+        case TAC_MSG: {
+            Message* m = &p->msgs[q->label];
+            fputs("    fputs(", out);
+            putCString(out, m->text);
+            fprintf(out, ", %s);", m->to_stderr ? "stderr" : "stdout");
+            if (m->fatal) fputs("\n    exit(EXIT_FAILURE);", out);
+            break;
+        }
+
+        default:
+            return;
+    }
+    if (q->marks && q->result.kind == OPND_VAR) fprintf(out, " a_%s = 1;", p->names[q->result.value]);
+    fputc('\n', out);
+}
+
+// Function to find the runtime helpers the program uses
+static int runtimeNeeds(TACProgram* p) {
+    int needs = 0;
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_BINARY && (q->op == OPR_DIV || q->op == OPR_DIV_ASSIGN))
+            needs |= NEED_DIVIDE;
+        if (q->opcode == TAC_BINARY && q->op == OPR_MOD)
+            needs |= NEED_MODULO;
+        if ((q->opcode == TAC_LOAD || q->opcode == TAC_STORE) && !q->unchecked)
+            needs |= NEED_INDEX;
+        if (q->opcode == TAC_SCAN) needs |= genScan(NULL, p, &p->io[q->label]);
+    }
+    return needs;
+}
+
+// Function to print an array row of the symbol table like printSymbolTable does
+static void putArrayRow(FILE* out, SymbolTable* symbols, int v, const char* name) {
+    int length = symbols->length[v];
+    int shown = length < SYMBOL_TABLE_ELEMENTS ? length : SYMBOL_TABLE_ELEMENTS;
+    char type[24];
+    snprintf(type, sizeof(type), "%s[%d]", symbols->is_char[v] ? "char" : "int", length);
+    fprintf(out, "    printf(\" %-10s | %-6s | [\");\n", name, type);
+    fprintf(out, "    for (int i = 0; i < %d; i++) {\n        if (i) printf(\", \");\n", shown);
+    if (symbols->is_char[v])
+        fprintf(out, "        if (v_%s[i]) printf(\"'%%c'\", v_%s[i]);\n        else printf(\"'\\\\0'\");\n", name, name);
+    else
+        fprintf(out, "        printf(\"%%d\", v_%s[i]);\n", name);
+    fprintf(out, "    }\n    printf(\"%s] \\n\");\n", shown < length ? ", ..." : "");
+}
+
+// Function to write the program as a standalone C translation unit
+void generateC(TACProgram* p, FILE* out) {
+    SymbolTable* symbols = p->symbols;
+    int needs = runtimeNeeds(p);
+
+    fputs("// Generated by compiler_sim, build with gcc -O2\n", out);
+    fputs("#include <stdio.h>\n#include <stdlib.h>\n", out);
+    if (needs & (NEED_DIVIDE | NEED_MODULO)) fputs("#include <limits.h>\n#include <signal.h>\n", out);
+    fputc('\n', out);
+    if (needs & NEED_DIVIDE) fputs(divideRuntime, out);
+    if (needs & NEED_MODULO) fputs(moduloRuntime, out);
+    if (needs & NEED_SCAN_INT) fputs(scanIntRuntime, out);
+    if (needs & NEED_SCAN_CHAR) fputs(scanCharRuntime, out);
+    if (needs & NEED_EXPECT) fputs(expectRuntime, out);
+    if (needs & NEED_INDEX) fputs(indexRuntime, out);
+
+    fputs("int main(void) {\n", out);
+    for (int v = 0; v < p->nvars; v++) {
+        if (symbols->length[v])
+            fprintf(out, "    static %s v_%s[%d];\n", symbols->is_char[v] ? "char" : "int", p->names[v], symbols->length[v]);
+        else
+            fprintf(out, "    %s v_%s = 0;\n    unsigned char a_%s = 0;\n",
+                    symbols->is_char[v] ? "char" : "int", p->names[v], p->names[v]);
+    }
+    for (int v = p->nvars; v < p->nnames; v++) fprintf(out, "    int u%d = 0;\n", v);
+
+    // char loop variables count in an integer of their own
+    unsigned char* hidden = calloc(p->nvars + 1, 1);
+    if (!hidden) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < p->ncode; i++) {
+        Operand* operands[3] = {&p->code[i].result, &p->code[i].arg1, &p->code[i].arg2};
+        for (int k = 0; k < 3; k++) {
+            Operand* o = operands[k];
+            if (o->kind == OPND_HIDDEN && !hidden[o->value]) {
+                hidden[o->value] = 1;
+                fprintf(out, "    int h_%s = 0;\n", p->names[o->value]);
+            }
+        }
+    }
+    free(hidden);
+    for (int t = 1; t <= p->ntemps; t++) fprintf(out, "    int t%d = 0;\n", t);
+    fputc('\n', out);
+
+    for (int i = 0; i < p->ncode; i++) genQuad(out, p, &p->code[i]);
+
+    // symbol table, in the same layout as printSymbolTable
+    fputs("\n    printf(\"\\nSymbol Table:\\n\");\n", out);
+    fputs("    printf(\"-------------------------------------\\n\");\n", out);
+    fprintf(out, "    printf(\" %-10s | %-6s | %-10s \\n\");\n", "Name", "Type", "Value");
+    fputs("    printf(\"-------------------------------------\\n\");\n", out);
+    for (int v = symbols->count - 1; v >= 0; v--) {
+        const char* name = p->names[v];
+        int is_char = symbols->is_char[v];
+        if (symbols->length[v]) {
+            putArrayRow(out, symbols, v, name);
+            continue;
+        }
+        fprintf(out, "    printf(\" %-10s | %-6s | \");\n", name, is_char ? "char" : "int");
+        if (is_char)
+            fprintf(out, "    if (a_%s) printf(\"'%%c'      \\n\", v_%s);\n", name, name);
+        else
+            fprintf(out, "    if (a_%s) printf(\"(%%d, 10) \\n\", v_%s);\n", name, name);
+        fputs("    else printf(\"(unassigned) \\n\");\n", out);
+    }
+    fputs("    printf(\"-------------------------------------\\n\");\n", out);
+    fputs("    return 0;\n}\n", out);
+}
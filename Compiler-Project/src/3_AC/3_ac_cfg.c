@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "alloc.h"
+#include "cfg.h"
+
+// Function to number the reachable blocks in reverse postorder, with an explicit stack
+static void orderBlocks(CFG* cfg) {
+    int n = cfg->nblocks;
+    int* stack = allocArray(n, sizeof(int));
+    int* next = allocArray(n, sizeof(int));     // successor to visit next
+    unsigned char* seen = allocArray(n, 1);
+    int* post = allocArray(n, sizeof(int));
+    int npost = 0, top = 0;
+    if (n) {
+        stack[top++] = 0;
+        seen[0] = 1;
+    }
+    while (top) {
+        int b = stack[top - 1];
+        if (next[b] < 2) {
+            int s = cfg->blocks[b].succ[next[b]++];
+            if (s >= 0 && !seen[s]) {
+                seen[s] = 1;
+                stack[top++] = s;
+            }
+            continue;
+        }
+        post[npost++] = b;
+        top--;
+    }
+    cfg->order = allocArray(npost, sizeof(int));
+    cfg->nreachable = npost;
+    for (int b = 0; b < n; b++) cfg->blocks[b].rpo = -1;
+    for (int i = 0; i < npost; i++) {
+        int b = post[npost - 1 - i];
+        cfg->order[i] = b;
+        cfg->blocks[b].rpo = i;
+    }
+    free(stack);
+    free(next);
+    free(seen);
+    free(post);
+}
+
+static int intersect(CFG* cfg, int a, int b) {
+    while (a != b) {
+        while (cfg->blocks[a].rpo > cfg->blocks[b].rpo) a = cfg->blocks[a].idom;
+        while (cfg->blocks[b].rpo > cfg->blocks[a].rpo) b = cfg->blocks[b].idom;
+    }
+    return a;
+}
+
+// Immediate dominators by iteration over the reverse postorder (Cooper, Harvey and Kennedy).
+// The entry is its own dominator while this runs.
+static void findDominators(CFG* cfg) {
+    for (int b = 0; b < cfg->nblocks; b++) cfg->blocks[b].idom = -1;
+    if (!cfg->nreachable) return;
+    cfg->blocks[0].idom = 0;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < cfg->nreachable; i++) {
+            BasicBlock* block = &cfg->blocks[cfg->order[i]];
+            int idom = -1;
+            for (int k = 0; k < block->npreds; k++) {
+                int pred = block->preds[k];
+                if (cfg->blocks[pred].idom == -1) continue;
+                idom = idom == -1 ? pred : intersect(cfg, pred, idom);
+            }
+            if (idom != block->idom) {
+                block->idom = idom;
+                changed = 1;
+            }
+        }
+    }
+    cfg->blocks[0].idom = -1;
+}
+
+CFG* buildCFG(TACProgram* p) {
+    CFG* cfg = allocArray(1, sizeof(CFG));
+    int* blockOfLabel = allocArray(p->nlabels + 1, sizeof(int));
+    BasicBlock* blocks = allocArray(p->ncode + 1, sizeof(BasicBlock));
+    cfg->blockOf = allocArray(p->ncode, sizeof(int));
+    int n = 0;
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        int leader = i == 0 || q->opcode == TAC_LABEL || p->code[i - 1].opcode == TAC_IF || p->code[i - 1].opcode == TAC_GOTO;
+        if (leader && !(q->opcode == TAC_LABEL && i > 0 && p->code[i - 1].opcode == TAC_LABEL)) blocks[n++].first = i;
+        blocks[n - 1].last = i;
+        cfg->blockOf[i] = n - 1;
+        if (q->opcode == TAC_LABEL) blockOfLabel[q->label] = n - 1;
+    }
+
+    int edges = 0;
+    for (int b = 0; b < n; b++) {
+        Quad* q = &p->code[blocks[b].last];
+        int next = b + 1 < n ? b + 1 : -1;
+        blocks[b].succ[0] = q->opcode == TAC_GOTO ? -1 : next;
+        blocks[b].succ[1] = q->opcode == TAC_GOTO || q->opcode == TAC_IF ? blockOfLabel[q->label] : -1;
+        // a jump to the next block is one edge
+        if (blocks[b].succ[1] == blocks[b].succ[0]) blocks[b].succ[1] = -1;
+        for (int s = 0; s < 2; s++) {
+            if (blocks[b].succ[s] >= 0) {
+                blocks[blocks[b].succ[s]].npreds++;
+                edges++;
+            }
+        }
+    }
+    cfg->predStore = allocArray(edges, sizeof(int));
+    int at = 0;
+    for (int b = 0; b < n; b++) {
+        blocks[b].preds = cfg->predStore + at;
+        at += blocks[b].npreds;
+        blocks[b].npreds = 0;
+    }
+    for (int b = 0; b < n; b++) {
+        for (int s = 0; s < 2; s++) {
+            int succ = blocks[b].succ[s];
+            if (succ >= 0) blocks[succ].preds[blocks[succ].npreds++] = b;
+        }
+    }
+
+    cfg->blocks = blocks;
+    cfg->nblocks = n;
+    free(blockOfLabel);
+    orderBlocks(cfg);
+    findDominators(cfg);
+    return cfg;
+}
+
+void freeCFG(CFG* cfg) {
+    if (!cfg) return;
+    free(cfg->blocks);
+    free(cfg->blockOf);
+    free(cfg->order);
+    free(cfg->predStore);
+    free(cfg);
+}
+
+int dominates(CFG* cfg, int a, int b) {
+    if (cfg->blocks[b].rpo < 0) return 0;
+    while (b != -1 && b != a) b = cfg->blocks[b].idom;
+    return b == a;
+}
+
+// Larger loops first, so a loop comes before the loops nested in it
+static int compareLoops(const void* a, const void* b) {
+    const Loop* x = a;
+    const Loop* y = b;
+    if (x->nblocks != y->nblocks) return x->nblocks > y->nblocks ? -1 : 1;
+    return x->header - y->header;
+}
+
+static int compareInts(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+int findLoops(CFG* cfg, Loop** loopsOut) {
+    int n = cfg->nblocks;
+    Loop* loops = NULL;
+    int nloops = 0;
+    int* loopOf = allocArray(n, sizeof(int));   // loop of each header, + 1
+    int* mark = allocArray(n, sizeof(int));     // loop + 1 of the last walk that reached the block
+    int* work = allocArray(n, sizeof(int));
+
+    for (int i = 0; i < cfg->nreachable; i++) {
+        int h = cfg->order[i];
+        BasicBlock* header = &cfg->blocks[h];
+        for (int k = 0; k < header->npreds; k++) {
+            int tail = header->preds[k];
+            if (!dominates(cfg, h, tail)) continue;
+            if (!loopOf[h]) {
+                loops = realloc(loops, (nloops + 1) * sizeof(Loop));
+                if (!loops) {
+                    fprintf(stderr, "Memory allocation failed\n");
+                    exit(EXIT_FAILURE);
+                }
+                loops[nloops] = (Loop){h, allocArray(n, sizeof(int)), 1, -1};
+                loops[nloops].blocks[0] = h;
+                loopOf[h] = ++nloops;
+                mark[h] = nloops;
+            }
+            // walk back from the tail of the back edge, the header stops the walk
+            Loop* loop = &loops[loopOf[h] - 1];
+            int top = 0;
+            if (mark[tail] != loopOf[h]) {
+                mark[tail] = loopOf[h];
+                loop->blocks[loop->nblocks++] = tail;
+                work[top++] = tail;
+            }
+            while (top) {
+                BasicBlock* block = &cfg->blocks[work[--top]];
+                for (int j = 0; j < block->npreds; j++) {
+                    int pred = block->preds[j];
+                    if (mark[pred] == loopOf[h] || cfg->blocks[pred].rpo < 0) continue;
+                    mark[pred] = loopOf[h];
+                    loop->blocks[loop->nblocks++] = pred;
+                    work[top++] = pred;
+                }
+            }
+        }
+    }
+
+    // outer loops first, then the innermost loop seen so far around each header is its parent
+    Loop* sorted = allocArray(nloops, sizeof(Loop));
+    for (int l = 0; l < nloops; l++) sorted[l] = loops[l];
+    qsort(sorted, nloops, sizeof(Loop), compareLoops);
+    int* innermost = mark;
+    for (int b = 0; b < n; b++) innermost[b] = -1;
+    for (int l = 0; l < nloops; l++) {
+        Loop* loop = &sorted[l];
+        qsort(loop->blocks, loop->nblocks, sizeof(int), compareInts);
+        loop->parent = innermost[loop->header];
+        for (int k = 0; k < loop->nblocks; k++) innermost[loop->blocks[k]] = l;
+    }
+
+    free(loops);
+    free(loopOf);
+    free(mark);
+    free(work);
+    *loopsOut = sorted;
+    return nloops;
+}
+
+void freeLoops(Loop* loops, int nloops) {
+    for (int l = 0; l < nloops; l++) free(loops[l].blocks);
+    free(loops);
+}
+
+int loopContains(Loop* loop, int block) {
+    return bsearch(&block, loop->blocks, loop->nblocks, sizeof(int), compareInts) != NULL;
+}
+
+int hasPreheaderSpot(CFG* cfg, Loop* loop) {
+    int before = loop->header - 1;
+    return before < 0 || cfg->blocks[before].succ[0] != loop->header || !loopContains(loop, before);
+}
+
+void enterThroughPreheaders(TACProgram* p, CFG* cfg, Loop* loops, int nloops, const int* wanted, int* label) {
+    int* headerOf = allocArray(cfg->nblocks, sizeof(int));
+    int* loopOfLabel = allocArray(p->nlabels + 1, sizeof(int));
+    for (int l = 0; l < nloops; l++) {
+        label[l] = 0;
+        if (wanted[l]) headerOf[loops[l].header] = l + 1;
+    }
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_LABEL) loopOfLabel[q->label] = headerOf[cfg->blockOf[i]];
+    }
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode != TAC_IF && q->opcode != TAC_GOTO) continue;
+        int l = loopOfLabel[q->label] - 1;
+        if (l < 0 || loopContains(&loops[l], cfg->blockOf[i])) continue;
+        if (!label[l]) label[l] = ++p->nlabels;
+        q->label = label[l];
+    }
+    free(headerOf);
+    free(loopOfLabel);
+}
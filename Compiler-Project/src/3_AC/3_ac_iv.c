@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "3_ac.h"
+#include "cfg.h"
+#include "fold.h"
+#include "simulation.h"
+
+// Strength reduction of induction variables.
+//
+// A basic induction variable of a loop is an int variable or loop counter that the
+// loop writes once per iteration, with i := i + c or i := i - c where c is a constant
+// or a name the loop does not write: the increment of a lowered for loop. A
+// multiplication t := i * k, with k such a constant or name, that runs once per
+// iteration always equals a running value that starts as i * k in the preheader and
+// moves by c * k right after the increment. The multiplication is removed and t
+// becomes the running value. Multiplications of the same variable by the same
+// factor share one running value, the temps of the others are renamed to it.
+//
+// Running values are temps with more than one definition, so the pass runs after
+// the passes that expect temps to be defined once.
+
+typedef struct {
+    int pos;            // quadruple the new one goes next to
+    int after;          // 0: in front of it, 1: behind it
+    int seq;
+    Quad quad;
+} Insert;
+
+typedef struct {
+    Insert* items;
+    int count;
+    int cap;
+} Inserts;
+
+// Running value of one induction variable and factor in one loop
+typedef struct {
+    Operand iv, factor;
+    int temp;
+    int writer;         // increment of the induction variable
+} Family;
+
+static int intConstant(Operand o, int* value) {
+    char msg[128];
+    if (o.kind == OPND_CONST) {
+        *value = o.value;
+        return 1;
+    }
+    return o.kind == OPND_LITERAL && tryConvertToDecimal(o.value, o.base, value, msg, sizeof(msg));
+}
+
+static int sameOperand(Operand a, Operand b) {
+    return a.kind == b.kind && a.value == b.value && a.base == b.base;
+}
+
+// Index of an int variable or loop counter in the write counts, -1 for other operands
+static int ivName(TACProgram* p, Operand o) {
+    switch (o.kind) {
+        case OPND_VAR: return o.value < p->nvars && !p->symbols->is_char[o.value] ? o.value : -1;
+        case OPND_HIDDEN: return p->nvars + o.value;
+        default: return -1;
+    }
+}
+
+// Writes of the int variables and loop counters in the loop being looked at
+typedef struct {
+    int* stamp;         // loop + 1 that the entries belong to
+    int* count;
+    int* writer;        // last quadruple writing the name
+} Writes;
+
+static void countWrite(Writes* w, int l, int name, int i) {
+    if (name < 0) return;
+    if (w->stamp[name] != l + 1) {
+        w->stamp[name] = l + 1;
+        w->count[name] = 0;
+    }
+    w->count[name]++;
+    w->writer[name] = i;
+}
+
+// Function to tell whether an operand is a constant or a name that loop l does not write
+static int isInvariant(TACProgram* p, Writes* w, int l, Operand o) {
+    int value;
+    if (intConstant(o, &value)) return 1;
+    int name = ivName(p, o);
+    return name >= 0 && w->stamp[name] != l + 1;
+}
+
+// Function to tell whether the reads of a temp computed by quadruple def all come
+// later in the same iteration of the loop, before the increment at quadruple inc
+static int readsOneIteration(CFG* cfg, Loop* loop, int* reads, int nreads, int def, int inc) {
+    int b = cfg->blockOf[def];
+    int latch = cfg->blockOf[inc];
+    // after the increment the iteration ends
+    for (int s = 0; s < 2; s++) {
+        if (cfg->blocks[latch].succ[s] >= 0 && cfg->blocks[latch].succ[s] != loop->header) return 0;
+    }
+    for (int k = 0; k < nreads; k++) {
+        int u = reads[k];
+        int ub = cfg->blockOf[u];
+        if (!loopContains(loop, ub) || !dominates(cfg, b, ub) || (ub == b && u <= def)) return 0;
+        if (ub == latch && u > inc && !(b == latch && def > inc)) return 0;
+    }
+    return 1;
+}
+
+static void addInsert(Inserts* list, int pos, int after, Quad quad) {
+    list->items = growArray(list->items, &list->cap, list->count + 1, sizeof(Insert));
+    list->items[list->count] = (Insert){pos, after, list->count, quad};
+    list->count++;
+}
+
+static int compareInserts(const void* a, const void* b) {
+    const Insert* x = a;
+    const Insert* y = b;
+    if (x->pos != y->pos) return x->pos - y->pos;
+    if (x->after != y->after) return x->after - y->after;
+    return x->seq - y->seq;
+}
+
+// Function to reduce the multiplications by induction variables, returns 1 if the code changed
+int reduceInductionVariables(TACProgram* p) {
+    CFG* cfg = buildCFG(p);
+    Loop* loops;
+    int nloops = findLoops(cfg, &loops);
+    int nnames = 2 * p->nvars;
+
+    // the quadruples reading every temp, and how often every temp is defined
+    int* useStart = allocArray(p->ntemps + 2, sizeof(int));
+    int* defs = allocArray(p->ntemps + 1, sizeof(int));
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->arg1.kind == OPND_TEMP) useStart[q->arg1.value + 1]++;
+        if (q->arg2.kind == OPND_TEMP) useStart[q->arg2.value + 1]++;
+        if ((q->opcode == TAC_COPY || q->opcode == TAC_BINARY || q->opcode == TAC_LOAD) && q->result.kind == OPND_TEMP)
+            defs[q->result.value]++;
+    }
+    for (int t = 1; t <= p->ntemps + 1; t++) useStart[t] += useStart[t - 1];
+    int* useList = allocArray(useStart[p->ntemps + 1], sizeof(int));
+    int* fill = allocArray(p->ntemps + 1, sizeof(int));
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->arg1.kind == OPND_TEMP) useList[useStart[q->arg1.value] + fill[q->arg1.value]++] = i;
+        if (q->arg2.kind == OPND_TEMP) useList[useStart[q->arg2.value] + fill[q->arg2.value]++] = i;
+    }
+    free(fill);
+
+    int* innermost = allocArray(cfg->nblocks, sizeof(int));
+    for (int b = 0; b < cfg->nblocks; b++) innermost[b] = -1;
+    for (int l = 0; l < nloops; l++) {
+        for (int k = 0; k < loops[l].nblocks; k++) innermost[loops[l].blocks[k]] = l;
+    }
+    Writes w = {allocArray(nnames, sizeof(int)), allocArray(nnames, sizeof(int)), allocArray(nnames, sizeof(int))};
+    unsigned char* everyIteration = allocArray(cfg->nblocks, 1);
+    int* renamed = allocArray(p->ntemps + 1, sizeof(int));
+    unsigned char* removed = allocArray(p->ncode, 1);
+    int* wanted = allocArray(nloops, sizeof(int));
+    Family* families = NULL;
+    int nfamilies = 0, familiesCap = 0;
+    Inserts inserts = {NULL, 0, 0};
+    int reduced = 0, steps = 0, reducedLoops = 0, everyIterationMuls = 0;
+
+    for (int l = 0; l < nloops; l++) {
+        Loop* loop = &loops[l];
+        if (!hasPreheaderSpot(cfg, loop)) continue;
+
+        // blocks of this loop (not of a loop inside it) that run on every iteration
+        BasicBlock* header = &cfg->blocks[loop->header];
+        for (int k = 0; k < loop->nblocks; k++) {
+            int b = loop->blocks[k];
+            everyIteration[b] = innermost[b] == l;
+            for (int j = 0; j < header->npreds && everyIteration[b]; j++) {
+                int latch = header->preds[j];
+                if (loopContains(loop, latch)) everyIteration[b] = dominates(cfg, b, latch);
+            }
+        }
+        for (int k = 0; k < loop->nblocks; k++) {
+            BasicBlock* block = &cfg->blocks[loop->blocks[k]];
+            for (int i = block->first; i <= block->last; i++) {
+                Quad* q = &p->code[i];
+                if (q->opcode == TAC_COPY || q->opcode == TAC_BINARY || q->opcode == TAC_LOAD) countWrite(&w, l, ivName(p, q->result), i);
+                if (q->opcode != TAC_SCAN) continue;
+                for (ll* arg = p->io[q->label].args; arg; arg = arg->next) {
+                    if (arg->slot >= 0) countWrite(&w, l, ivName(p, (Operand){OPND_VAR, arg->slot, 0}), i);
+                }
+            }
+        }
+
+        // running values start at multiplications that run on every iteration, the
+        // others can use a running value that exists
+        int firstFamily = nfamilies, loopReduced = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int k = 0; k < loop->nblocks; k++) {
+                int b = loop->blocks[k];
+                if (everyIteration[b] == pass) continue;
+                for (int i = cfg->blocks[b].first; i <= cfg->blocks[b].last; i++) {
+                    Quad* q = &p->code[i];
+                    if (q->opcode != TAC_BINARY || q->op != OPR_MUL || q->result.kind != OPND_TEMP || removed[i]) continue;
+                    int t = q->result.value;
+                    if (defs[t] != 1) continue;
+                    for (int side = 0; side < 2; side++) {
+                        Operand iv = side ? q->arg2 : q->arg1;
+                        Operand factor = side ? q->arg1 : q->arg2;
+                        int v = ivName(p, iv);
+                        if (v < 0 || w.stamp[v] != l + 1 || w.count[v] != 1 || !isInvariant(p, &w, l, factor)) continue;
+                        int at = w.writer[v];
+                        Quad* inc = &p->code[at];
+                        if (inc->opcode != TAC_BINARY || (inc->op != OPR_ADD && inc->op != OPR_SUB)) continue;
+                        if (!sameOperand(inc->result, iv) || !sameOperand(inc->arg1, iv) || !isInvariant(p, &w, l, inc->arg2)) continue;
+                        if (!everyIteration[cfg->blockOf[at]]) continue;
+                        if (!readsOneIteration(cfg, loop, useList + useStart[t], useStart[t + 1] - useStart[t], i, at)) continue;
+
+                        int f = firstFamily;
+                        while (f < nfamilies && !(sameOperand(families[f].iv, iv) && sameOperand(families[f].factor, factor))) f++;
+                        if (f == nfamilies && pass) continue;
+                        if (f == nfamilies) {
+                            families = growArray(families, &familiesCap, nfamilies + 1, sizeof(Family));
+                            families[nfamilies++] = (Family){iv, factor, t, at};
+                        }
+                        renamed[t] = families[f].temp;
+                        removed[i] = 1;
+                        loopReduced++;
+                        if (!pass) everyIterationMuls++;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!loopReduced) continue;
+
+        // running values start in the preheader and move with their variable
+        wanted[l] = 1;
+        reduced += loopReduced;
+        steps += nfamilies - firstFamily;
+        reducedLoops++;
+        int at = cfg->blocks[loop->header].first;
+        for (int f = firstFamily; f < nfamilies; f++) {
+            Family* family = &families[f];
+            Quad* inc = &p->code[family->writer];
+            Operand running = {OPND_TEMP, family->temp, 0};
+            addInsert(&inserts, at, 0, (Quad){TAC_BINARY, OPR_MUL, running, family->iv, family->factor, 0, 0, 0});
+            int c, k, step;
+            Operand by;
+            if (intConstant(inc->arg2, &c) && intConstant(family->factor, &k) && foldBinaryOperator(OPR_MUL, c, k, &step)) {
+                by = (Operand){OPND_LITERAL, step, 10};
+            } else if (intConstant(inc->arg2, &c) && c == 1) {
+                by = family->factor;
+            } else {
+                by = (Operand){OPND_TEMP, ++p->ntemps, 0};
+                addInsert(&inserts, at, 0, (Quad){TAC_BINARY, OPR_MUL, by, inc->arg2, family->factor, 0, 0, 0});
+            }
+            addInsert(&inserts, family->writer, 1, (Quad){TAC_BINARY, inc->op, running, running, by, 0, 0, 0});
+        }
+    }
+
+    if (reduced) {
+        int* preheader = allocArray(nloops, sizeof(int));
+        enterThroughPreheaders(p, cfg, loops, nloops, wanted, preheader);
+        for (int l = 0; l < nloops; l++) {
+            if (preheader[l]) addInsert(&inserts, cfg->blocks[loops[l].header].first, 0, (Quad){TAC_LABEL, 0, {0}, {0}, {0}, preheader[l], 0, 0});
+        }
+        // the label goes in front of the preheader code
+        for (int k = 0; k < inserts.count; k++) {
+            if (inserts.items[k].quad.opcode == TAC_LABEL) inserts.items[k].seq = -1;
+        }
+        qsort(inserts.items, inserts.count, sizeof(Insert), compareInserts);
+
+        int cap = p->ncode + inserts.count;
+        Quad* code = allocArray(cap, sizeof(Quad));
+        int n = 0, next = 0;
+        for (int i = 0; i < p->ncode; i++) {
+            while (next < inserts.count && inserts.items[next].pos == i && !inserts.items[next].after) code[n++] = inserts.items[next++].quad;
+            if (!removed[i]) {
+                Quad q = p->code[i];
+                if (q.arg1.kind == OPND_TEMP && renamed[q.arg1.value]) q.arg1.value = renamed[q.arg1.value];
+                if (q.arg2.kind == OPND_TEMP && renamed[q.arg2.value]) q.arg2.value = renamed[q.arg2.value];
+                code[n++] = q;
+            }
+            while (next < inserts.count && inserts.items[next].pos == i) code[n++] = inserts.items[next++].quad;
+        }
+        free(p->code);
+        p->code = code;
+        p->ncode = n;
+        p->cap = cap;
+        free(preheader);
+    }
+    p->reducedMuls = reduced;
+    p->reducedLoops = reducedLoops;
+    p->runningAdds = steps;
+    p->mulsPerIteration = everyIterationMuls;
+
+    free(useStart);
+    free(useList);
+    free(defs);
+    free(innermost);
+    free(w.stamp);
+    free(w.count);
+    free(w.writer);
+    free(everyIteration);
+    free(renamed);
+    free(removed);
+    free(wanted);
+    free(families);
+    free(inserts.items);
+    freeLoops(loops, nloops);
+    freeCFG(cfg);
+    return reduced > 0;
+}
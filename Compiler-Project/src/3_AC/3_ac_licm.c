@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "3_ac.h"
+#include "cfg.h"
+#include "fold.h"
+#include "simulation.h"
+
+// Loop-invariant code motion over the natural loops of the quadruple array.
+//
+// A computation is invariant in a loop if it cannot fail and every operand is a
+// constant, a variable or loop counter the loop never writes, or a temp computed
+// outside the loop or by another invariant computation. Temps are defined once,
+// so an invariant computation gives the same value on every iteration and can run
+// once before the loop, even if the loop body would not have reached it.
+//
+// Every loop that gets code moved out of it gets a preheader: a new label in front
+// of the header, followed by the moved quadruples. Jumps into the header from
+// outside the loop go to the preheader instead, the code before the header falls
+// through into it. A computation leaves the outermost loop it is invariant in.
+
+typedef struct {
+    Loop* loops;
+    int nloops;
+    int* defOf;         // temp -> defining quadruple, -1 if none or more than one
+    int* claim;         // quadruple -> loop it leaves, -1 if it stays
+    int* hoisted;       // loop -> quadruples leaving it, in the order they were found
+    int* hoistStart;
+    int* nhoisted;
+    int* inLoop;        // block -> stamp of the loop being looked at
+    int* written;       // name -> stamp of the loop being looked at if the loop writes it
+} LICM;
+
+static int intConstant(Operand o, int* value) {
+    char msg[128];
+    if (o.kind == OPND_CONST) {
+        *value = o.value;
+        return 1;
+    }
+    return o.kind == OPND_LITERAL && tryConvertToDecimal(o.value, o.base, value, msg, sizeof(msg));
+}
+
+// Index of a variable or loop counter in the written stamps, -1 for other operands
+static int writtenName(TACProgram* p, Operand o) {
+    switch (o.kind) {
+        case OPND_VAR: return o.value;
+        case OPND_HIDDEN: return p->nnames + o.value;
+        default: return -1;
+    }
+}
+
+// Function to tell whether a quadruple can be moved at all: it computes a temp that
+// is defined only here and no operand read or operation can fail
+static int isMovable(TACProgram* p, LICM* m, int i) {
+    Quad* q = &p->code[i];
+    if (q->opcode != TAC_COPY && q->opcode != TAC_BINARY) return 0;
+    if (q->result.kind != OPND_TEMP || m->defOf[q->result.value] != i) return 0;
+    int arithmetic = q->opcode == TAC_BINARY;
+    Operand args[2] = {q->arg1, q->arg2};
+    for (int k = 0; k < 2; k++) {
+        int value;
+        switch (args[k].kind) {
+            case OPND_VAR:
+                if (args[k].value >= p->nvars || p->symbols->is_char[args[k].value]) return 0;
+                break;
+            case OPND_LITERAL:
+                if (!intConstant(args[k], &value)) return 0;
+                break;
+            case OPND_CHAR:
+                if (arithmetic) return 0;
+                break;
+            default:
+                break;
+        }
+    }
+    if (arithmetic && q->op == OPR_DIV_ASSIGN) return 0;
+    if (arithmetic && (q->op == OPR_DIV || q->op == OPR_MOD)) {
+        int divisor;
+        return intConstant(q->arg2, &divisor) && divisor != 0 && divisor != -1;
+    }
+    return 1;
+}
+
+// Function to tell whether an operand has the same value on every iteration of loop l
+static int isInvariant(TACProgram* p, CFG* cfg, LICM* m, int l, Operand o) {
+    if (o.kind == OPND_TEMP) {
+        int def = m->defOf[o.value];
+        if (def < 0) return 0;
+        // computed before the loop, or moved out of it or out of a loop around it
+        if (m->inLoop[cfg->blockOf[def]] != l + 1) return dominates(cfg, cfg->blockOf[def], m->loops[l].header);
+        for (int c = m->claim[def]; c >= 0; c = m->loops[c].parent) {
+            if (c == l) return 1;
+        }
+        return 0;
+    }
+    int name = writtenName(p, o);
+    return name < 0 || m->written[name] != l + 1;
+}
+
+// Function to find the quadruples that can leave loop l, returns how many
+static int findInvariants(TACProgram* p, CFG* cfg, LICM* m, int l) {
+    Loop* loop = &m->loops[l];
+    for (int k = 0; k < loop->nblocks; k++) m->inLoop[loop->blocks[k]] = l + 1;
+    for (int k = 0; k < loop->nblocks; k++) {
+        BasicBlock* block = &cfg->blocks[loop->blocks[k]];
+        for (int i = block->first; i <= block->last; i++) {
+            Quad* q = &p->code[i];
+            if (q->opcode == TAC_COPY || q->opcode == TAC_BINARY || q->opcode == TAC_LOAD) {
+                int name = writtenName(p, q->result);
+                if (name >= 0) m->written[name] = l + 1;
+            }
+            if (q->opcode == TAC_SCAN) {
+                for (ll* arg = p->io[q->label].args; arg; arg = arg->next) {
+                    if (arg->slot >= 0) m->written[arg->slot] = l + 1;
+                }
+            }
+        }
+    }
+
+    // operands can be computed by quadruples found later in the loop, so repeat
+    int found = 0, changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int k = 0; k < loop->nblocks; k++) {
+            BasicBlock* block = &cfg->blocks[loop->blocks[k]];
+            for (int i = block->first; i <= block->last; i++) {
+                Quad* q = &p->code[i];
+                if (m->claim[i] >= 0 || !isMovable(p, m, i)) continue;
+                if (!isInvariant(p, cfg, m, l, q->arg1) || !isInvariant(p, cfg, m, l, q->arg2)) continue;
+                m->claim[i] = l;
+                m->hoisted[m->hoistStart[l] + m->nhoisted[l]++] = i;
+                found++;
+                changed = 1;
+            }
+        }
+    }
+    return found;
+}
+
+// Function to move loop-invariant computations in front of their loops, returns 1 if the code changed
+int hoistLoopInvariants(TACProgram* p) {
+    CFG* cfg = buildCFG(p);
+    LICM m;
+    m.nloops = findLoops(cfg, &m.loops);
+    if (!m.nloops) {
+        freeCFG(cfg);
+        free(m.loops);
+        return 0;
+    }
+    m.defOf = allocArray(p->ntemps + 1, sizeof(int));
+    memset(m.defOf, -1, (p->ntemps + 1) * sizeof(int));
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if ((q->opcode == TAC_COPY || q->opcode == TAC_BINARY || q->opcode == TAC_LOAD) && q->result.kind == OPND_TEMP) {
+            int t = q->result.value;
+            m.defOf[t] = m.defOf[t] == -1 ? i : -2;
+        }
+    }
+    m.claim = allocArray(p->ncode, sizeof(int));
+    memset(m.claim, -1, p->ncode * sizeof(int));
+    m.hoistStart = allocArray(m.nloops, sizeof(int));
+    m.nhoisted = allocArray(m.nloops, sizeof(int));
+    int total = 0;
+    for (int l = 0; l < m.nloops; l++) {
+        m.hoistStart[l] = total;
+        for (int k = 0; k < m.loops[l].nblocks; k++) {
+            BasicBlock* block = &cfg->blocks[m.loops[l].blocks[k]];
+            total += block->last - block->first + 1;
+        }
+    }
+    m.hoisted = allocArray(total, sizeof(int));
+    m.inLoop = allocArray(cfg->nblocks, sizeof(int));
+    m.written = allocArray(p->nnames + p->nvars, sizeof(int));
+
+    // outer loops first, so a computation leaves every loop it is invariant in
+    int moved = 0;
+    for (int l = 0; l < m.nloops; l++) {
+        if (!hasPreheaderSpot(cfg, &m.loops[l])) continue;
+        moved += findInvariants(p, cfg, &m, l);
+    }
+
+    if (moved) {
+        // jumps from outside a loop into its header enter through the preheader
+        int* preheader = allocArray(m.nloops, sizeof(int));
+        enterThroughPreheaders(p, cfg, m.loops, m.nloops, m.nhoisted, preheader);
+        int* headerOf = allocArray(cfg->nblocks, sizeof(int));
+        for (int l = 0; l < m.nloops; l++) {
+            if (m.nhoisted[l]) headerOf[m.loops[l].header] = l + 1;
+        }
+
+        int cap = p->ncode + m.nloops;
+        Quad* code = allocArray(cap, sizeof(Quad));
+        int n = 0;
+        for (int i = 0; i < p->ncode; i++) {
+            int b = cfg->blockOf[i];
+            int l = headerOf[b] - 1;
+            if (l >= 0 && i == cfg->blocks[b].first) {
+                if (preheader[l]) code[n++] = (Quad){TAC_LABEL, 0, {0}, {0}, {0}, preheader[l], 0, 0};
+                for (int k = 0; k < m.nhoisted[l]; k++) code[n++] = p->code[m.hoisted[m.hoistStart[l] + k]];
+            }
+            if (m.claim[i] < 0) code[n++] = p->code[i];
+        }
+        free(p->code);
+        p->code = code;
+        p->ncode = n;
+        p->cap = cap;
+        free(headerOf);
+        free(preheader);
+    }
+
+    free(m.defOf);
+    free(m.claim);
+    free(m.hoisted);
+    free(m.hoistStart);
+    free(m.nhoisted);
+    free(m.inLoop);
+    free(m.written);
+    freeLoops(m.loops, m.nloops);
+    freeCFG(cfg);
+    return moved > 0;
+}
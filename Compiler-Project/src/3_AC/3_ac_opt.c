@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "3_ac.h"
+#include "fold.h"
+#include "simulation.h"
+
+// Optimizer over the quadruple array. Temps are defined once by the generator,
+// variables can be redefined at any point; version counters tell the local passes
+// whether a value they remembered is still current.
+
+#define MAX_ROUNDS 8
+
+static const Operand noOperand = {OPND_NONE, 0, 0};
+
+static int sameOperand(Operand a, Operand b) {
+    return a.kind == b.kind && a.value == b.value && a.base == b.base;
+}
+
+// Function to read an integer constant, invalid literals are not constants
+static int intConstant(Operand o, int* value) {
+    char msg[128];
+    if (o.kind == OPND_CONST) {
+        *value = o.value;
+        return 1;
+    }
+    return o.kind == OPND_LITERAL && tryConvertToDecimal(o.value, o.base, value, msg, sizeof(msg));
+}
+
+static Operand literal(int value) {
+    return (Operand){OPND_LITERAL, value, 10};
+}
+
+// Temps and declared int variables can be tracked and replaced. Reads of char or
+// undeclared variables report errors at run time and always stay in place.
+static int isTracked(TACProgram* p, Operand o) {
+    if (o.kind == OPND_TEMP || o.kind == OPND_HIDDEN) return 1;
+    return o.kind == OPND_VAR && o.value < p->nvars && !p->symbols->is_char[o.value];
+}
+
+// Index into the per-name tables: temps first, then variables, then loop counters
+static int nameIndex(TACProgram* p, Operand o) {
+    switch (o.kind) {
+        case OPND_TEMP: return o.value;
+        case OPND_VAR: return p->ntemps + 1 + o.value;
+        default: return p->ntemps + 1 + p->nnames + o.value;
+    }
+}
+
+static int nameCount(TACProgram* p) {
+    return p->ntemps + 1 + p->nnames + p->nvars;
+}
+
+static int isName(Operand o) {
+    return o.kind == OPND_TEMP || o.kind == OPND_VAR || o.kind == OPND_HIDDEN;
+}
+
+// Function to bump the version of every variable a scan overwrites
+static void clobberScanned(TACProgram* p, Quad* q, int* version) {
+    if (q->opcode != TAC_SCAN) return;
+    for (ll* arg = p->io[q->label].args; arg; arg = arg->next) {
+        if (arg->slot >= 0) version[nameIndex(p, (Operand){OPND_VAR, arg->slot, 0})]++;
+    }
+}
+
+static int definesResult(Quad* q) {
+    return q->opcode == TAC_COPY || q->opcode == TAC_BINARY || q->opcode == TAC_LOAD;
+}
+
+static int endsBlock(Quad* q) {
+    return q->opcode == TAC_IF || q->opcode == TAC_GOTO;
+}
+
+// Function to tell whether an operand read can fail at run time
+static int canFail(TACProgram* p, Operand o, int arithmetic) {
+    int value;
+    switch (o.kind) {
+        case OPND_VAR: return !isTracked(p, o);
+        case OPND_LITERAL: return !intConstant(o, &value);
+        case OPND_CHAR: return arithmetic;
+        default: return 0;
+    }
+}
+
+// Function to tell whether a quadruple has to run even if its result is unused
+static int hasSideEffect(TACProgram* p, Quad* q) {
+    // a checked element read can fail, element writes are never removed
+    if (q->opcode == TAC_LOAD) return !q->unchecked || q->result.kind != OPND_TEMP || canFail(p, q->arg1, 1);
+    if (q->opcode != TAC_COPY && q->opcode != TAC_BINARY) return 1;
+    if (q->result.kind != OPND_TEMP) return 1;
+    int arithmetic = q->opcode == TAC_BINARY;
+    if (canFail(p, q->arg1, arithmetic) || canFail(p, q->arg2, arithmetic)) return 1;
+    if (arithmetic && (q->op == OPR_DIV || q->op == OPR_MOD)) {
+        int divisor;
+        return !intConstant(q->arg2, &divisor) || divisor == 0 || divisor == -1;
+    }
+    return 0;
+}
+
+static Operator negateRelop(Operator op) {
+    switch (op) {
+        case OPR_LT: return OPR_GE;
+        case OPR_GE: return OPR_LT;
+        case OPR_GT: return OPR_LE;
+        case OPR_LE: return OPR_GT;
+        case OPR_EQ: return OPR_NE;
+        default: return OPR_EQ;
+    }
+}
+
+static int isRelop(Operator op) {
+    return op >= OPR_LT && op <= OPR_NE;
+}
+
+// Function to drop removed quadruples, returns how many were dropped
+static int compact(TACProgram* p) {
+    int n = 0;
+    for (int i = 0; i < p->ncode; i++) {
+        if (p->code[i].opcode != TAC_NOP) p->code[n++] = p->code[i];
+    }
+    int removed = p->ncode - n;
+    p->ncode = n;
+    return removed;
+}
+
+// Function to count how often every temp is read
+static int* countTempUses(TACProgram* p) {
+    int* uses = allocArray(p->ntemps + 1, sizeof(int));
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->arg1.kind == OPND_TEMP) uses[q->arg1.value]++;
+        if (q->arg2.kind == OPND_TEMP) uses[q->arg2.value]++;
+    }
+    return uses;
+}
+
+// Function to fold a quadruple whose operands are all constants, returns 1 if it changed
+static int foldQuad(Quad* q) {
+    int left, right, value;
+    if (q->opcode == TAC_BINARY && intConstant(q->arg1, &left) && intConstant(q->arg2, &right) &&
+        foldBinaryOperator(q->op, left, right, &value)) {
+        q->opcode = TAC_COPY;
+        q->op = OPR_ASSIGN;
+        q->arg1 = literal(value);
+        q->arg2 = noOperand;
+        return 1;
+    }
+    if (q->opcode == TAC_IF && intConstant(q->arg1, &left) && intConstant(q->arg2, &right) &&
+        foldBinaryOperator(q->op, left, right, &value)) {
+        if (value) *q = (Quad){TAC_GOTO, OPR_ASSIGN, noOperand, noOperand, noOperand, q->label, 0, 0};
+        else q->opcode = TAC_NOP;
+        return 1;
+    }
+    return 0;
+}
+
+// Remembered copy "x := value" of the current block
+typedef struct {
+    Operand value;
+    int block;
+    int version;        // version of x when the copy was made
+    int valueVersion;   // version of value when the copy was made
+} Copy;
+
+// Copy and constant propagation. Temps copied from a constant are replaced everywhere,
+// other copies are followed within their basic block.
+static int propagate(TACProgram* p) {
+    int n = nameCount(p);
+    Operand* constantTemp = allocArray(p->ntemps + 1, sizeof(Operand));
+    int* defs = allocArray(p->ntemps + 1, sizeof(int));
+    int* version = allocArray(n, sizeof(int));
+    Copy* copies = allocArray(n, sizeof(Copy));
+    int changed = 0;
+    int block = 1;
+
+    for (int i = 0; i < p->ncode; i++) {
+        if (definesResult(&p->code[i]) && p->code[i].result.kind == OPND_TEMP) defs[p->code[i].result.value]++;
+    }
+
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_LABEL) block++;
+
+        Operand* args[2] = {&q->arg1, &q->arg2};
+        for (int k = 0; k < 2; k++) {
+            Operand* a = args[k];
+            if (!isTracked(p, *a)) continue;
+            if (a->kind == OPND_TEMP && constantTemp[a->value].kind != OPND_NONE) {
+                *a = constantTemp[a->value];
+                changed = 1;
+                continue;
+            }
+            Copy* c = &copies[nameIndex(p, *a)];
+            if (c->block != block || c->version != version[nameIndex(p, *a)]) continue;
+            if (isTracked(p, c->value) && version[nameIndex(p, c->value)] != c->valueVersion) continue;
+            *a = c->value;
+            changed = 1;
+        }
+        changed |= foldQuad(q);
+        clobberScanned(p, q, version);
+
+        if (definesResult(q)) {
+            int r = nameIndex(p, q->result);
+            version[r]++;
+            copies[r].block = 0;
+            if (q->opcode != TAC_COPY || !isTracked(p, q->result) || sameOperand(q->result, q->arg1)) continue;
+
+            int value;
+            if (intConstant(q->arg1, &value)) {
+                if (q->result.kind == OPND_TEMP && defs[q->result.value] == 1) {
+                    constantTemp[q->result.value] = q->arg1;
+                    continue;
+                }
+                copies[r] = (Copy){q->arg1, block, version[r], 0};
+            } else if (isTracked(p, q->arg1)) {
+                copies[r] = (Copy){q->arg1, block, version[r], version[nameIndex(p, q->arg1)]};
+            }
+        }
+        if (endsBlock(q)) block++;
+    }
+
+    free(constantTemp);
+    free(defs);
+    free(version);
+    free(copies);
+    compact(p);
+    return changed;
+}
+
+// Available expression of the current block, keyed by operator and operand versions
+typedef struct {
+    int block;
+    Operator op;
+    Operand a, b;
+    int versionA, versionB;
+    Operand holder;
+    int holderVersion;
+} Expr;
+
+static int operandVersion(TACProgram* p, int* version, Operand o) {
+    return isName(o) ? version[nameIndex(p, o)] : 0;
+}
+
+static unsigned hashOperand(Operand o, int v) {
+    return ((unsigned)o.kind * 31u + (unsigned)o.value) * 31u + (unsigned)o.base * 7u + (unsigned)v;
+}
+
+// Local common subexpression elimination: a repeated computation in the same block
+// becomes a copy of the first result while its operands and holder are unchanged.
+static int eliminateCommonSubexpressions(TACProgram* p) {
+    int* version = allocArray(nameCount(p), sizeof(int));
+    int cap = 16;
+    while (cap < p->ncode * 2) cap *= 2;
+    Expr* table = allocArray(cap, sizeof(Expr));
+    int changed = 0;
+    int block = 1;
+
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_LABEL) block++;
+
+        if (q->opcode == TAC_BINARY) {
+            Operand a = q->arg1, b = q->arg2;
+            // commutative operators are keyed with a fixed operand order
+            if ((q->op == OPR_ADD || q->op == OPR_MUL || q->op == OPR_EQ || q->op == OPR_NE) &&
+                (a.kind > b.kind || (a.kind == b.kind && a.value > b.value))) {
+                Operand t = a; a = b; b = t;
+            }
+            int va = operandVersion(p, version, a), vb = operandVersion(p, version, b);
+            unsigned h = (hashOperand(a, va) * 2654435761u ^ hashOperand(b, vb) * 40503u ^ (unsigned)q->op) & (cap - 1);
+            Expr* e;
+            for (;;) {
+                e = &table[h];
+                if (e->block != block) break;
+                if (e->op == q->op && sameOperand(e->a, a) && sameOperand(e->b, b) && e->versionA == va && e->versionB == vb) break;
+                h = (h + 1) & (cap - 1);
+            }
+
+            if (e->block == block && operandVersion(p, version, e->holder) == e->holderVersion &&
+                isTracked(p, e->holder) && !sameOperand(e->holder, q->result)) {
+                q->opcode = TAC_COPY;
+                q->op = OPR_ASSIGN;
+                q->arg1 = e->holder;
+                q->arg2 = noOperand;
+                changed = 1;
+            } else {
+                version[nameIndex(p, q->result)]++;
+                *e = (Expr){block, q->op, a, b, va, vb, q->result, version[nameIndex(p, q->result)]};
+                if (endsBlock(q)) block++;
+                continue;
+            }
+        }
+        if (definesResult(q)) version[nameIndex(p, q->result)]++;
+        clobberScanned(p, q, version);
+        if (endsBlock(q)) block++;
+    }
+
+    free(version);
+    free(table);
+    return changed;
+}
+
+// Function to map every label to the index of its quadruple
+static int* labelPositions(TACProgram* p) {
+    int* position = allocArray(p->nlabels + 1, sizeof(int));
+    for (int l = 0; l <= p->nlabels; l++) position[l] = -1;
+    for (int i = 0; i < p->ncode; i++) {
+        if (p->code[i].opcode == TAC_LABEL) position[p->code[i].label] = i;
+    }
+    return position;
+}
+
+// Function to tell whether label is placed right after quadruple i, with only labels in between
+static int labelFollows(TACProgram* p, int i, int label) {
+    for (int j = i + 1; j < p->ncode && p->code[j].opcode == TAC_LABEL; j++) {
+        if (p->code[j].label == label) return 1;
+    }
+    return 0;
+}
+
+// Peephole pass over adjacent quadruples
+static int peephole(TACProgram* p) {
+    int* uses = countTempUses(p);
+    int* position = labelPositions(p);
+    int changed = 0;
+
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        Quad* next = i + 1 < p->ncode ? &p->code[i + 1] : NULL;
+
+        // t := a relop b; if t == 0 goto L  =>  if a !relop b goto L
+        if (next && q->opcode == TAC_BINARY && isRelop(q->op) && q->result.kind == OPND_TEMP &&
+            uses[q->result.value] == 1 && next->opcode == TAC_IF && sameOperand(next->arg1, q->result) &&
+            next->arg2.kind == OPND_CONST && (next->op == OPR_EQ || next->op == OPR_NE) &&
+            (next->arg2.value == 0 || next->arg2.value == 1)) {
+            int whenTrue = (next->op == OPR_EQ) == (next->arg2.value == 1);
+            *next = (Quad){TAC_IF, whenTrue ? q->op : negateRelop(q->op), noOperand, q->arg1, q->arg2, next->label, 0, 0};
+            q->opcode = TAC_NOP;
+            changed = 1;
+            continue;
+        }
+
+        // t := expr; x := t  =>  x := expr
+        if (next && definesResult(q) && q->result.kind == OPND_TEMP && uses[q->result.value] == 1 &&
+            next->opcode == TAC_COPY && sameOperand(next->arg1, q->result)) {
+            next->opcode = q->opcode;
+            next->op = q->op;
+            next->arg1 = q->arg1;
+            next->arg2 = q->arg2;
+            next->label = q->label;
+            next->unchecked = q->unchecked;
+            q->opcode = TAC_NOP;
+            changed = 1;
+            continue;
+        }
+
+        if (q->opcode == TAC_GOTO || q->opcode == TAC_IF) {
+            // jump to a jump goes straight to the final target
+            for (int hops = 0; hops < 8; hops++) {
+                int at = position[q->label];
+                while (at >= 0 && at < p->ncode && p->code[at].opcode == TAC_LABEL) at++;
+                if (at < 0 || at >= p->ncode || p->code[at].opcode != TAC_GOTO || p->code[at].label == q->label) break;
+                q->label = p->code[at].label;
+                changed = 1;
+            }
+            // jump to the next quadruple, a comparison that can fail has to stay
+            if (labelFollows(p, i, q->label) && !canFail(p, q->arg1, 1) && !canFail(p, q->arg2, 1)) {
+                q->opcode = TAC_NOP;
+                changed = 1;
+            }
+        }
+    }
+
+    free(uses);
+    free(position);
+    compact(p);
+    return changed;
+}
+
+// Dead code elimination: unused temps, code after an unconditional jump and labels nobody jumps to
+static int eliminateDeadCode(TACProgram* p) {
+    int changed = 0;
+
+    // unreachable code up to the next label
+    for (int i = 0; i < p->ncode; i++) {
+        if (p->code[i].opcode != TAC_GOTO) continue;
+        for (int j = i + 1; j < p->ncode && p->code[j].opcode != TAC_LABEL; j++) {
+            p->code[j].opcode = TAC_NOP;
+            changed = 1;
+        }
+    }
+
+    // unused temps, removing one can make the temps it read unused too
+    int* uses = countTempUses(p);
+    int* defAt = allocArray(p->ntemps + 1, sizeof(int));
+    int* worklist = allocArray(p->ntemps + 1, sizeof(int));
+    int top = 0;
+    for (int t = 0; t <= p->ntemps; t++) defAt[t] = -1;
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_NOP || !definesResult(q) || q->result.kind != OPND_TEMP) continue;
+        // temps defined more than once are left alone
+        defAt[q->result.value] = defAt[q->result.value] == -1 ? i : -2;
+    }
+    for (int t = 1; t <= p->ntemps; t++) {
+        if (uses[t] == 0 && defAt[t] >= 0) worklist[top++] = t;
+    }
+    while (top) {
+        int t = worklist[--top];
+        Quad* q = &p->code[defAt[t]];
+        if (q->opcode == TAC_NOP || hasSideEffect(p, q)) continue;
+        Operand args[2] = {q->arg1, q->arg2};
+        q->opcode = TAC_NOP;
+        changed = 1;
+        for (int k = 0; k < 2; k++) {
+            if (args[k].kind == OPND_TEMP && --uses[args[k].value] == 0 && defAt[args[k].value] >= 0)
+                worklist[top++] = args[k].value;
+        }
+    }
+
+    // labels without a jump to them
+    unsigned char* target = allocArray(p->nlabels + 1, 1);
+    for (int i = 0; i < p->ncode; i++) {
+        if (p->code[i].opcode == TAC_GOTO || p->code[i].opcode == TAC_IF) target[p->code[i].label] = 1;
+    }
+    for (int i = 0; i < p->ncode; i++) {
+        if (p->code[i].opcode == TAC_LABEL && !target[p->code[i].label]) {
+            p->code[i].opcode = TAC_NOP;
+            changed = 1;
+        }
+    }
+
+    free(uses);
+    free(defAt);
+    free(worklist);
+    free(target);
+    compact(p);
+    return changed;
+}
+
+// Function to run the selected passes until none of them changes the code
+void optimizeTAC(TACProgram* p, int passes) {
+    for (int round = 0; round < MAX_ROUNDS; round++) {
+        int changed = 0;
+        if ((passes & PASS_SCCP) && propagateConditionalConstants(p)) {
+            compact(p);
+            changed = 1;
+        }
+        if (passes & PASS_PROPAGATE) changed |= propagate(p);
+        if (passes & PASS_CSE) changed |= eliminateCommonSubexpressions(p);
+        if (passes & PASS_PEEPHOLE) changed |= peephole(p);
+        if (passes & PASS_DCE) changed |= eliminateDeadCode(p);
+        if (passes & PASS_LICM) changed |= hoistLoopInvariants(p);
+        if (!changed) break;
+    }
+    // last, the other passes expect every temp to be defined once
+    if (passes & PASS_STRENGTH) reduceInductionVariables(p);
+}
+
+// Function to parse a comma separated pass list, returns -1 for an unknown pass
+int parseTACPasses(const char* list) {
+    static const struct {
+        const char* name;
+        int pass;
+    } names[] = {
+        {"propagate", PASS_PROPAGATE}, {"cse", PASS_CSE}, {"dce", PASS_DCE},
+        {"peephole", PASS_PEEPHOLE}, {"sccp", PASS_SCCP}, {"licm", PASS_LICM},
+        {"strength", PASS_STRENGTH}, {"all", PASS_ALL}, {"none", 0},
+    };
+    int passes = 0;
+    const char* start = list;
+    while (*start) {
+        size_t len = strcspn(start, ",");
+        int found = 0;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strlen(names[i].name) == len && strncmp(names[i].name, start, len) == 0) {
+                passes |= names[i].pass;
+                found = 1;
+            }
+        }
+        if (!found) return -1;
+        start += len;
+        if (*start == ',') start++;
+    }
+    return passes;
+}
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "3_ac.h"
+
+// Output is collected in a fixed buffer and written out in large chunks
+typedef struct {
+    FILE* out;
+    size_t len;
+    char data[1 << 16];
+} OutBuffer;
+
+static void flushBuffer(OutBuffer* b) {
+    fwrite(b->data, 1, b->len, b->out);
+    b->len = 0;
+}
+
+static void putString(OutBuffer* b, const char* s) {
+    size_t n = strlen(s);
+    if (b->len + n > sizeof(b->data)) {
+        flushBuffer(b);
+        if (n > sizeof(b->data)) {
+            fwrite(s, 1, n, b->out);
+            return;
+        }
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+static void putChar(OutBuffer* b, char c) {
+    if (b->len == sizeof(b->data)) flushBuffer(b);
+    b->data[b->len++] = c;
+}
+
+static void putInt(OutBuffer* b, int value) {
+    char digits[12];
+    int n = 0;
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (value < 0) putChar(b, '-');
+    while (n) putChar(b, digits[--n]);
+}
+
+static void putOperand(OutBuffer* b, TACProgram* p, Operand o) {
+    switch (o.kind) {
+        case OPND_TEMP:
+            putChar(b, 't');
+            putInt(b, o.value);
+            break;
+        case OPND_VAR:
+            putString(b, p->names[o.value]);
+            break;
+        case OPND_LITERAL:
+            putChar(b, '(');
+            putInt(b, o.value);
+            putString(b, ", ");
+            putInt(b, o.base);
+            putChar(b, ')');
+            break;
+        case OPND_CHAR:
+            putChar(b, '\'');
+            putChar(b, (char)o.value);
+            putChar(b, '\'');
+            break;
+        case OPND_CONST:
+            putInt(b, o.value);
+            break;
+        case OPND_HIDDEN:
+            putString(b, p->names[o.value]);
+            putChar(b, '#');
+            break;
+        default:
+            break;
+    }
+}
+
+static void putLabel(OutBuffer* b, int label) {
+    putChar(b, 'L');
+    putInt(b, label);
+}
+
+static void putIO(OutBuffer* b, const char* keyword, IODesc* d) {
+    putString(b, keyword);
+    putChar(b, ' ');
+    putString(b, d->format);
+    for (ll* arg = d->args; arg; arg = arg->next) {
+        putString(b, ", ");
+        putString(b, arg->string);
+    }
+}
+
+// Function to print a diagnostic without its trailing newline
+static void putMessage(OutBuffer* b, Message* m) {
+    putString(b, m->fatal ? "error \"" : "warning \"");
+    for (const char* c = m->text; *c && *c != '\n'; c++) putChar(b, *c);
+    putChar(b, '"');
+}
+
+// Function to print the element of a load or store, accesses without a bounds check are starred
+static void putElement(OutBuffer* b, TACProgram* p, Quad* q) {
+    putString(b, p->names[q->label]);
+    putChar(b, '[');
+    putOperand(b, p, q->arg1);
+    putString(b, q->unchecked ? "]*" : "]");
+}
+
+// Conditional jumps compare like C does
+static const char* jumpRelop(Operator op) {
+    switch (op) {
+        case OPR_EQ: return "==";
+        case OPR_NE: return "!=";
+        default: return operatorName(op);
+    }
+}
+
+// Function to print the three address code of a program
+void printTAC(TACProgram* p, FILE* out) {
+    OutBuffer* b = malloc(sizeof(OutBuffer));
+    if (!b) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    b->out = out;
+    b->len = 0;
+
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_NOP) continue;
+        switch (q->opcode) {
+            case TAC_COPY:
+                putOperand(b, p, q->result);
+                putString(b, " := ");
+                putOperand(b, p, q->arg1);
+                break;
+            case TAC_BINARY:
+                putOperand(b, p, q->result);
+                putString(b, " := ");
+                putOperand(b, p, q->arg1);
+                putChar(b, ' ');
+                putString(b, operatorName(compoundBaseOperator(q->op)));
+                putChar(b, ' ');
+                putOperand(b, p, q->arg2);
+                break;
+            case TAC_IF:
+                putString(b, "if ");
+                putOperand(b, p, q->arg1);
+                putChar(b, ' ');
+                putString(b, jumpRelop(q->op));
+                putChar(b, ' ');
+                putOperand(b, p, q->arg2);
+                putString(b, " goto ");
+                putLabel(b, q->label);
+                break;
+            case TAC_GOTO:
+                putString(b, "goto ");
+                putLabel(b, q->label);
+                break;
+            case TAC_LABEL:
+                putLabel(b, q->label);
+                putChar(b, ':');
+                break;
+            case TAC_PRINT:
+                putIO(b, "print", &p->io[q->label]);
+                break;
+            case TAC_SCAN:
+                putIO(b, "scan", &p->io[q->label]);
+                break;
+            case TAC_MSG:
+                putMessage(b, &p->msgs[q->label]);
+                break;
+            case TAC_LOAD:
+                putOperand(b, p, q->result);
+                putString(b, " := ");
+                putElement(b, p, q);
+                break;
+            case TAC_STORE:
+                putElement(b, p, q);
+                putString(b, " := ");
+                putOperand(b, p, q->arg2);
+                break;
+            default:
+                break;
+        }
+        putChar(b, '\n');
+    }
+    flushBuffer(b);
+    free(b);
+}
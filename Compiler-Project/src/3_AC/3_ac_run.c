@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "3_ac.h"
+#include "simulation.h"
+
+// The quadruples are executed by the register VM: every quadruple becomes one flat
+// instruction, labels are resolved to instruction indices and temps get registers
+// of their own. Register layout: [variables | loop counters | temps | constants].
+
+typedef struct {
+    TACProgram* tac;
+    BytecodeProgram* prog;
+    int* hiddenOf;      // loop counter register of each char variable, -1 if none
+    int tempBase;
+    ConstPool consts;
+} Assembler;
+
+// Constants are numbered in order of appearance and placed after all other registers
+static int constIndex(Assembler* as, int value) {
+    return internConst(&as->consts, as->prog, value);
+}
+
+// Function to map an operand to its register. Constants get their final register
+// in a second step, once the number of constants is known.
+static int reg(Assembler* as, Operand o) {
+    int value;
+    char msg[128];
+    switch (o.kind) {
+        case OPND_TEMP:
+            return as->tempBase + o.value;
+        case OPND_VAR:
+            // undeclared names are only reached after a fatal diagnostic, they share a scratch register
+            return o.value < as->prog->nvars ? o.value : as->tempBase;
+        case OPND_HIDDEN:
+            return as->prog->nvars + as->hiddenOf[o.value];
+        case OPND_LITERAL:
+            if (!tryConvertToDecimal(o.value, o.base, &value, msg, sizeof(msg))) value = 0;
+            return -1 - constIndex(as, value);
+        case OPND_CHAR:
+        case OPND_CONST:
+            return -1 - constIndex(as, o.value);
+        default:
+            return -1 - constIndex(as, 0);
+    }
+}
+
+static int binaryOpcode(Operator op) {
+    switch (op) {
+        case OPR_ADD: return OP_ADD;
+        case OPR_SUB: return OP_SUB;
+        case OPR_MUL: return OP_MUL;
+        case OPR_DIV: return OP_DIV;
+        case OPR_MOD: return OP_MOD;
+        case OPR_DIV_ASSIGN: return OP_DIVZ;
+        case OPR_LT: return OP_SLT;
+        case OPR_LE: return OP_SLE;
+        case OPR_GT: return OP_SGT;
+        case OPR_GE: return OP_SGE;
+        case OPR_EQ: return OP_SEQ;
+        case OPR_NE: return OP_SNE;
+        default: return -1;
+    }
+}
+
+static int jumpOpcode(Operator op) {
+    switch (op) {
+        case OPR_LT: return OP_JLT;
+        case OPR_LE: return OP_JLE;
+        case OPR_GT: return OP_JGT;
+        case OPR_GE: return OP_JGE;
+        case OPR_EQ: return OP_JEQ;
+        case OPR_NE: return OP_JNE;
+        default: return -1;
+    }
+}
+
+// Number of VM instructions a quadruple turns into
+static int instructionCount(Quad* q) {
+    switch (q->opcode) {
+        case TAC_LABEL:
+        case TAC_NOP:
+            return 0;
+        case TAC_BINARY:
+        case TAC_LOAD:
+            // a := that was folded into an operation still marks its variable
+            return q->marks && q->result.kind == OPND_VAR ? 2 : 1;
+        default:
+            return 1;
+    }
+}
+
+// Function to assemble the three address code into executable VM code
+BytecodeProgram* assembleTAC(TACProgram* tac) {
+    Assembler as;
+    memset(&as, 0, sizeof(as));
+    as.tac = tac;
+    BytecodeProgram* p = as.prog = allocArray(1, sizeof(BytecodeProgram));
+    p->symbols = tac->symbols;
+    p->nvars = tac->nvars;
+
+    // loop counters and label positions
+    as.hiddenOf = allocArray(tac->nvars, sizeof(int));
+    for (int v = 0; v < tac->nvars; v++) as.hiddenOf[v] = -1;
+    int* labelAt = allocArray(tac->nlabels + 1, sizeof(int));
+    int ncode = 0;
+    for (int i = 0; i < tac->ncode; i++) {
+        Quad* q = &tac->code[i];
+        Operand* operands[3] = {&q->result, &q->arg1, &q->arg2};
+        for (int k = 0; k < 3; k++) {
+            if (operands[k]->kind == OPND_HIDDEN && as.hiddenOf[operands[k]->value] == -1)
+                as.hiddenOf[operands[k]->value] = p->nhidden++;
+        }
+        if (q->opcode == TAC_LABEL) labelAt[q->label] = ncode;
+        ncode += instructionCount(q);
+    }
+    as.tempBase = p->nvars + p->nhidden;
+    p->ntemps = tac->ntemps + 1;    // temps are numbered from 1, register 0 is the scratch register
+
+    p->code = allocArray(ncode + 1, sizeof(Instr));
+    for (int i = 0; i < tac->ncode; i++) {
+        Quad* q = &tac->code[i];
+        Instr* in = &p->code[p->ncode];
+        switch (q->opcode) {
+            case TAC_COPY:
+                *in = (Instr){q->marks ? OP_SET : OP_MOV, reg(&as, q->result), reg(&as, q->arg1), 0};
+                p->ncode++;
+                break;
+            case TAC_BINARY: {
+                int op = binaryOpcode(q->op);
+                if (op == -1) {
+                    fprintf(stderr, "Unknown operator: %s\n", operatorName(q->op));
+                    exit(EXIT_FAILURE);
+                }
+                int dst = reg(&as, q->result);
+                *in = (Instr){op, dst, reg(&as, q->arg1), reg(&as, q->arg2)};
+                p->ncode++;
+                if (instructionCount(q) == 2) p->code[p->ncode++] = (Instr){OP_SET, dst, dst, 0};
+                break;
+            }
+            case TAC_LOAD: {
+                int dst = reg(&as, q->result);
+                *in = (Instr){q->unchecked ? OP_LOADU : OP_LOAD, dst, reg(&as, q->arg1), q->label};
+                p->ncode++;
+                if (instructionCount(q) == 2) p->code[p->ncode++] = (Instr){OP_SET, dst, dst, 0};
+                break;
+            }
+            case TAC_STORE:
+                *in = (Instr){q->unchecked ? OP_STOREU : OP_STORE, q->label, reg(&as, q->arg1), reg(&as, q->arg2)};
+                p->ncode++;
+                break;
+            case TAC_IF:
+                *in = (Instr){jumpOpcode(q->op), labelAt[q->label], reg(&as, q->arg1), reg(&as, q->arg2)};
+                p->ncode++;
+                break;
+            case TAC_GOTO:
+                *in = (Instr){OP_JMP, labelAt[q->label], 0, 0};
+                p->ncode++;
+                break;
+            case TAC_PRINT:
+            case TAC_SCAN:
+                *in = (Instr){q->opcode == TAC_PRINT ? OP_PRINT : OP_SCAN, q->label, 0, 0};
+                p->ncode++;
+                break;
+            case TAC_MSG:
+                *in = (Instr){OP_MSG, q->label, 0, 0};
+                p->ncode++;
+                break;
+            default:
+                break;
+        }
+    }
+    p->code[p->ncode++] = (Instr){OP_HALT, 0, 0, 0};
+
+    // constants go last, now that their number is known
+    p->nslots = p->nvars + p->nhidden + p->ntemps + p->nconsts;
+    int constBase = p->nslots - p->nconsts;
+    for (int i = 0; i < p->ncode; i++) {
+        Instr* in = &p->code[i];
+        if (in->op < OP_MOV || in->op > OP_JNE || in->op == OP_JMP) continue;
+        if (in->b < 0) in->b = constBase - 1 - in->b;
+        if (in->c < 0) in->c = constBase - 1 - in->c;
+    }
+
+    // the VM owns copies of the descriptors and messages
+    p->nio = tac->nio;
+    p->io = allocArray(tac->nio, sizeof(IODesc));
+    if (tac->nio) memcpy(p->io, tac->io, tac->nio * sizeof(IODesc));
+    p->nmsgs = tac->nmsgs;
+    p->msgs = allocArray(tac->nmsgs, sizeof(Message));
+    for (int i = 0; i < tac->nmsgs; i++) {
+        p->msgs[i] = tac->msgs[i];
+        p->msgs[i].text = strdup(tac->msgs[i].text);
+    }
+
+    free(labelAt);
+    free(as.hiddenOf);
+    freeConstPool(&as.consts);
+    return p;
+}
@@ -0,0 +1,593 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "3_ac.h"
+#include "cfg.h"
+#include "fold.h"
+#include "simulation.h"
+
+// Sparse conditional constant propagation over an SSA form of the quadruples.
+//
+// Temps, declared int variables and loop counters are renamed: every definition
+// makes a new value and blocks where definitions meet get phi nodes, placed on the
+// iterated dominance frontiers of the defining blocks. Names are only given phis
+// if some block reads them before writing them (semi-pruned SSA). The values live
+// beside the code: every read of a renamed name records the value it sees.
+//
+// SCCP (Wegman and Zadeck) then walks the executable edges from the entry and the
+// SSA uses of values that changed, so a branch on a value that is constant along
+// the executable paths only makes its taken side executable.
+//
+// Leaving SSA: the pass only replaces reads of constant values by literals, folds
+// branches and removes unreachable blocks. No definition moves and no two values
+// of a name are merged, so dropping the value numbers gives back valid code and
+// no copies have to be inserted for the phis.
+
+enum { LATTICE_TOP, LATTICE_CONST, LATTICE_BOTTOM };
+
+typedef struct {
+    int block;
+    int name;
+    int value;          // value the phi defines
+    int* args;          // value arriving over each predecessor of the block
+} Phi;
+
+typedef struct {
+    TACProgram* p;
+    CFG* cfg;
+    int nnames;
+
+    // SSA form
+    Phi* phis;
+    int nphis;
+    int* phiStart;      // block -> first phi of the block (phis are grouped by block)
+    int* argStore;
+    int* useValue;      // 2 * quadruple + argument -> value read, 0 if the operand is not renamed
+    int* defValue;      // quadruple -> value written, 0 if none
+    int nvalues;
+    int valueCap;
+    int* defQuad;       // value -> defining quadruple, -1 for phis and fixed values
+    int* defPhi;        // value -> defining phi, -1 otherwise
+
+    // uses of every value: quadruples as q, phis as -1 - phi
+    int* useStart;
+    int* users;
+
+    // lattice
+    unsigned char* state;
+    int* constant;
+    unsigned char* executable;  // block
+    unsigned char* edge;        // 2 * block + successor index
+    int* flowWork;              // pairs (from, to)
+    int nflow, flowCap;
+    int* valueWork;
+    int nvalueWork, valueWorkCap;
+} SSA;
+
+// Growable list of int pairs
+typedef struct {
+    int* data;
+    int count;
+    int cap;
+} PairList;
+
+static void addPair(PairList* list, int a, int b) {
+    list->data = growArray(list->data, &list->cap, 2 * list->count + 2, sizeof(int));
+    list->data[2 * list->count] = a;
+    list->data[2 * list->count + 1] = b;
+    list->count++;
+}
+
+// Function to number a renamed operand: temps, then int variables, then loop counters.
+// Char and undeclared variables report errors when read and are left alone.
+static int ssaName(TACProgram* p, Operand o) {
+    switch (o.kind) {
+        case OPND_TEMP: return o.value;
+        case OPND_VAR: return o.value < p->nvars && !p->symbols->is_char[o.value] ? p->ntemps + 1 + o.value : -1;
+        case OPND_HIDDEN: return p->ntemps + 1 + p->nvars + o.value;
+        default: return -1;
+    }
+}
+
+static int writesName(TACProgram* p, Quad* q) {
+    if (q->opcode != TAC_COPY && q->opcode != TAC_BINARY && q->opcode != TAC_LOAD) return -1;
+    return ssaName(p, q->result);
+}
+
+// Function to number a variable a scan overwrites, -1 if it is not renamed
+static int scannedName(TACProgram* p, ll* arg) {
+    return arg->slot >= 0 && !p->symbols->is_char[arg->slot] ? p->ntemps + 1 + arg->slot : -1;
+}
+
+static ll* scannedArgs(TACProgram* p, Quad* q) {
+    return q->opcode == TAC_SCAN ? p->io[q->label].args : NULL;
+}
+
+// ---- SSA construction ----------------------------------------------------
+
+// Function to find the dominance frontier of every block, as lists in start/list
+static void dominanceFrontiers(CFG* cfg, int** startOut, int** listOut) {
+    int n = cfg->nblocks;
+    PairList pairs = {0};       // (block, frontier block)
+    int* last = allocArray(n, sizeof(int));    // last frontier block added to each block, + 1
+    for (int b = 0; b < n; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        if (block->rpo < 0 || block->npreds < 2) continue;
+        for (int k = 0; k < block->npreds; k++) {
+            int runner = block->preds[k];
+            if (cfg->blocks[runner].rpo < 0) continue;
+            while (runner != -1 && runner != block->idom) {
+                if (last[runner] == b + 1) break;
+                last[runner] = b + 1;
+                addPair(&pairs, runner, b);
+                runner = cfg->blocks[runner].idom;
+            }
+        }
+    }
+    int* start = allocArray(n + 1, sizeof(int));
+    int* list = allocArray(pairs.count, sizeof(int));
+    for (int i = 0; i < pairs.count; i++) start[pairs.data[2 * i] + 1]++;
+    for (int b = 0; b < n; b++) start[b + 1] += start[b];
+    int* fill = allocArray(n, sizeof(int));
+    for (int i = 0; i < pairs.count; i++) list[start[pairs.data[2 * i]] + fill[pairs.data[2 * i]]++] = pairs.data[2 * i + 1];
+    free(fill);
+    free(pairs.data);
+    free(last);
+    *startOut = start;
+    *listOut = list;
+}
+
+// Function to note that block b writes name, once per block
+static void noteDefinition(PairList* defs, int* writtenIn, int name, int b) {
+    if (name < 0 || writtenIn[name] == b + 1) return;
+    writtenIn[name] = b + 1;
+    addPair(defs, name, b);
+}
+
+// Function to place phis for every name read before written in some block
+static void placePhis(SSA* s) {
+    TACProgram* p = s->p;
+    CFG* cfg = s->cfg;
+    int n = cfg->nblocks;
+
+    // defining blocks of every name and the names that live across blocks
+    unsigned char* global = allocArray(s->nnames, 1);
+    int* writtenIn = allocArray(s->nnames, sizeof(int));
+    PairList defs = {0};        // (name, block), each pair once
+    for (int b = 0; b < n; b++) {
+        if (cfg->blocks[b].rpo < 0) continue;
+        for (int i = cfg->blocks[b].first; i <= cfg->blocks[b].last; i++) {
+            Quad* q = &p->code[i];
+            Operand args[2] = {q->arg1, q->arg2};
+            for (int k = 0; k < 2; k++) {
+                int name = ssaName(p, args[k]);
+                if (name >= 0 && writtenIn[name] != b + 1) global[name] = 1;
+            }
+            noteDefinition(&defs, writtenIn, writesName(p, q), b);
+            for (ll* arg = scannedArgs(p, q); arg; arg = arg->next) noteDefinition(&defs, writtenIn, scannedName(p, arg), b);
+        }
+    }
+
+    // group the defining blocks by name
+    int* defStart = allocArray(s->nnames + 1, sizeof(int));
+    int* defBlocks = allocArray(defs.count, sizeof(int));
+    for (int i = 0; i < defs.count; i++) defStart[defs.data[2 * i] + 1]++;
+    for (int v = 0; v < s->nnames; v++) defStart[v + 1] += defStart[v];
+    int* fill = allocArray(s->nnames, sizeof(int));
+    for (int i = 0; i < defs.count; i++) defBlocks[defStart[defs.data[2 * i]] + fill[defs.data[2 * i]]++] = defs.data[2 * i + 1];
+    free(fill);
+    free(defs.data);
+
+    int *dfStart, *df;
+    dominanceFrontiers(cfg, &dfStart, &df);
+    int* hasPhi = allocArray(n, sizeof(int));       // name + 1 of the last phi placed in the block
+    int* queued = allocArray(n, sizeof(int));
+    int* work = allocArray(n, sizeof(int));
+    int cap = 0;
+    for (int name = 0; name < s->nnames; name++) {
+        if (!global[name] || defStart[name] == defStart[name + 1]) continue;
+        int top = 0;
+        for (int i = defStart[name]; i < defStart[name + 1]; i++) {
+            work[top++] = defBlocks[i];
+            queued[defBlocks[i]] = name + 1;
+        }
+        while (top) {
+            int b = work[--top];
+            for (int i = dfStart[b]; i < dfStart[b + 1]; i++) {
+                int f = df[i];
+                if (hasPhi[f] == name + 1) continue;
+                hasPhi[f] = name + 1;
+                s->phis = growArray(s->phis, &cap, s->nphis + 1, sizeof(Phi));
+                s->phis[s->nphis++] = (Phi){f, name, 0, NULL};
+                if (queued[f] != name + 1) {
+                    queued[f] = name + 1;
+                    work[top++] = f;
+                }
+            }
+        }
+    }
+
+    // group the phis by block, and give each one an argument per predecessor
+    Phi* sorted = allocArray(s->nphis, sizeof(Phi));
+    s->phiStart = allocArray(n + 1, sizeof(int));
+    for (int i = 0; i < s->nphis; i++) s->phiStart[s->phis[i].block + 1]++;
+    for (int b = 0; b < n; b++) s->phiStart[b + 1] += s->phiStart[b];
+    int* at = allocArray(n, sizeof(int));
+    int nargs = 0;
+    for (int i = 0; i < s->nphis; i++) {
+        int b = s->phis[i].block;
+        sorted[s->phiStart[b] + at[b]++] = s->phis[i];
+        nargs += cfg->blocks[b].npreds;
+    }
+    s->argStore = allocArray(nargs, sizeof(int));
+    nargs = 0;
+    for (int i = 0; i < s->nphis; i++) {
+        sorted[i].args = s->argStore + nargs;
+        nargs += cfg->blocks[sorted[i].block].npreds;
+    }
+    free(s->phis);
+    s->phis = sorted;
+
+    free(at);
+    free(hasPhi);
+    free(queued);
+    free(work);
+    free(dfStart);
+    free(df);
+    free(defStart);
+    free(defBlocks);
+    free(global);
+    free(writtenIn);
+}
+
+// Function to make a new value, defined by quadruple quad or phi phi (-1 if neither)
+static int newValue(SSA* s, int quad, int phi) {
+    if (s->nvalues == s->valueCap) {
+        s->valueCap = s->valueCap ? s->valueCap * 2 : 1024;
+        s->defQuad = realloc(s->defQuad, s->valueCap * sizeof(int));
+        s->defPhi = realloc(s->defPhi, s->valueCap * sizeof(int));
+        if (!s->defQuad || !s->defPhi) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s->defQuad[s->nvalues] = quad;
+    s->defPhi[s->nvalues] = phi;
+    return s->nvalues++;
+}
+
+// Function to make value the current one of name, logging the one it hides
+static void define(PairList* log, int* current, int name, int value) {
+    addPair(log, name, current[name]);
+    current[name] = value;
+}
+
+// Function to give every read the value it sees, walking the dominator tree.
+// Value 0 stands for whatever a name holds on entry.
+static void renameValues(SSA* s) {
+    TACProgram* p = s->p;
+    CFG* cfg = s->cfg;
+    int n = cfg->nblocks;
+    newValue(s, -1, -1);
+
+    // dominator tree children
+    int* childStart = allocArray(n + 1, sizeof(int));
+    int* children = allocArray(n, sizeof(int));
+    for (int b = 0; b < n; b++) {
+        if (cfg->blocks[b].idom >= 0) childStart[cfg->blocks[b].idom + 1]++;
+    }
+    for (int b = 0; b < n; b++) childStart[b + 1] += childStart[b];
+    int* fill = allocArray(n, sizeof(int));
+    for (int i = 0; i < cfg->nreachable; i++) {
+        int b = cfg->order[i];
+        int idom = cfg->blocks[b].idom;
+        if (idom >= 0) children[childStart[idom] + fill[idom]++] = b;
+    }
+
+    int* current = allocArray(s->nnames, sizeof(int));
+    PairList log = {0};         // (name, hidden value) of every definition on the dominator path
+    PairList stack = {0};       // (block, log length on entry)
+    if (cfg->nreachable) addPair(&stack, 0, -1);
+    while (stack.count) {
+        int* top = &stack.data[2 * (stack.count - 1)];
+        int b = top[0];
+        BasicBlock* block = &cfg->blocks[b];
+        if (top[1] == -1) {
+            top[1] = log.count;
+            for (int f = s->phiStart[b]; f < s->phiStart[b + 1]; f++) {
+                s->phis[f].value = newValue(s, -1, f);
+                define(&log, current, s->phis[f].name, s->phis[f].value);
+            }
+            for (int i = block->first; i <= block->last; i++) {
+                Quad* q = &p->code[i];
+                Operand args[2] = {q->arg1, q->arg2};
+                for (int k = 0; k < 2; k++) {
+                    int name = ssaName(p, args[k]);
+                    s->useValue[2 * i + k] = name >= 0 ? current[name] : 0;
+                }
+                int name = writesName(p, q);
+                if (name >= 0) {
+                    s->defValue[i] = newValue(s, i, -1);
+                    define(&log, current, name, s->defValue[i]);
+                }
+                for (ll* arg = scannedArgs(p, q); arg; arg = arg->next) {
+                    if ((name = scannedName(p, arg)) >= 0) define(&log, current, name, newValue(s, -1, -1));
+                }
+            }
+            for (int k = 0; k < 2; k++) {
+                int succ = block->succ[k];
+                if (succ < 0) continue;
+                int slot = 0;
+                while (cfg->blocks[succ].preds[slot] != b) slot++;
+                for (int f = s->phiStart[succ]; f < s->phiStart[succ + 1]; f++) s->phis[f].args[slot] = current[s->phis[f].name];
+            }
+            fill[b] = 0;
+        }
+        if (fill[b] < childStart[b + 1] - childStart[b]) {
+            addPair(&stack, children[childStart[b] + fill[b]++], -1);
+            continue;
+        }
+        // leaving the block brings back the values its dominator sees
+        while (log.count > top[1]) {
+            log.count--;
+            current[log.data[2 * log.count]] = log.data[2 * log.count + 1];
+        }
+        stack.count--;
+    }
+
+    free(log.data);
+    free(stack.data);
+    free(current);
+    free(fill);
+    free(childStart);
+    free(children);
+}
+
+// Function to list the quadruples and phis that read every value
+static void collectUses(SSA* s) {
+    TACProgram* p = s->p;
+    s->useStart = allocArray(s->nvalues + 1, sizeof(int));
+    int nuses = 0;
+    for (int i = 0; i < 2 * p->ncode; i++) {
+        if (s->useValue[i]) s->useStart[s->useValue[i] + 1]++;
+    }
+    for (int f = 0; f < s->nphis; f++) {
+        int npreds = s->cfg->blocks[s->phis[f].block].npreds;
+        for (int k = 0; k < npreds; k++) {
+            if (s->phis[f].args[k]) s->useStart[s->phis[f].args[k] + 1]++;
+        }
+    }
+    for (int v = 0; v < s->nvalues; v++) s->useStart[v + 1] += s->useStart[v];
+    nuses = s->useStart[s->nvalues];
+    s->users = allocArray(nuses, sizeof(int));
+    int* fill = allocArray(s->nvalues, sizeof(int));
+    for (int i = 0; i < 2 * p->ncode; i++) {
+        int v = s->useValue[i];
+        if (v) s->users[s->useStart[v] + fill[v]++] = i / 2;
+    }
+    for (int f = 0; f < s->nphis; f++) {
+        int npreds = s->cfg->blocks[s->phis[f].block].npreds;
+        for (int k = 0; k < npreds; k++) {
+            int v = s->phis[f].args[k];
+            if (v) s->users[s->useStart[v] + fill[v]++] = -1 - f;
+        }
+    }
+    free(fill);
+}
+
+// ---- constant propagation ------------------------------------------------
+
+static int intConstant(Operand o, int* value) {
+    char msg[128];
+    if (o.kind == OPND_CONST) {
+        *value = o.value;
+        return 1;
+    }
+    return o.kind == OPND_LITERAL && tryConvertToDecimal(o.value, o.base, value, msg, sizeof(msg));
+}
+
+// Function to read the lattice value of argument k of quadruple i
+static int operandState(SSA* s, int i, int k, int* value) {
+    Operand o = k == 0 ? s->p->code[i].arg1 : s->p->code[i].arg2;
+    int v = s->useValue[2 * i + k];
+    if (v) {
+        *value = s->constant[v];
+        return s->state[v];
+    }
+    if (ssaName(s->p, o) >= 0) return LATTICE_BOTTOM;     // the value a name holds on entry
+    return intConstant(o, value) ? LATTICE_CONST : LATTICE_BOTTOM;
+}
+
+static void lower(SSA* s, int v, int state, int value) {
+    if (state == LATTICE_TOP || s->state[v] == LATTICE_BOTTOM) return;
+    if (s->state[v] == LATTICE_CONST && (state == LATTICE_BOTTOM || s->constant[v] != value)) {
+        s->state[v] = LATTICE_BOTTOM;
+    } else if (s->state[v] == LATTICE_TOP) {
+        s->state[v] = state;
+        s->constant[v] = value;
+    } else {
+        return;
+    }
+    s->valueWork = growArray(s->valueWork, &s->valueWorkCap, s->nvalueWork + 1, sizeof(int));
+    s->valueWork[s->nvalueWork++] = v;
+}
+
+static void markEdge(SSA* s, int from, int k) {
+    int to = s->cfg->blocks[from].succ[k];
+    if (to < 0 || s->edge[2 * from + k]) return;
+    s->edge[2 * from + k] = 1;
+    s->flowWork = growArray(s->flowWork, &s->flowCap, 2 * s->nflow + 2, sizeof(int));
+    s->flowWork[2 * s->nflow] = from;
+    s->flowWork[2 * s->nflow + 1] = to;
+    s->nflow++;
+}
+
+// Function to combine two operands, returns the lattice state
+static int combine(int a, int b) {
+    if (a == LATTICE_BOTTOM || b == LATTICE_BOTTOM) return LATTICE_BOTTOM;
+    return a == LATTICE_TOP || b == LATTICE_TOP ? LATTICE_TOP : LATTICE_CONST;
+}
+
+static void visitQuad(SSA* s, int i) {
+    Quad* q = &s->p->code[i];
+    int left = 0, right = 0, result = 0;
+    int a = operandState(s, i, 0, &left);
+    if (s->defValue[i]) {
+        int v = s->defValue[i];
+        if (q->opcode == TAC_COPY) {
+            lower(s, v, a, left);
+        } else if (q->opcode == TAC_BINARY) {
+            int state = combine(a, operandState(s, i, 1, &right));
+            if (state == LATTICE_CONST && !foldBinaryOperator(q->op, left, right, &result)) state = LATTICE_BOTTOM;
+            lower(s, v, state, result);
+        } else {
+            lower(s, v, LATTICE_BOTTOM, 0);
+        }
+    }
+
+    int b = s->cfg->blockOf[i];
+    if (i != s->cfg->blocks[b].last) return;
+    if (q->opcode == TAC_IF) {
+        int state = combine(a, operandState(s, i, 1, &right));
+        if (state == LATTICE_CONST && foldBinaryOperator(q->op, left, right, &result)) {
+            markEdge(s, b, result ? 1 : 0);
+            // a jump to the next block has a single edge
+            if (s->cfg->blocks[b].succ[1] < 0) markEdge(s, b, 0);
+        } else if (state != LATTICE_TOP) {
+            markEdge(s, b, 0);
+            markEdge(s, b, 1);
+        }
+    } else {
+        markEdge(s, b, 0);
+        markEdge(s, b, 1);
+    }
+}
+
+static void visitPhi(SSA* s, int f) {
+    Phi* phi = &s->phis[f];
+    BasicBlock* block = &s->cfg->blocks[phi->block];
+    // the entry block is also entered from outside the program
+    if (phi->block == 0) {
+        lower(s, phi->value, LATTICE_BOTTOM, 0);
+        return;
+    }
+    for (int k = 0; k < block->npreds; k++) {
+        int pred = block->preds[k];
+        BasicBlock* from = &s->cfg->blocks[pred];
+        int taken = (from->succ[0] == phi->block && s->edge[2 * pred]) || (from->succ[1] == phi->block && s->edge[2 * pred + 1]);
+        if (!taken) continue;
+        int v = phi->args[k];
+        if (!v) {
+            lower(s, phi->value, LATTICE_BOTTOM, 0);
+            return;
+        }
+        lower(s, phi->value, s->state[v], s->constant[v]);
+    }
+}
+
+static void propagateConstants(SSA* s) {
+    CFG* cfg = s->cfg;
+    if (!cfg->nblocks) return;
+    s->executable[0] = 1;
+    for (int i = cfg->blocks[0].first; i <= cfg->blocks[0].last; i++) visitQuad(s, i);
+    for (int f = s->phiStart[0]; f < s->phiStart[1]; f++) visitPhi(s, f);
+
+    while (s->nflow || s->nvalueWork) {
+        while (s->nflow) {
+            s->nflow--;
+            int to = s->flowWork[2 * s->nflow + 1];
+            for (int f = s->phiStart[to]; f < s->phiStart[to + 1]; f++) visitPhi(s, f);
+            if (s->executable[to]) continue;
+            s->executable[to] = 1;
+            for (int i = cfg->blocks[to].first; i <= cfg->blocks[to].last; i++) visitQuad(s, i);
+        }
+        while (s->nvalueWork) {
+            int v = s->valueWork[--s->nvalueWork];
+            for (int u = s->useStart[v]; u < s->useStart[v + 1]; u++) {
+                int user = s->users[u];
+                if (user >= 0) {
+                    if (s->executable[cfg->blockOf[user]]) visitQuad(s, user);
+                } else if (s->executable[s->phis[-1 - user].block]) {
+                    visitPhi(s, -1 - user);
+                }
+            }
+        }
+    }
+}
+
+// Function to rewrite the code with the results, returns 1 if it changed
+static int applyConstants(SSA* s) {
+    TACProgram* p = s->p;
+    int changed = 0;
+    for (int i = 0; i < p->ncode; i++) {
+        Quad* q = &p->code[i];
+        if (q->opcode == TAC_NOP) continue;
+        if (!s->executable[s->cfg->blockOf[i]]) {
+            q->opcode = TAC_NOP;
+            changed = 1;
+            continue;
+        }
+        Operand* args[2] = {&q->arg1, &q->arg2};
+        for (int k = 0; k < 2; k++) {
+            int v = s->useValue[2 * i + k];
+            if (v && s->state[v] == LATTICE_CONST) {
+                *args[k] = (Operand){OPND_LITERAL, s->constant[v], 10};
+                changed = 1;
+            }
+        }
+        int left, right, result;
+        if (q->opcode == TAC_IF && intConstant(q->arg1, &left) && intConstant(q->arg2, &right) &&
+            foldBinaryOperator(q->op, left, right, &result)) {
+            static const Operand none = {OPND_NONE, 0, 0};
+            if (result) *q = (Quad){TAC_GOTO, OPR_ASSIGN, none, none, none, q->label, 0, 0};
+            else q->opcode = TAC_NOP;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// Function to run sparse conditional constant propagation, returns 1 if the code changed
+int propagateConditionalConstants(TACProgram* p) {
+    SSA s;
+    memset(&s, 0, sizeof(s));
+    s.p = p;
+    s.cfg = buildCFG(p);
+    s.nnames = p->ntemps + 1 + 2 * p->nvars;
+    s.useValue = allocArray(2 * (size_t)p->ncode, sizeof(int));
+    s.defValue = allocArray(p->ncode, sizeof(int));
+
+    placePhis(&s);
+    renameValues(&s);
+    collectUses(&s);
+    s.state = allocArray(s.nvalues, 1);
+    s.constant = allocArray(s.nvalues, sizeof(int));
+    s.state[0] = LATTICE_BOTTOM;
+    // values of scanned variables have no defining quadruple
+    for (int v = 1; v < s.nvalues; v++) {
+        if (s.defQuad[v] < 0 && s.defPhi[v] < 0) s.state[v] = LATTICE_BOTTOM;
+    }
+    s.executable = allocArray(s.cfg->nblocks, 1);
+    s.edge = allocArray(2 * (size_t)s.cfg->nblocks, 1);
+    propagateConstants(&s);
+    int changed = applyConstants(&s);
+
+    free(s.phis);
+    free(s.phiStart);
+    free(s.argStore);
+    free(s.useValue);
+    free(s.defValue);
+    free(s.defQuad);
+    free(s.defPhi);
+    free(s.useStart);
+    free(s.users);
+    free(s.state);
+    free(s.constant);
+    free(s.executable);
+    free(s.edge);
+    free(s.flowWork);
+    free(s.valueWork);
+    freeCFG(s.cfg);
+    return changed;
+}
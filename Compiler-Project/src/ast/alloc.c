@@ -0,0 +1,25 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "alloc.h"
+
+void* allocArray(size_t count, size_t elem) {
+    void* array = calloc(count ? count : 1, elem);
+    if (!array) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+void* growArray(void* array, int* cap, int needed, size_t elem) {
+    if (needed <= *cap) return array;
+    int newCap = *cap ? *cap * 2 : 64;
+    while (newCap < needed) newCap *= 2;
+    array = realloc(array, newCap * elem);
+    if (!array) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    *cap = newCap;
+    return array;
+}
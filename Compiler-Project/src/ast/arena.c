@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define ARENA_ALIGN 16
+
+void arenaInit(Arena* arena) {
+    arena->head = NULL;
+    arena->allocated = 0;
+}
+
+// Function to allocate memory from the arena, aligned for any node type
+void* arenaAlloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaBlock* block = arena->head;
+    if (!block || block->size - block->used < size) {
+        size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + blockSize);
+        if (!block) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        block->size = blockSize;
+        block->used = 0;
+        block->next = arena->head;
+        arena->head = block;
+    }
+    void* ptr = block->data + block->used;
+    block->used += size;
+    arena->allocated += size;
+    return ptr;
+}
+
+void* arenaCalloc(Arena* arena, size_t size) {
+    return memset(arenaAlloc(arena, size), 0, size);
+}
+
+char* arenaStrdup(Arena* arena, const char* str) {
+    size_t len = strlen(str) + 1;
+    return memcpy(arenaAlloc(arena, len), str, len);
+}
+
+// Function to release every allocation of the arena at once
+void arenaFree(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arenaInit(arena);
+}
@@ -4,20 +4,14 @@
 #include <string.h>
 
 //Function to create an AST Node
-ASTNode* createASTNode() {
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    if (!node) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
-    }
-    memset(node, 0, sizeof(ASTNode)); // Initialize everything to zero
-    return node;
+ASTNode* createASTNode(Arena* arena) {
+    return (ASTNode*)arenaCalloc(arena, sizeof(ASTNode)); // Initialize everything to zero
 }
 
 // Function to create a number node in the AST
-ASTNode* createNumberNode(int value, int base) {
+ASTNode* createNumberNode(Arena* arena, int value, int base) {
     // printf("Creating NUMBER node: %d, %d\n", value, base);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = NODE_NUMBER;
     node->data.integer.value = value;
     node->data.integer.base = base;
@@ -25,46 +19,66 @@ ASTNode* createNumberNode(int value, int base) {
 }
 
 // Function to create character node
-ASTNode* createCharacterNode(char value) {
+ASTNode* createCharacterNode(Arena* arena, char value) {
     // printf("Creating character node: %c\n", value);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = NODE_CHAR;
     node->data.value = value;
     return node;
 }
 
 // Function to create a variable node in AST
-ASTNode* createVariable(char* value) {
-    // printf("Creating Variable node: %s\n", value);
-    ASTNode* node = createASTNode();
+ASTNode* createVariable(Arena* arena, Interner* names, int name) {
+    ASTNode* node = createASTNode(arena);
     node->type = NODE_VAR;
-    node->data.identifier = strdup(value);
+    node->data.var.identifier = names->strings[name];
+    node->data.var.name = name;
+    node->data.var.slot = -1;
+    return node;
+}
+
+// Function to create the variable of an array declaration
+ASTNode* createArrayVariable(Arena* arena, Interner* names, int name, int length) {
+    ASTNode* node = createVariable(arena, names, name);
+    node->data.var.length = length;
+    return node;
+}
+
+// Function to create an array element node
+ASTNode* createIndexNode(Arena* arena, ASTNode* array, ASTNode* index) {
+    ASTNode* node = createASTNode(arena);
+    node->type = NODE_INDEX;
+    node->data.index.array = array;
+    node->data.index.index = index;
     return node;
 }
 
 // Function to create a statements block node in AST
-ASTNode* createStatementsNode() {
+ASTNode* createStatementsNode(Arena* arena) {
     // printf("Creating Statements node\n");
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = NODE_STMTS;
+    node->data.statements.statements = NULL;
     node->data.statements.count = 0;
-
-    for (int i = 0; i < 100; i++) {
-        node->data.statements.statements[i] = NULL;
-    }
+    node->data.statements.capacity = 0;
     return node;
 }
 
 // Function to add statements in statements block node
-ASTNode* addStatement(ASTNode* stmts, ASTNode* stmt) {
+ASTNode* addStatement(Arena* arena, ASTNode* stmts, ASTNode* stmt) {
     if (!stmts || stmts->type != NODE_STMTS) {
         fprintf(stderr, "Invalid statements node\n");
         return stmts;
     }
     
-    if (stmts->data.statements.count >= 100) {
-        fprintf(stderr, "Maximum statement limit reached\n");
-        return stmts;
+    // grow by doubling, the outgrown array stays in the arena until the unit is freed
+    if (stmts->data.statements.count == stmts->data.statements.capacity) {
+        int capacity = stmts->data.statements.capacity ? stmts->data.statements.capacity * 2 : 4;
+        ASTNode** grown = (ASTNode**)arenaAlloc(arena, capacity * sizeof(ASTNode*));
+        if (stmts->data.statements.count)
+            memcpy(grown, stmts->data.statements.statements, stmts->data.statements.count * sizeof(ASTNode*));
+        stmts->data.statements.statements = grown;
+        stmts->data.statements.capacity = capacity;
     }
     
     stmts->data.statements.statements[stmts->data.statements.count++] = stmt;
@@ -72,9 +86,9 @@ ASTNode* addStatement(ASTNode* stmts, ASTNode* stmt) {
 }
 
 // Function to create a for loop node in AST
-ASTNode* createForLoopNode(NodeType type, ASTNode* id, ASTNode* init, ASTNode* limit, ASTNode* update, ASTNode* stmts) {
+ASTNode* createForLoopNode(Arena* arena, NodeType type, ASTNode* init, ASTNode* limit, ASTNode* update, ASTNode* stmts) {
     // printf("Creating ForLoop Node: %d\n", type);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = type;
     node->data.for_loop_block.init = init;
     node->data.for_loop_block.limit = limit;
@@ -84,9 +98,9 @@ ASTNode* createForLoopNode(NodeType type, ASTNode* id, ASTNode* init, ASTNode* l
 }
 
 // Function to create simple if or while loop Node
-ASTNode* createIfOrWhileLoopNode(NodeType type, ASTNode* condition, ASTNode* stmts) {
+ASTNode* createIfOrWhileLoopNode(Arena* arena, NodeType type, ASTNode* condition, ASTNode* stmts) {
     // printf("Creating if statement / while loop Node: %d\n", type);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = type;
     node->data.if_while_block.condition = condition;
     node->data.if_while_block.stmts = stmts;
@@ -94,9 +108,9 @@ ASTNode* createIfOrWhileLoopNode(NodeType type, ASTNode* condition, ASTNode* stm
 }
 
 // Function to create if else ladder Node
-ASTNode* createIfElseLadderNode(NodeType type, ASTNode* condition, ASTNode* stmts, ASTNode* elsepart) {
+ASTNode* createIfElseLadderNode(Arena* arena, NodeType type, ASTNode* condition, ASTNode* stmts, ASTNode* elsepart) {
     // printf("Creating if else Node: %d\n", type);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = type;
     node->data.if_else_block.condition = condition;
     node->data.if_else_block.stmts = stmts;
@@ -105,20 +119,43 @@ ASTNode* createIfElseLadderNode(NodeType type, ASTNode* condition, ASTNode* stmt
 }
 
 // Function to create an operator node with left and right children
-ASTNode* createOperatorNode(NodeType type, ASTNode* left, ASTNode* right, char* operator) {
-    // printf("Creating OPERATOR node: %s\n", operator);
-    ASTNode* node = createASTNode();
+ASTNode* createOperatorNode(Arena* arena, NodeType type, ASTNode* left, ASTNode* right, Operator op) {
+    // printf("Creating OPERATOR node: %s\n", operatorName(op));
+    ASTNode* node = createASTNode(arena);
     node->type = type;
     node->data.operator.left = left;
     node->data.operator.right = right;
-    node->data.operator.operator = strdup(operator);
+    node->data.operator.op = op;
     return node;
 }
 
+// Function to get the source spelling of an operator
+const char* operatorName(Operator op) {
+    static const char* names[] = {
+        [OPR_ADD] = "+", [OPR_SUB] = "-", [OPR_MUL] = "*", [OPR_DIV] = "/", [OPR_MOD] = "%",
+        [OPR_LT] = "<", [OPR_GT] = ">", [OPR_LE] = "<=", [OPR_GE] = ">=", [OPR_EQ] = "=", [OPR_NE] = "<>",
+        [OPR_ASSIGN] = ":=", [OPR_ADD_ASSIGN] = "+=", [OPR_SUB_ASSIGN] = "-=", [OPR_MUL_ASSIGN] = "*=",
+        [OPR_DIV_ASSIGN] = "/=", [OPR_MOD_ASSIGN] = "%=", [OPR_INC] = "inc", [OPR_DEC] = "dec"
+    };
+    return names[op];
+}
+
+// Function to get the arithmetic operator of a compound assignment (+= gives +)
+Operator compoundBaseOperator(Operator op) {
+    switch (op) {
+        case OPR_ADD_ASSIGN: return OPR_ADD;
+        case OPR_SUB_ASSIGN: return OPR_SUB;
+        case OPR_MUL_ASSIGN: return OPR_MUL;
+        case OPR_DIV_ASSIGN: return OPR_DIV;
+        case OPR_MOD_ASSIGN: return OPR_MOD;
+        default:             return op;
+    }
+}
+
 // Function to create a Program node with VarDecl and stmt block
-ASTNode* createProgramNode(NodeType type, ASTNode* VarDecl, ASTNode* StmtBlock) {
+ASTNode* createProgramNode(Arena* arena, NodeType type, ASTNode* VarDecl, ASTNode* StmtBlock) {
     // printf("Creating Program node: %d\n", type);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = type;
     node->data.program.varDecl = VarDecl;
     node->data.program.stmtblock = StmtBlock;
@@ -126,33 +163,49 @@ ASTNode* createProgramNode(NodeType type, ASTNode* VarDecl, ASTNode* StmtBlock)
 }
 
 // Function to create a VarDecl node
-ASTNode* createVarDeclNode(NodeType type, char* dtype, ASTNode* variable, ASTNode* next) {
+ASTNode* createVarDeclNode(Arena* arena, NodeType type, char* dtype, ASTNode* variable, ASTNode* next) {
     // printf("Creating Variable Declaration node: %d\n", type);
-    ASTNode* node = createASTNode();
+    ASTNode* node = createASTNode(arena);
     node->type = type;
-    node->data.var_list.type = strdup(dtype); 
+    node->data.var_list.type = dtype;
     node->data.var_list.variable = variable;
     node->data.var_list.next = next;
     return node;
 }
 
-// Function to create Argument list for print or scan statements
-ll* createArgList(char* arg, ll* next) {
-    ll* node = (ll*)malloc(sizeof(ll)); 
-    if (!node) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+// Function to restore source order of a VarDecl list built by prepending
+ASTNode* reverseVarDeclList(ASTNode* list) {
+    ASTNode* reversed = NULL;
+    while (list) {
+        ASTNode* next = list->data.var_list.next;
+        list->data.var_list.next = reversed;
+        reversed = list;
+        list = next;
     }
-    node->string = strdup(arg);
+    return reversed;
+}
+
+// Function to record where a statement starts in the source
+ASTNode* setLocation(ASTNode* node, int line, int column) {
+    node->line = line;
+    node->column = column;
+    return node;
+}
+
+// Function to create Argument list for print or scan statements
+ll* createArgList(Arena* arena, char* arg, int name, ll* next) {
+    ll* node = (ll*)arenaAlloc(arena, sizeof(ll)); 
+    node->string = arg; // names are interned, nothing is copied
+    node->name = name;
+    node->slot = -1;
     node->next = next;
     return node;
 }
 
 // Function for creating AST node for print or scan statements
-ASTNode* createPrintOrScanNode(NodeType type, char* keyword, char* string, ll* args, int count) {
-    ASTNode* node = createASTNode();
+ASTNode* createPrintOrScanNode(Arena* arena, NodeType type, char* string, ll* args, int count) {
+    ASTNode* node = createASTNode(arena);
     node->type = type;
-    node->data.print_scan_stmt.keyword = keyword;
     node->data.print_scan_stmt.string = string;
     node->data.print_scan_stmt.args = args;
     node->data.print_scan_stmt.count = count;
@@ -184,13 +237,20 @@ void printASTHelper(ASTNode* node, int indent) {
             break;
             
         case NODE_VAR:
-            printf("%s", node->data.identifier);
+            printf("%s", node->data.var.identifier);
+            if (node->data.var.length) printf("[%d]", node->data.var.length);
+            break;
+
+        case NODE_INDEX:
+            printf("%s[", node->data.index.array->data.var.identifier);
+            printASTHelper(node->data.index.index, indent + 2);
+            printf("]");
             break;
             
         case NODE_OP:
         case NODE_RELOP:
         case NODE_ASSIGN:
-            printf("(%s ", node->data.operator.operator);
+            printf("(%s ", operatorName(node->data.operator.op));
             printASTHelper(node->data.operator.left, indent + 2);
             printf(" ");
             printASTHelper(node->data.operator.right, indent + 2);
@@ -198,7 +258,7 @@ void printASTHelper(ASTNode* node, int indent) {
             break;
         case NODE_INC:
         case NODE_DEC:
-            printf("(%s ", node->data.operator.operator);
+            printf("(%s ", operatorName(node->data.operator.op));
             printASTHelper(node->data.operator.left, indent + 2);
             printf(")");
             break;
@@ -243,7 +303,7 @@ void printASTHelper(ASTNode* node, int indent) {
         
         case NODE_PRINT:
         case NODE_SCAN: {
-            printf("(%s %s", node->data.print_scan_stmt.keyword, node->data.print_scan_stmt.string);
+            printf("(%s %s", node->type == NODE_PRINT ? "print" : "scan", node->data.print_scan_stmt.string);
             ll* current = node->data.print_scan_stmt.args;
             while (current != NULL) {
                 printf(" %s", current->string);
@@ -326,100 +386,3 @@ void printASTHelper(ASTNode* node, int indent) {
             break;
     }
 }
-
-
-// Functions to free the memory allocated for the AST
-void freeLL(ll* head) {
-    while (head) {
-        ll* temp = head;
-        head = head->next;
-        free(temp->string);
-        free(temp);
-    }
-}
-
-void freeAST(ASTNode* node) {
-    if (!node) return;
-
-    switch (node->type) {
-        case NODE_PROG:
-            // printf("test Prog\n");
-            freeAST(node->data.program.varDecl); 
-            freeAST(node->data.program.stmtblock);
-            break;
-        
-        case NODE_VARDEC:
-            // printf("test vardecl\n");
-            free(node->data.var_list.type);
-            freeAST(node->data.var_list.variable); 
-            freeAST(node->data.var_list.next);
-            break;
-
-        case NODE_STMTS:
-            // printf("test stmts\n");
-            for (int i = 0; i < node->data.statements.count; i++) {
-                freeAST(node->data.statements.statements[i]); 
-            }
-            break;
-
-        case NODE_FOR:
-            // printf("test for\n");
-            freeAST(node->data.for_loop_block.init); 
-            freeAST(node->data.for_loop_block.limit); 
-            freeAST(node->data.for_loop_block.update); 
-            freeAST(node->data.for_loop_block.stmts);
-            break;
-
-        case NODE_WHILE:
-            // printf("test while\n");
-            freeAST(node->data.if_while_block.condition); 
-            freeAST(node->data.if_while_block.stmts); 
-            break;
-
-        case NODE_IF_ELSE:
-            // printf("test ifelse\n");
-            freeAST(node->data.if_else_block.condition); 
-            freeAST(node->data.if_else_block.stmts); 
-            freeAST(node->data.if_else_block.else_part); 
-            break;
-
-        case NODE_IF:
-            // printf("test if\n");
-            freeAST(node->data.if_while_block.condition); 
-            freeAST(node->data.if_while_block.stmts); 
-            break;
-
-        case NODE_NUMBER:
-        case NODE_CHAR:
-            break;
-
-        case NODE_ASSIGN:
-        case NODE_INC:
-        case NODE_DEC:
-        case NODE_OP:
-        case NODE_RELOP:
-            // printf("test opera\n");
-            freeAST(node->data.operator.left); 
-            freeAST(node->data.operator.right); 
-            free(node->data.operator.operator);
-            break;
-
-        case NODE_VAR:
-            // printf("test var\n");
-            free(node->data.identifier);
-            break;
-
-        case NODE_SCAN:
-        case NODE_PRINT:
-            // printf("test Printscan\n");
-            free(node->data.print_scan_stmt.string); 
-            freeLL(node->data.print_scan_stmt.args);
-            break;
-
-        default:
-            fprintf(stderr, "Unknown AST Node Type: %d\n", node->type);
-            break;
-    }
-
-    free(node);
-}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bounds.h"
+#include "simulation.h"
+
+// Function to list the children of a node other than a statement block
+int childNodes(ASTNode* node, ASTNode* out[4]) {
+    switch (node->type) {
+        case NODE_ASSIGN:
+        case NODE_INC:
+        case NODE_DEC:
+        case NODE_OP:
+        case NODE_RELOP:
+            out[0] = node->data.operator.left;
+            out[1] = node->data.operator.right;
+            return 2;
+        case NODE_INDEX:
+            out[0] = node->data.index.array;
+            out[1] = node->data.index.index;
+            return 2;
+        case NODE_FOR:
+            out[0] = node->data.for_loop_block.init;
+            out[1] = node->data.for_loop_block.limit;
+            out[2] = node->data.for_loop_block.update;
+            out[3] = node->data.for_loop_block.stmts;
+            return 4;
+        case NODE_WHILE:
+        case NODE_IF:
+            out[0] = node->data.if_while_block.condition;
+            out[1] = node->data.if_while_block.stmts;
+            return 2;
+        case NODE_IF_ELSE:
+            out[0] = node->data.if_else_block.condition;
+            out[1] = node->data.if_else_block.stmts;
+            out[2] = node->data.if_else_block.else_part;
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+// Function to read a valid integer literal
+int literalValue(ASTNode* node, int* value) {
+    char msg[128];
+    return node && node->type == NODE_NUMBER &&
+           tryConvertToDecimal(node->data.integer.value, node->data.integer.base, value, msg, sizeof(msg));
+}
+
+// Function to tell whether a variable can be assigned or scanned below a node
+static int modifies(ASTNode* node, int slot) {
+    if (!node) return 0;
+    switch (node->type) {
+        case NODE_STMTS:
+            for (int i = 0; i < node->data.statements.count; i++) {
+                if (modifies(node->data.statements.statements[i], slot)) return 1;
+            }
+            return 0;
+        case NODE_ASSIGN:
+            if (node->data.operator.left->type == NODE_VAR && node->data.operator.left->data.var.slot == slot) return 1;
+            break;
+        case NODE_SCAN:
+            for (ll* arg = node->data.print_scan_stmt.args; arg; arg = arg->next) {
+                if (arg->slot == slot) return 1;
+            }
+            return 0;
+        default:
+            break;
+    }
+    ASTNode* children[4];
+    int n = childNodes(node, children);
+    for (int i = 0; i < n; i++) {
+        if (modifies(children[i], slot)) return 1;
+    }
+    return 0;
+}
+
+// Function to tell whether a loop limit has the same value in every iteration and
+// can be evaluated once more without side effects
+static int invariantLimit(SymbolTable* symbols, ASTNode* node, ASTNode* body, int counter) {
+    int value;
+    switch (node->type) {
+        case NODE_NUMBER:
+            return literalValue(node, &value);
+        case NODE_VAR: {
+            int slot = node->data.var.slot;
+            return slot >= 0 && slot != counter && !symbols->is_char[slot] && !symbols->length[slot] && !modifies(body, slot);
+        }
+        case NODE_OP:
+            if (node->data.operator.op != OPR_ADD && node->data.operator.op != OPR_SUB && node->data.operator.op != OPR_MUL)
+                return 0;
+            return invariantLimit(symbols, node->data.operator.left, body, counter) &&
+                   invariantLimit(symbols, node->data.operator.right, body, counter);
+        default:
+            return 0;
+    }
+}
+
+// Function to tell whether a for loop runs a fixed number of times once entered
+static int countedLoop(SymbolTable* symbols, ASTNode* node, int* step) {
+    ASTNode* body = node->data.for_loop_block.stmts;
+    int counter = node->data.for_loop_block.init->data.operator.left->data.var.slot;
+    if (counter < 0 || symbols->length[counter]) return 0;
+    if (!literalValue(node->data.for_loop_block.update->data.operator.left, step) || *step <= 0) return 0;
+    return !modifies(body, counter) && invariantLimit(symbols, node->data.for_loop_block.limit, body, counter);
+}
+
+static void markNode(SymbolTable* symbols, ASTNode* node) {
+    if (!node) return;
+    if (node->type == NODE_STMTS) {
+        for (int i = 0; i < node->data.statements.count; i++) markNode(symbols, node->data.statements.statements[i]);
+        return;
+    }
+    if (node->type == NODE_FOR)
+        node->data.for_loop_block.counted = countedLoop(symbols, node, &node->data.for_loop_block.step);
+    ASTNode* children[4];
+    int n = childNodes(node, children);
+    for (int i = 0; i < n; i++) markNode(symbols, children[i]);
+}
+
+// Function to find the for loops whose trip count is known on entry
+void markCountedLoops(ASTNode* root, SymbolTable* symbols) {
+    if (!root || root->type != NODE_PROG) return;
+    markNode(symbols, root->data.program.stmtblock);
+}
+
+// Function to match an index of the form counter, counter + k, k + counter or counter - k
+int counterOffset(ASTNode* index, int counter, int* offset) {
+    if (index->type == NODE_VAR) {
+        *offset = 0;
+        return index->data.var.slot == counter;
+    }
+    if (index->type != NODE_OP || (index->data.operator.op != OPR_ADD && index->data.operator.op != OPR_SUB)) return 0;
+    ASTNode* left = index->data.operator.left;
+    ASTNode* right = index->data.operator.right;
+    int k;
+    if (index->data.operator.op == OPR_ADD && right->type == NODE_VAR) {
+        ASTNode* swap = left;
+        left = right;
+        right = swap;
+    }
+    if (left->type != NODE_VAR || left->data.var.slot != counter || !literalValue(right, &k)) return 0;
+    if (k < -MAX_OFFSET || k > MAX_OFFSET) return 0;
+    *offset = index->data.operator.op == OPR_SUB ? -k : k;
+    return 1;
+}
+
+// Accesses through the counter of one loop
+typedef struct {
+    SymbolTable* symbols;
+    ASTNode* loop;
+    int counter;
+    int inc;
+    int claim;          // second walk: the accesses are handed to the loop
+    int accesses;
+    int low, high;
+} LoopScan;
+
+static void scanAccesses(LoopScan* s, ASTNode* node) {
+    if (!node) return;
+    if (node->type == NODE_STMTS) {
+        for (int i = 0; i < node->data.statements.count; i++) scanAccesses(s, node->data.statements.statements[i]);
+        return;
+    }
+    if (node->type == NODE_INDEX && !node->data.index.loop) {
+        int slot = node->data.index.array->data.var.slot;
+        int k;
+        if (slot >= 0 && s->symbols->length[slot] && counterOffset(node->data.index.index, s->counter, &k)) {
+            // the counter runs over [start, limit - 1] for inc and [limit + 1, start] for dec
+            int length = s->symbols->length[slot];
+            int low = s->inc ? -k : -1 - k;
+            int high = s->inc ? length - k : length - 1 - k;
+            if (s->claim) {
+                node->data.index.loop = s->loop;
+            } else {
+                if (!s->accesses || low > s->low) s->low = low;
+                if (!s->accesses || high < s->high) s->high = high;
+                s->accesses++;
+            }
+        }
+    }
+    ASTNode* children[4];
+    int n = childNodes(node, children);
+    for (int i = 0; i < n; i++) scanAccesses(s, children[i]);
+}
+
+// Function to give a counted for loop a fast copy, returns 1 if it got one
+static int hoistLoop(SymbolTable* symbols, ASTNode* node) {
+    int counter = node->data.for_loop_block.init->data.operator.left->data.var.slot;
+    if (!node->data.for_loop_block.counted || symbols->is_char[counter] || node->data.for_loop_block.step > MAX_OFFSET)
+        return 0;
+
+    ASTNode* body = node->data.for_loop_block.stmts;
+    LoopScan s = {symbols, node, counter, node->data.for_loop_block.update->type == NODE_INC, 0, 0, 0, 0};
+    scanAccesses(&s, body);
+    if (!s.accesses) return 0;
+    s.claim = 1;
+    scanAccesses(&s, body);
+    node->data.for_loop_block.hoisted = 1;
+    node->data.for_loop_block.low = s.low;
+    node->data.for_loop_block.high = s.high;
+    return 1;
+}
+
+static void hoistNode(SymbolTable* symbols, ASTNode* node, int depth) {
+    if (!node) return;
+    if (node->type == NODE_STMTS) {
+        for (int i = 0; i < node->data.statements.count; i++) hoistNode(symbols, node->data.statements.statements[i], depth);
+        return;
+    }
+    if (node->type == NODE_FOR && depth < MAX_HOISTED_LOOPS && hoistLoop(symbols, node)) depth++;
+    ASTNode* children[4];
+    int n = childNodes(node, children);
+    for (int i = 0; i < n; i++) hoistNode(symbols, children[i], depth);
+}
+
+// Function to find the loops whose array accesses can be checked once on entry
+void hoistBoundsChecks(ASTNode* root, SymbolTable* symbols) {
+    if (!root || root->type != NODE_PROG) return;
+    hoistNode(symbols, root->data.program.stmtblock, 0);
+}
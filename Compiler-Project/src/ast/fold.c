@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "fold.h"
+#include "simulation.h"
+
+// A literal is known once it has been normalized to base 10, invalid literals
+// keep their original base so their error is still reported when evaluated
+static int isConstant(ASTNode* node) {
+    return node && node->type == NODE_NUMBER && node->data.integer.base == 10;
+}
+
+// Function to compute an operator on two constants, returns 0 when it must be left to run time
+int foldBinaryOperator(Operator op, int left, int right, int* result) {
+    // wrap like the engines do instead of relying on signed overflow
+    unsigned int l = (unsigned int)left, r = (unsigned int)right;
+    switch (op) {
+        case OPR_ADD: *result = (int)(l + r); return 1;
+        case OPR_SUB: *result = (int)(l - r); return 1;
+        case OPR_MUL: *result = (int)(l * r); return 1;
+        case OPR_DIV:
+        case OPR_MOD:
+            // division by zero and INT_MIN / -1 trap at run time, keep them there
+            if (right == 0 || (left == INT_MIN && right == -1)) return 0;
+            *result = op == OPR_DIV ? left / right : left % right;
+            return 1;
+        case OPR_LT: *result = left < right; return 1;
+        case OPR_GT: *result = left > right; return 1;
+        case OPR_LE: *result = left <= right; return 1;
+        case OPR_GE: *result = left >= right; return 1;
+        case OPR_EQ: *result = left == right; return 1;
+        case OPR_NE: *result = left != right; return 1;
+        default:
+            return 0;
+    }
+}
+
+// Function to fold an expression in place
+static void foldExpression(ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case NODE_NUMBER: {
+            int value;
+            char msg[128];
+            if (node->data.integer.base != 10 &&
+                tryConvertToDecimal(node->data.integer.value, node->data.integer.base, &value, msg, sizeof(msg))) {
+                node->data.integer.value = value;
+                node->data.integer.base = 10;
+            }
+            break;
+        }
+        case NODE_OP: {
+            ASTNode* left = node->data.operator.left;
+            ASTNode* right = node->data.operator.right;
+            foldExpression(left);
+            foldExpression(right);
+            int value;
+            if (isConstant(left) && isConstant(right) &&
+                foldBinaryOperator(node->data.operator.op, left->data.integer.value, right->data.integer.value, &value)) {
+                node->type = NODE_NUMBER;
+                node->data.integer.value = value;
+                node->data.integer.base = 10;
+            }
+            break;
+        }
+        case NODE_INDEX:
+            foldExpression(node->data.index.index);
+            break;
+        default:
+            break;
+    }
+}
+
+// Function to fold a condition, returns 1 or 0 when it is known and -1 otherwise
+static int foldCondition(ASTNode* node) {
+    if (!node || node->type != NODE_RELOP) return -1;
+    ASTNode* left = node->data.operator.left;
+    ASTNode* right = node->data.operator.right;
+    foldExpression(left);
+    foldExpression(right);
+    if (!isConstant(left) || !isConstant(right)) return -1;
+
+    int known;
+    if (!foldBinaryOperator(node->data.operator.op, left->data.integer.value, right->data.integer.value, &known)) return -1;
+    return known;
+}
+
+// Function to fold a statement block, statements replaced by a block are spliced in
+static ASTNode* foldStatements(Arena* arena, ASTNode* node) {
+    ASTNode* folded = createStatementsNode(arena);
+    for (int i = 0; i < node->data.statements.count; i++) {
+        ASTNode* stmt = foldConstants(arena, node->data.statements.statements[i]);
+        if (stmt && stmt->type == NODE_STMTS) {
+            for (int j = 0; j < stmt->data.statements.count; j++)
+                addStatement(arena, folded, stmt->data.statements.statements[j]);
+        } else if (stmt) {
+            addStatement(arena, folded, stmt);
+        }
+    }
+    return folded;
+}
+
+ASTNode* foldConstants(Arena* arena, ASTNode* node) {
+    if (!node) return NULL;
+
+    switch (node->type) {
+        case NODE_PROG:
+            node->data.program.stmtblock = foldConstants(arena, node->data.program.stmtblock);
+            return node;
+
+        case NODE_STMTS:
+            return foldStatements(arena, node);
+
+        case NODE_ASSIGN:
+            foldExpression(node->data.operator.left);
+            foldExpression(node->data.operator.right);
+            return node;
+
+        case NODE_IF: {
+            int known = foldCondition(node->data.if_while_block.condition);
+            ASTNode* stmts = foldConstants(arena, node->data.if_while_block.stmts);
+            if (known == 1) return stmts;
+            if (known == 0) return createStatementsNode(arena);
+            node->data.if_while_block.stmts = stmts;
+            return node;
+        }
+
+        case NODE_IF_ELSE: {
+            int known = foldCondition(node->data.if_else_block.condition);
+            ASTNode* stmts = foldConstants(arena, node->data.if_else_block.stmts);
+            ASTNode* else_part = foldConstants(arena, node->data.if_else_block.else_part);
+            if (known == 1) return stmts;
+            if (known == 0) return else_part;
+            node->data.if_else_block.stmts = stmts;
+            node->data.if_else_block.else_part = else_part;
+            return node;
+        }
+
+        case NODE_WHILE: {
+            // a loop that is always entered stays as it is, it never ends anyway
+            if (foldCondition(node->data.if_while_block.condition) == 0)
+                return createStatementsNode(arena);
+            node->data.if_while_block.stmts = foldConstants(arena, node->data.if_while_block.stmts);
+            return node;
+        }
+
+        case NODE_FOR:
+            foldExpression(node->data.for_loop_block.init->data.operator.right);
+            foldExpression(node->data.for_loop_block.limit);
+            foldExpression(node->data.for_loop_block.update->data.operator.left);
+            node->data.for_loop_block.stmts = foldConstants(arena, node->data.for_loop_block.stmts);
+            return node;
+
+        default:
+            return node;
+    }
+}
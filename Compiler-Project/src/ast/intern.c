@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intern.h"
+
+static void* checkedAlloc(void* ptr) {
+    if (!ptr) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+// FNV-1a hash of the first length bytes of text
+static unsigned hashText(const char* text, size_t length) {
+    unsigned h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)text[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void rehash(Interner* interner) {
+    int cap = interner->indexCap ? interner->indexCap * 2 : 256;
+    int* index = checkedAlloc(calloc(cap, sizeof(int)));
+    for (int id = 0; id < interner->count; id++) {
+        unsigned h = interner->hashes[id] & (cap - 1);
+        while (index[h]) h = (h + 1) & (cap - 1);
+        index[h] = id + 1;
+    }
+    free(interner->index);
+    interner->index = index;
+    interner->indexCap = cap;
+}
+
+void internInit(Interner* interner, Arena* arena) {
+    memset(interner, 0, sizeof(Interner));
+    interner->arena = arena;
+}
+
+// Function to get the id of a string, only the first occurrence is copied
+int intern(Interner* interner, const char* text, size_t length) {
+    if (!interner->index) rehash(interner);
+    unsigned hash = hashText(text, length);
+    unsigned h = hash & (interner->indexCap - 1);
+    while (interner->index[h]) {
+        int id = interner->index[h] - 1;
+        const char* s = interner->strings[id];
+        if (interner->hashes[id] == hash && strncmp(s, text, length) == 0 && s[length] == '\0') return id;
+        h = (h + 1) & (interner->indexCap - 1);
+    }
+
+    if (interner->count == interner->cap) {
+        interner->cap = interner->cap ? interner->cap * 2 : 64;
+        interner->strings = checkedAlloc(realloc(interner->strings, interner->cap * sizeof(char*)));
+        interner->hashes = checkedAlloc(realloc(interner->hashes, interner->cap * sizeof(unsigned)));
+    }
+    int id = interner->count++;
+    char* copy = arenaAlloc(interner->arena, length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    interner->strings[id] = copy;
+    interner->hashes[id] = hash;
+
+    if (interner->count * 2 > interner->indexCap) {
+        rehash(interner);
+    } else {
+        interner->index[h] = id + 1;
+    }
+    return id;
+}
+
+// Function to get the single stored copy of a string
+char* internString(Interner* interner, const char* text, size_t length) {
+    return interner->strings[intern(interner, text, length)];
+}
+
+// Function to free the tables, the strings go with the arena
+void internFree(Interner* interner) {
+    free(interner->strings);
+    free(interner->hashes);
+    free(interner->index);
+    internInit(interner, interner->arena);
+}
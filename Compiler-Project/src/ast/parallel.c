@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "alloc.h"
+#include "parallel.h"
+#include "bounds.h"
+#include "output.h"
+#include "simulation.h"
+
+#define LOOP_WEIGHT 16              // iterations assumed for a loop nested in the body
+#define MAX_WORK (1 << 24)
+
+// How the body writes a scalar
+enum {
+    WRITE_PLAIN = 1,        // :=
+    WRITE_SUM = 2,          // += or -=
+    WRITE_PRODUCT = 4,      // *=
+    WRITE_OTHER = 8         // /=, %= or the counter of a nested for loop
+};
+
+// Array accesses
+enum {
+    ACCESS_SEEN = 1,
+    ACCESS_MIXED = 2,       // accessed with more than one offset
+    ACCESS_WRITTEN = 4
+};
+
+// Scratch state of the loop being analyzed; the slot arrays are cleared through
+// the touched list after every loop
+typedef struct {
+    SymbolTable* symbols;
+    int counter;
+    int ok;
+    long long work;
+    long long weight;       // iterations of the innermost loop around the node, per iteration of the loop
+    unsigned char* writes;  // slot -> WRITE_* bits
+    unsigned char* reads;   // slot -> 1 if the body reads the scalar
+    unsigned char* access;  // slot -> ACCESS_* bits
+    int* offset;            // slot -> k of the first access
+    ParallelKind* kind;     // slot -> how a written scalar is combined
+    unsigned char* defined; // slot -> 1 once the top level of the body has assigned it
+    int* touched;
+    int ntouched;
+    int* inner;             // slot -> nested for loops around the node counting with it, read walk
+    int low, high;
+} Scan;
+
+// A divisor that can neither be zero nor overflow the quotient
+static int safeDivisor(ASTNode* node) {
+    int value;
+    return literalValue(node, &value) && value != 0 && value != -1;
+}
+
+static void touch(Scan* s, int slot) {
+    if (!s->writes[slot] && !s->reads[slot] && !s->access[slot]) s->touched[s->ntouched++] = slot;
+}
+
+static void noteRead(Scan* s, int slot) {
+    touch(s, slot);
+    s->reads[slot] = 1;
+}
+
+static void noteWrite(Scan* s, int slot, int how) {
+    touch(s, slot);
+    s->writes[slot] |= how;
+}
+
+// Function to check an element access a[counter + k]: the counter takes the values
+// [-k, length - 1 - k] without leaving the array
+static void scanElement(Scan* s, ASTNode* node, int write) {
+    int slot = node->data.index.array->data.var.slot;
+    int k;
+    if (slot < 0 || !s->symbols->length[slot] || !counterOffset(node->data.index.index, s->counter, &k)) {
+        s->ok = 0;
+        return;
+    }
+    touch(s, slot);
+    if (!s->access[slot]) s->offset[slot] = k;
+    else if (s->offset[slot] != k) s->access[slot] |= ACCESS_MIXED;
+    s->access[slot] |= ACCESS_SEEN | (write ? ACCESS_WRITTEN : 0);
+    if (-k > s->low) s->low = -k;
+    if (s->symbols->length[slot] - 1 - k < s->high) s->high = s->symbols->length[slot] - 1 - k;
+}
+
+static void scanExpr(Scan* s, ASTNode* node) {
+    if (!s->ok) return;
+    int value;
+    s->work += s->weight;
+    switch (node->type) {
+        case NODE_NUMBER:
+            if (!literalValue(node, &value)) s->ok = 0;
+            return;
+        case NODE_VAR: {
+            int slot = node->data.var.slot;
+            if (slot < 0 || s->symbols->length[slot] || s->symbols->is_char[slot]) s->ok = 0;
+            else noteRead(s, slot);
+            return;
+        }
+        case NODE_INDEX:
+            scanElement(s, node, 0);
+            if (s->ok && s->symbols->is_char[node->data.index.array->data.var.slot]) s->ok = 0;
+            return;
+        case NODE_OP:
+            switch (node->data.operator.op) {
+                case OPR_ADD:
+                case OPR_SUB:
+                case OPR_MUL:
+                    break;
+                case OPR_DIV:
+                case OPR_MOD:
+                    if (!safeDivisor(node->data.operator.right)) s->ok = 0;
+                    break;
+                default:
+                    s->ok = 0;
+                    return;
+            }
+            scanExpr(s, node->data.operator.left);
+            scanExpr(s, node->data.operator.right);
+            return;
+        default:
+            s->ok = 0;
+    }
+}
+
+static void scanCondition(Scan* s, ASTNode* node) {
+    if (!node || node->type != NODE_RELOP) {
+        s->ok = 0;
+        return;
+    }
+    switch (node->data.operator.op) {
+        case OPR_LT:
+        case OPR_GT:
+        case OPR_LE:
+        case OPR_GE:
+        case OPR_EQ:
+        case OPR_NE:
+            scanExpr(s, node->data.operator.left);
+            scanExpr(s, node->data.operator.right);
+            break;
+        default:
+            s->ok = 0;
+    }
+}
+
+static void scanAssign(Scan* s, ASTNode* node) {
+    ASTNode* left = node->data.operator.left;
+    ASTNode* right = node->data.operator.right;
+    Operator op = node->data.operator.op;
+    int isChar = right->type == NODE_CHAR;
+    int how;
+    switch (op) {
+        case OPR_ASSIGN: how = WRITE_PLAIN; break;
+        case OPR_ADD_ASSIGN:
+        case OPR_SUB_ASSIGN: how = WRITE_SUM; break;
+        case OPR_MUL_ASSIGN: how = WRITE_PRODUCT; break;
+        case OPR_DIV_ASSIGN:
+        case OPR_MOD_ASSIGN: how = safeDivisor(right) ? WRITE_OTHER : 0; break;
+        default: how = 0; break;
+    }
+    if (!how || (isChar && op != OPR_ASSIGN)) {
+        s->ok = 0;
+        return;
+    }
+    if (!isChar) scanExpr(s, right);
+    if (!s->ok) return;
+    s->work += s->weight;
+    if (left->type == NODE_INDEX) {
+        scanElement(s, left, 1);
+        if (s->ok && s->symbols->is_char[left->data.index.array->data.var.slot] != isChar) s->ok = 0;
+        return;
+    }
+    int slot = left->data.var.slot;
+    if (slot < 0 || slot == s->counter || s->symbols->length[slot] || s->symbols->is_char[slot] != isChar) {
+        s->ok = 0;
+        return;
+    }
+    noteWrite(s, slot, how);
+}
+
+static void scanStatement(Scan* s, ASTNode* node) {
+    if (!node || !s->ok) return;
+    switch (node->type) {
+        case NODE_STMTS:
+            for (int i = 0; i < node->data.statements.count; i++) scanStatement(s, node->data.statements.statements[i]);
+            break;
+        case NODE_ASSIGN:
+            scanAssign(s, node);
+            break;
+        case NODE_IF:
+            scanCondition(s, node->data.if_while_block.condition);
+            scanStatement(s, node->data.if_while_block.stmts);
+            break;
+        case NODE_IF_ELSE:
+            scanCondition(s, node->data.if_else_block.condition);
+            scanStatement(s, node->data.if_else_block.stmts);
+            scanStatement(s, node->data.if_else_block.else_part);
+            break;
+        case NODE_WHILE: {
+            long long weight = s->weight;
+            s->weight = weight * LOOP_WEIGHT < MAX_WORK ? weight * LOOP_WEIGHT : MAX_WORK;
+            scanCondition(s, node->data.if_while_block.condition);
+            scanStatement(s, node->data.if_while_block.stmts);
+            s->weight = weight;
+            break;
+        }
+        case NODE_FOR: {
+            ASTNode* init = node->data.for_loop_block.init;
+            if (init->data.operator.op != OPR_ASSIGN || init->data.operator.left->type != NODE_VAR) {
+                s->ok = 0;
+                break;
+            }
+            scanAssign(s, init);
+            if (!s->ok) break;
+            noteWrite(s, init->data.operator.left->data.var.slot, WRITE_OTHER);
+            long long weight = s->weight;
+            s->weight = weight * LOOP_WEIGHT < MAX_WORK ? weight * LOOP_WEIGHT : MAX_WORK;
+            scanExpr(s, node->data.for_loop_block.limit);
+            scanExpr(s, node->data.for_loop_block.update->data.operator.left);
+            scanStatement(s, node->data.for_loop_block.stmts);
+            s->weight = weight;
+            break;
+        }
+        case NODE_PRINT: {
+            PrintTemplate* t = node->data.print_scan_stmt.print;
+            if (!t || t->error) {
+                s->ok = 0;
+                break;
+            }
+            for (ll* arg = node->data.print_scan_stmt.args; arg; arg = arg->next) noteRead(s, arg->slot);
+            s->work += s->weight * (t->nparts + 1);
+            break;
+        }
+        default:
+            // scans wait for input in program order
+            s->ok = 0;
+            break;
+    }
+}
+
+// Function to tell whether a written scalar still holds the value of an earlier
+// iteration when the node reads it
+static int exposed(Scan* s, int slot) {
+    return s->writes[slot] && s->kind[slot] == PARALLEL_PRIVATE && !s->defined[slot] && !s->inner[slot];
+}
+
+static void checkReads(Scan* s, ASTNode* node) {
+    if (!node || !s->ok) return;
+    switch (node->type) {
+        case NODE_VAR:
+            if (node->data.var.slot >= 0 && exposed(s, node->data.var.slot)) s->ok = 0;
+            return;
+        case NODE_INDEX:
+            checkReads(s, node->data.index.index);
+            return;
+        case NODE_ASSIGN: {
+            ASTNode* left = node->data.operator.left;
+            checkReads(s, node->data.operator.right);
+            if (left->type == NODE_INDEX) checkReads(s, left);
+            else if (node->data.operator.op != OPR_ASSIGN) checkReads(s, left);
+            return;
+        }
+        case NODE_STMTS:
+            for (int i = 0; i < node->data.statements.count; i++) checkReads(s, node->data.statements.statements[i]);
+            return;
+        case NODE_FOR: {
+            // the counter of a nested loop is assigned before anything in the loop reads it
+            int counter = node->data.for_loop_block.init->data.operator.left->data.var.slot;
+            checkReads(s, node->data.for_loop_block.init->data.operator.right);
+            s->inner[counter]++;
+            checkReads(s, node->data.for_loop_block.limit);
+            checkReads(s, node->data.for_loop_block.update);
+            checkReads(s, node->data.for_loop_block.stmts);
+            s->inner[counter]--;
+            return;
+        }
+        case NODE_PRINT:
+            for (ll* arg = node->data.print_scan_stmt.args; arg; arg = arg->next) {
+                if (exposed(s, arg->slot)) s->ok = 0;
+            }
+            return;
+        default: {
+            ASTNode* children[4];
+            int n = childNodes(node, children);
+            for (int i = 0; i < n; i++) checkReads(s, children[i]);
+            return;
+        }
+    }
+}
+
+// Function to check that every iteration assigns its private scalars before reading
+// them: a scalar is defined by a := or a nested for loop at the top level of the body
+static void checkPrivates(Scan* s, ASTNode* body) {
+    int count = body->type == NODE_STMTS ? body->data.statements.count : 1;
+    for (int i = 0; i < count && s->ok; i++) {
+        ASTNode* node = body->type == NODE_STMTS ? body->data.statements.statements[i] : body;
+        if (!node) continue;
+        checkReads(s, node);
+        if (node->type == NODE_ASSIGN && node->data.operator.op == OPR_ASSIGN && node->data.operator.left->type == NODE_VAR)
+            s->defined[node->data.operator.left->data.var.slot] = 1;
+        if (node->type == NODE_FOR) s->defined[node->data.for_loop_block.init->data.operator.left->data.var.slot] = 1;
+    }
+    for (int i = 0; i < s->ntouched && s->ok; i++) {
+        int slot = s->touched[i];
+        if (s->writes[slot] && s->kind[slot] == PARALLEL_PRIVATE && !s->defined[slot]) s->ok = 0;
+    }
+}
+
+// Function to decide whether a counted loop is parallel, returns its description or NULL
+static ParallelLoop* analyzeLoop(Arena* arena, Scan* s, ASTNode* node) {
+    ASTNode* body = node->data.for_loop_block.stmts;
+    s->counter = node->data.for_loop_block.init->data.operator.left->data.var.slot;
+    if (!body || s->symbols->is_char[s->counter]) return NULL;
+    s->ok = 1;
+    s->work = 0;
+    s->weight = 1;
+    s->ntouched = 0;
+    s->low = INT_MIN;
+    s->high = INT_MAX;
+    scanStatement(s, body);
+
+    int nslots = 0;
+    for (int i = 0; i < s->ntouched && s->ok; i++) {
+        int slot = s->touched[i];
+        // iterations write disjoint elements and read no element another one writes
+        if ((s->access[slot] & ACCESS_WRITTEN) && (s->access[slot] & ACCESS_MIXED)) s->ok = 0;
+        if (!s->writes[slot]) continue;
+        nslots++;
+        if (s->reads[slot] || s->symbols->is_char[slot]) s->kind[slot] = PARALLEL_PRIVATE;
+        else if (!(s->writes[slot] & ~WRITE_SUM)) s->kind[slot] = PARALLEL_SUM;
+        else if (s->writes[slot] == WRITE_PRODUCT) s->kind[slot] = PARALLEL_PRODUCT;
+        else s->kind[slot] = PARALLEL_PRIVATE;
+    }
+    if (s->ok) checkPrivates(s, body);
+
+    ParallelLoop* loop = NULL;
+    if (s->ok) {
+        loop = arenaAlloc(arena, sizeof(ParallelLoop));
+        loop->slots = arenaAlloc(arena, (nslots ? nslots : 1) * sizeof(int));
+        loop->kinds = arenaAlloc(arena, (nslots ? nslots : 1) * sizeof(ParallelKind));
+        loop->nslots = 0;
+        for (int i = 0; i < s->ntouched; i++) {
+            int slot = s->touched[i];
+            if (!s->writes[slot]) continue;
+            loop->slots[loop->nslots] = slot;
+            loop->kinds[loop->nslots++] = s->kind[slot];
+        }
+        loop->low = s->low;
+        loop->high = s->high;
+        loop->work = s->work < MAX_WORK ? (int)s->work : MAX_WORK;
+    }
+    for (int i = 0; i < s->ntouched; i++) {
+        int slot = s->touched[i];
+        s->writes[slot] = s->reads[slot] = s->access[slot] = s->defined[slot] = 0;
+    }
+    return loop;
+}
+
+static void markNode(Arena* arena, Scan* s, ASTNode* node) {
+    if (!node) return;
+    if (node->type == NODE_STMTS) {
+        for (int i = 0; i < node->data.statements.count; i++) markNode(arena, s, node->data.statements.statements[i]);
+        return;
+    }
+    if (node->type == NODE_FOR && node->data.for_loop_block.counted)
+        node->data.for_loop_block.parallel = analyzeLoop(arena, s, node);
+    ASTNode* children[4];
+    int n = childNodes(node, children);
+    for (int i = 0; i < n; i++) markNode(arena, s, children[i]);
+}
+
+// Function to find the counted for loops whose iterations can run on separate threads
+void markParallelLoops(Arena* arena, ASTNode* root, SymbolTable* symbols) {
+    if (!root || root->type != NODE_PROG) return;
+    int n = symbols->count + 1;
+    Scan s = {0};
+    s.symbols = symbols;
+    s.writes = allocArray(n, 1);
+    s.reads = allocArray(n, 1);
+    s.access = allocArray(n, 1);
+    s.offset = allocArray(n, sizeof(int));
+    s.kind = allocArray(n, sizeof(ParallelKind));
+    s.defined = allocArray(n, 1);
+    s.touched = allocArray(n, sizeof(int));
+    s.inner = allocArray(n, sizeof(int));
+    markNode(arena, &s, root->data.program.stmtblock);
+    free(s.writes);
+    free(s.reads);
+    free(s.access);
+    free(s.offset);
+    free(s.kind);
+    free(s.defined);
+    free(s.touched);
+    free(s.inner);
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "unit.h"
+
+// Scanned source is given back to the kernel in chunks of this size
+#define SOURCE_RELEASE_CHUNK ((size_t)1 << 20)
+
+// Function to create an empty compilation unit for a source file
+CompilationUnit* createCompilationUnit(const char* path) {
+    CompilationUnit* unit = (CompilationUnit*)calloc(1, sizeof(CompilationUnit));
+    if (!unit) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    arenaInit(&unit->arena);
+    internInit(&unit->names, &unit->arena);
+    unit->path = path;
+    return unit;
+}
+
+// Function to release a unit, the whole AST goes with its arena
+void freeCompilationUnit(CompilationUnit* unit) {
+    if (!unit) return;
+    freeNative(unit->native);
+    freeBytecode(unit->program);
+    freeTAC(unit->tac);
+    freeSymbolTable(unit->symbols);
+    internFree(&unit->names);
+    arenaFree(&unit->arena);
+    free(unit);
+}
+
+// Function to map a source file in place. The file pages are mapped over an
+// anonymous reservation, so the bytes after the end of the file read as zero.
+int mapSourceFile(const char* path, SourceMap* map) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return 1;
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t length = (size_t)st.st_size;
+    size_t mapped = (length + 2 + page - 1) / page * page;
+    char* text = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (text == MAP_FAILED) {
+        close(fd);
+        return 1;
+    }
+    if (length && mmap(text, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(text, mapped);
+        close(fd);
+        return 1;
+    }
+    close(fd);
+    madvise(text, mapped, MADV_SEQUENTIAL);
+    *map = (SourceMap){text, length, mapped, 0};
+    return 0;
+}
+
+// Function to drop the pages the scanner has moved past. flex writes a NUL after
+// every token, which gives each scanned page a private copy; releasing them keeps
+// the resident size bounded instead of growing with the file.
+void releaseScannedSource(SourceMap* map, const char* position) {
+    if (!map->text || position < map->text || position >= map->text + map->mapped) return;
+    size_t scanned = (size_t)(position - map->text) & ~(SOURCE_RELEASE_CHUNK - 1);
+    if (scanned < map->released + SOURCE_RELEASE_CHUNK) return;
+    madvise(map->text + map->released, scanned - map->released, MADV_DONTNEED);
+    map->released = scanned;
+}
+
+void unmapSourceFile(SourceMap* map) {
+    if (map->text) munmap(map->text, map->mapped);
+    map->text = NULL;
+}
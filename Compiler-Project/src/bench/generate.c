@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Synthetic program generator for the benchmarks (make bench). The programs are
+// valid, always terminate and never stop on a run-time error: loop counters are
+// only changed by their loop, divisors are non-zero literals and every assigned
+// value is reduced modulo 997 so no expression overflows.
+//
+// Usage: generate_program [--decls=<n>] [--stmts=<n>] [--loop-depth=<n>] [--expr-depth=<n>]
+//                         [--io=<percent>] [--trips=<n>] [--seed=<n>] [--input=<file>]
+// The program is written to stdout. Scan statements are only generated when
+// --input names the file that receives the values they read.
+
+#define MAX_LOOP_DEPTH 8
+#define MAX_EXPR_DEPTH 16
+#define MAX_BODY 10         // statements of one loop or branch body
+#define WRAP_DEPTH 3        // expression levels between two reductions modulo 997
+
+typedef struct {
+    int decls;              // scalar declarations, one in eight is a char
+    int stmts;              // statements, counting loop and if statements themselves
+    int loopDepth;
+    int exprDepth;
+    int io;                 // percent of simple statements that print or scan
+    int trips;              // iterations of every loop
+    unsigned long long seed;
+    const char* inputPath;
+} Options;
+
+static Options options = {200, 1000, 2, 4, 10, 10, 1, NULL};
+static unsigned long long state;
+static FILE* input;
+static int nints, nchars;
+
+// xorshift64*, the same sequence on every platform
+static unsigned random32(void) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (unsigned)((state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static int randomBelow(int n) {
+    return n > 0 ? (int)(random32() % (unsigned)n) : 0;
+}
+
+static void indent(int depth) {
+    for (int i = 0; i < depth; i++) fputs("  ", stdout);
+}
+
+// Function to write an int expression, every WRAP_DEPTH levels are reduced modulo 997
+static void genExpr(int depth) {
+    if (depth == 0 || randomBelow(10) < 3) {
+        if (randomBelow(2)) printf("v%d", randomBelow(nints));
+        else printf("(%d, 10)", randomBelow(100));
+        return;
+    }
+    int wrap = depth % WRAP_DEPTH == 0;
+    if (wrap) fputs("(", stdout);
+    switch (randomBelow(5)) {
+        case 0:
+        case 1:
+            genExpr(depth - 1);
+            fputs(randomBelow(2) ? " + " : " - ", stdout);
+            genExpr(depth - 1);
+            break;
+        case 2:
+            genExpr(depth - 1);
+            printf(" * (%d, 10)", 1 + randomBelow(9));
+            break;
+        case 3:
+            genExpr(depth - 1);
+            printf(" / (%d, 10)", 1 + randomBelow(9));
+            break;
+        default:
+            fputs("(", stdout);
+            genExpr(depth - 1);
+            printf(") %% (%d, 10)", 1 + randomBelow(99));
+            break;
+    }
+    if (wrap) fputs(") % (997, 10)", stdout);
+}
+
+static void genCondition(void) {
+    static const char* relops[] = {"<", ">", "<=", ">=", "=", "<>"};
+    genExpr(options.exprDepth / 2);
+    printf(" %s ", relops[randomBelow(6)]);
+    genExpr(options.exprDepth / 2);
+}
+
+// Function to write a print or, at the top level, a scan of one to three ints. Scans
+// run exactly once there, so the input holds their values in order; a scan does not
+// skip white space before its first value.
+static void genIO(int depth, int nested) {
+    int count = 1 + randomBelow(3);
+    int scan = !nested && input && randomBelow(2);
+    indent(depth);
+    fputs(scan ? "scan(\"" : "print(\"", stdout);
+    for (int i = 0; i < count; i++) printf(scan ? "%s@" : "%sv=@", i ? " " : "");
+    fputs("\"", stdout);
+    for (int i = 0; i < count; i++) {
+        printf(", v%d", randomBelow(nints));
+        if (scan) fprintf(input, "%s(%d, 10)", i ? " " : "", randomBelow(997));
+    }
+    fputs(");\n", stdout);
+}
+
+static void genSimple(int depth, int nested) {
+    if (randomBelow(100) < options.io) {
+        genIO(depth, nested);
+        return;
+    }
+    indent(depth);
+    switch (randomBelow(8)) {
+        case 0:
+            printf("c%d := '%c';\n", randomBelow(nchars), 'a' + randomBelow(26));
+            break;
+        case 1:
+            printf("v%d %%= (%d, 10);\n", randomBelow(nints), 1 + randomBelow(99));
+            break;
+        case 2:
+            printf("v%d /= (%d, 10);\n", randomBelow(nints), 1 + randomBelow(9));
+            break;
+        default:
+            printf("v%d := (", randomBelow(nints));
+            genExpr(options.exprDepth);
+            fputs(") % (997, 10);\n", stdout);
+            break;
+    }
+}
+
+static int genBlock(int budget, int depth, int loops, int nested);
+
+// Function to write a body of at most budget statements, returns the statements used
+static int genBody(int budget, int depth, int loops, int nested) {
+    int size = 1 + randomBelow(budget < MAX_BODY ? budget : MAX_BODY);
+    return genBlock(size, depth, loops, nested);
+}
+
+// Function to write a loop at nesting level loops, its counter is l<loops> or w<loops>
+static int genLoop(int budget, int depth, int loops) {
+    int used;
+    indent(depth);
+    switch (randomBelow(3)) {
+        case 0:
+            printf("for l%d := (0, 10) to (%d, 10) inc (1, 10) do\n", loops, options.trips);
+            indent(depth);
+            puts("begin");
+            used = genBody(budget, depth + 1, loops + 1, 1);
+            break;
+        case 1:
+            printf("for l%d := (%d, 10) to (0, 10) dec (1, 10) do\n", loops, options.trips);
+            indent(depth);
+            puts("begin");
+            used = genBody(budget, depth + 1, loops + 1, 1);
+            break;
+        default:
+            printf("w%d := (0, 10);\n", loops);
+            indent(depth);
+            printf("while (w%d < (%d, 10)) do\n", loops, options.trips);
+            indent(depth);
+            puts("begin");
+            used = genBody(budget - 1, depth + 1, loops + 1, 1) + 1;
+            indent(depth + 1);
+            printf("w%d += (1, 10);\n", loops);
+            break;
+    }
+    indent(depth);
+    puts("end;");
+    return used + 1;
+}
+
+static int genIf(int budget, int depth, int loops) {
+    indent(depth);
+    fputs("if (", stdout);
+    genCondition();
+    puts(") begin");
+    int used = genBody(budget, depth + 1, loops, 1);
+    indent(depth);
+    if (budget - used > 0 && randomBelow(2)) {
+        puts("end");
+        indent(depth);
+        puts("else begin");
+        used += genBody(budget - used, depth + 1, loops, 1);
+        indent(depth);
+    }
+    puts("end;");
+    return used + 1;
+}
+
+// Function to write budget statements at one nesting level, nested is 0 only at the top level
+static int genBlock(int budget, int depth, int loops, int nested) {
+    int used = 0;
+    while (used < budget) {
+        int left = budget - used;
+        int kind = randomBelow(12);
+        if (left > 2 && loops < options.loopDepth && kind < 2) used += genLoop(left - 1, depth, loops);
+        else if (left > 1 && kind == 2) used += genIf(left - 1, depth, loops);
+        else {
+            genSimple(depth, nested);
+            used++;
+        }
+    }
+    return used;
+}
+
+static int intOption(const char* arg, const char* name, int max, int* value) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) != 0) return 0;
+    char* end;
+    long n = strtol(arg + length, &end, 10);
+    if (*end || n < 0 || n > max) {
+        fprintf(stderr, "Invalid value in %s\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    *value = (int)n;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        int seed;
+        if (intOption(argv[i], "--decls=", 10000000, &options.decls) ||
+            intOption(argv[i], "--stmts=", 100000000, &options.stmts) ||
+            intOption(argv[i], "--loop-depth=", MAX_LOOP_DEPTH, &options.loopDepth) ||
+            intOption(argv[i], "--expr-depth=", MAX_EXPR_DEPTH, &options.exprDepth) ||
+            intOption(argv[i], "--io=", 100, &options.io) ||
+            intOption(argv[i], "--trips=", 1000000, &options.trips)) {
+            continue;
+        }
+        if (intOption(argv[i], "--seed=", 0x7fffffff, &seed)) {
+            options.seed = (unsigned long long)seed;
+        } else if (strncmp(argv[i], "--input=", 8) == 0 && argv[i][8]) {
+            options.inputPath = argv[i] + 8;
+        } else {
+            fprintf(stderr, "Usage: %s [--decls=<n>] [--stmts=<n>] [--loop-depth=<n>] [--expr-depth=<n>] "
+                            "[--io=<percent>] [--trips=<n>] [--seed=<n>] [--input=<file>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (options.inputPath && !(input = fopen(options.inputPath, "w"))) {
+        perror("Error opening input file");
+        return 1;
+    }
+    state = options.seed * 0x9E3779B97F4A7C15ULL + 1;
+    nchars = options.decls / 8 > 0 ? options.decls / 8 : 1;
+    nints = options.decls - nchars > 0 ? options.decls - nchars : 1;
+
+    puts("begin program:");
+    puts("begin VarDecl:");
+    for (int i = 0; i < nints; i++) printf("(v%d, int);\n", i);
+    for (int i = 0; i < nchars; i++) printf("(c%d, char);\n", i);
+    for (int i = 0; i < options.loopDepth; i++) printf("(l%d, int);\n(w%d, int);\n", i, i);
+    puts("end VarDecl");
+    genBlock(options.stmts, 0, 0, 0);
+    puts("end program");
+
+    if (input) {
+        fputc('\n', input);
+        fclose(input);
+    }
+    return 0;
+}
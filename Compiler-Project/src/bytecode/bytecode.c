@@ -0,0 +1,656 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "simulation.h"
+#include "bounds.h"
+
+// While compiling, slot operands carry a tag for their frame region; they are
+// relocated to absolute slots once the sizes of all regions are known.
+#define VAR_TAG    (0 << 28)
+#define TEMP_TAG   (1 << 28)
+#define CONST_TAG  (2 << 28)
+#define HIDDEN_TAG (3 << 28)
+#define TAG_MASK   (3 << 28)
+
+// Which operands of an instruction are frame slots
+#define SLOT_A 1
+#define SLOT_B 2
+#define SLOT_C 4
+
+static const struct {
+    const char* name;
+    int slots;
+} opInfo[OP_COUNT] = {
+    [OP_HALT]  = {"halt", 0},
+    [OP_MOV]   = {"mov", SLOT_A | SLOT_B},
+    [OP_SET]   = {"set", SLOT_A | SLOT_B},
+    [OP_ADD]   = {"add", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SUB]   = {"sub", SLOT_A | SLOT_B | SLOT_C},
+    [OP_MUL]   = {"mul", SLOT_A | SLOT_B | SLOT_C},
+    [OP_DIV]   = {"div", SLOT_A | SLOT_B | SLOT_C},
+    [OP_MOD]   = {"mod", SLOT_A | SLOT_B | SLOT_C},
+    [OP_DIVZ]  = {"divz", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SLT]   = {"slt", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SLE]   = {"sle", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SGT]   = {"sgt", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SGE]   = {"sge", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SEQ]   = {"seq", SLOT_A | SLOT_B | SLOT_C},
+    [OP_SNE]   = {"sne", SLOT_A | SLOT_B | SLOT_C},
+    [OP_LOAD]  = {"load", SLOT_A | SLOT_B},
+    [OP_LOADU] = {"loadu", SLOT_A | SLOT_B},
+    [OP_STORE] = {"store", SLOT_B | SLOT_C},
+    [OP_STOREU] = {"storeu", SLOT_B | SLOT_C},
+    [OP_JMP]   = {"jmp", 0},
+    [OP_JLT]   = {"jlt", SLOT_B | SLOT_C},
+    [OP_JLE]   = {"jle", SLOT_B | SLOT_C},
+    [OP_JGT]   = {"jgt", SLOT_B | SLOT_C},
+    [OP_JGE]   = {"jge", SLOT_B | SLOT_C},
+    [OP_JEQ]   = {"jeq", SLOT_B | SLOT_C},
+    [OP_JNE]   = {"jne", SLOT_B | SLOT_C},
+    [OP_PRINT] = {"print", 0},
+    [OP_SCAN]  = {"scan", 0},
+    [OP_MSG]   = {"msg", 0},
+    [OP_PFOR]  = {"pfor", 0},
+};
+
+// Compiler state for one program
+typedef struct {
+    BytecodeProgram* prog;
+    int codeCap, ioCap, msgCap, parallelCap, nodesCap;
+    int temps;          // temporaries in use by the current statement
+    int* hiddenOf;      // hidden loop counter of each char variable, -1 if none
+    ASTNode* fast[MAX_HOISTED_LOOPS];   // loops whose copy without bounds checks is being compiled
+    int nfast;
+    ConstPool consts;
+    ASTNode** parallelNodes;    // loop of each parallel descriptor
+    int inChunk;        // compiling chunk code, where loops are not split again
+} Compiler;
+
+static int emit(Compiler* c, int op, int a, int b, int d) {
+    BytecodeProgram* p = c->prog;
+    p->code = growArray(p->code, &c->codeCap, p->ncode + 1, sizeof(Instr));
+    p->code[p->ncode] = (Instr){op, a, b, d};
+    return p->ncode++;
+}
+
+static void patch(Compiler* c, int at, int target) {
+    c->prog->code[at].a = target;
+}
+
+static int newTempSlot(Compiler* c) {
+    int t = c->temps++;
+    if (c->temps > c->prog->ntemps) c->prog->ntemps = c->temps;
+    return TEMP_TAG | t;
+}
+
+static void rehashConsts(ConstPool* pool, BytecodeProgram* p) {
+    int cap = pool->hashCap ? pool->hashCap * 2 : 64;
+    int* keys = malloc(cap * sizeof(int));
+    int* idx = malloc(cap * sizeof(int));
+    if (!keys || !idx) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < cap; i++) idx[i] = -1;
+    for (int i = 0; i < p->nconsts; i++) {
+        unsigned h = (unsigned)p->consts[i] * 2654435761u & (cap - 1);
+        while (idx[h] != -1) h = (h + 1) & (cap - 1);
+        keys[h] = p->consts[i];
+        idx[h] = i;
+    }
+    free(pool->keys);
+    free(pool->idx);
+    pool->keys = keys;
+    pool->idx = idx;
+    pool->hashCap = cap;
+}
+
+int internConst(ConstPool* pool, BytecodeProgram* p, int value) {
+    if ((p->nconsts + 1) * 2 > pool->hashCap) rehashConsts(pool, p);
+    unsigned h = (unsigned)value * 2654435761u & (pool->hashCap - 1);
+    while (pool->idx[h] != -1) {
+        if (pool->keys[h] == value) return pool->idx[h];
+        h = (h + 1) & (pool->hashCap - 1);
+    }
+    p->consts = growArray(p->consts, &pool->cap, p->nconsts + 1, sizeof(int));
+    p->consts[p->nconsts] = value;
+    pool->keys[h] = value;
+    pool->idx[h] = p->nconsts;
+    return p->nconsts++;
+}
+
+void freeConstPool(ConstPool* pool) {
+    free(pool->keys);
+    free(pool->idx);
+}
+
+static int constSlot(Compiler* c, int value) {
+    return CONST_TAG | internConst(&c->consts, c->prog, value);
+}
+
+// Emits a diagnostic that fires when (and only when) this point is executed
+static void emitMessage(Compiler* c, int to_stderr, int fatal, const char* fmt, const char* arg) {
+    BytecodeProgram* p = c->prog;
+    int size = snprintf(NULL, 0, fmt, arg) + 1;
+    char* text = malloc(size);
+    snprintf(text, size, fmt, arg);
+    p->msgs = growArray(p->msgs, &c->msgCap, p->nmsgs + 1, sizeof(Message));
+    p->msgs[p->nmsgs] = (Message){text, to_stderr, fatal};
+    emit(c, OP_MSG, p->nmsgs++, 0, 0);
+}
+
+// Slot holding the integer counter of a for loop over a char variable
+static int hiddenSlot(Compiler* c, int var) {
+    if (!c->hiddenOf) {
+        c->hiddenOf = malloc(c->prog->nvars * sizeof(int));
+        for (int i = 0; i < c->prog->nvars; i++) c->hiddenOf[i] = -1;
+    }
+    if (c->hiddenOf[var] == -1) c->hiddenOf[var] = c->prog->nhidden++;
+    return HIDDEN_TAG | c->hiddenOf[var];
+}
+
+static int arithOp(Operator op) {
+    switch (op) {
+        case OPR_ADD: return OP_ADD;
+        case OPR_SUB: return OP_SUB;
+        case OPR_MUL: return OP_MUL;
+        case OPR_DIV: return OP_DIV;
+        case OPR_MOD: return OP_MOD;
+        default:      return -1;
+    }
+}
+
+// Jump taken when the relational operator holds
+static int relJump(Operator op) {
+    switch (op) {
+        case OPR_LT: return OP_JLT;
+        case OPR_GT: return OP_JGT;
+        case OPR_LE: return OP_JLE;
+        case OPR_GE: return OP_JGE;
+        case OPR_EQ: return OP_JEQ;
+        case OPR_NE: return OP_JNE;
+        default:     return -1;
+    }
+}
+
+static int negateJump(int op) {
+    switch (op) {
+        case OP_JLT: return OP_JGE;
+        case OP_JGE: return OP_JLT;
+        case OP_JGT: return OP_JLE;
+        case OP_JLE: return OP_JGT;
+        case OP_JEQ: return OP_JNE;
+        default:     return OP_JEQ;
+    }
+}
+
+// An access needs no bounds check in the fast copy of the loop it was hoisted to
+static int uncheckedAccess(Compiler* c, ASTNode* node) {
+    for (int i = 0; i < c->nfast; i++) {
+        if (c->fast[i] == node->data.index.loop) return 1;
+    }
+    return 0;
+}
+
+// Compiles an expression and returns the slot holding its value
+static int compileExpr(Compiler* c, ASTNode* node) {
+    if (!node) return constSlot(c, 0);
+
+    switch (node->type) {
+        case NODE_NUMBER: {
+            int value;
+            char msg[128];
+            if (tryConvertToDecimal(node->data.integer.value, node->data.integer.base, &value, msg, sizeof(msg)))
+                return constSlot(c, value);
+            emitMessage(c, 0, 1, "%s", msg);
+            return newTempSlot(c);
+        }
+
+        case NODE_VAR: {
+            int v = node->data.var.slot;
+            if (v == -1) {
+                emitMessage(c, 1, 1, "Variable %s not declared!\n", node->data.var.identifier);
+                return newTempSlot(c);
+            }
+            if (c->prog->symbols->length[v]) {
+                emitMessage(c, 1, 1, "Type Error: Cannot use array '%s' without an index\n", node->data.var.identifier);
+                return newTempSlot(c);
+            }
+            if (c->prog->symbols->is_char[v]) {
+                emitMessage(c, 1, 1, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", node->data.var.identifier);
+                return newTempSlot(c);
+            }
+            return VAR_TAG | v;
+        }
+
+        case NODE_INDEX: {
+            ASTNode* array = node->data.index.array;
+            int v = array->data.var.slot;
+            if (v == -1) {
+                emitMessage(c, 1, 1, "Variable %s not declared!\n", array->data.var.identifier);
+                return newTempSlot(c);
+            }
+            if (!c->prog->symbols->length[v]) {
+                emitMessage(c, 1, 1, "Type Error: Variable '%s' is not an array\n", array->data.var.identifier);
+                return newTempSlot(c);
+            }
+            if (c->prog->symbols->is_char[v]) {
+                emitMessage(c, 1, 1, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", array->data.var.identifier);
+                return newTempSlot(c);
+            }
+            int mark = c->temps;
+            int index = compileExpr(c, node->data.index.index);
+            c->temps = mark;
+            int dst = newTempSlot(c);
+            emit(c, uncheckedAccess(c, node) ? OP_LOADU : OP_LOAD, dst, index, v);
+            return dst;
+        }
+
+        case NODE_OP: {
+            int mark = c->temps;
+            int left = compileExpr(c, node->data.operator.left);
+            int right = compileExpr(c, node->data.operator.right);
+            int op = arithOp(node->data.operator.op);
+            c->temps = mark;
+            int dst = newTempSlot(c);
+            if (op == -1) {
+                emitMessage(c, 1, 1, "Unknown operator: %s\n", operatorName(node->data.operator.op));
+                return dst;
+            }
+            emit(c, op, dst, left, right);
+            return dst;
+        }
+
+        default:
+            emitMessage(c, 1, 1, "Unknown expression type!\n", NULL);
+            return newTempSlot(c);
+    }
+}
+
+// Compiles a condition into a jump to target taken when the condition equals whenTrue.
+// Returns the index of the jump so that forward targets can be patched.
+static int compileCond(Compiler* c, ASTNode* node, int target, int whenTrue) {
+    if (!node || node->type != NODE_RELOP) {
+        emitMessage(c, 1, 1, "Invalid condition node!\n", NULL);
+        return emit(c, OP_JMP, target, 0, 0);
+    }
+    int mark = c->temps;
+    int left = compileExpr(c, node->data.operator.left);
+    int right = compileExpr(c, node->data.operator.right);
+    c->temps = mark;
+    int op = relJump(node->data.operator.op);
+    if (op == -1) {
+        emitMessage(c, 1, 1, "Unknown relational operator: %s\n", operatorName(node->data.operator.op));
+        return emit(c, OP_JMP, target, 0, 0);
+    }
+    return emit(c, whenTrue ? op : negateJump(op), target, left, right);
+}
+
+// Compiles an assignment to an array element: index, value, then the bounds check
+static void compileElementAssign(Compiler* c, ASTNode* node) {
+    ASTNode* target = node->data.operator.left;
+    ASTNode* right = node->data.operator.right;
+    char* name = target->data.index.array->data.var.identifier;
+    SymbolTable* symbols = c->prog->symbols;
+
+    int v = target->data.index.array->data.var.slot;
+    if (v == -1) {
+        emitMessage(c, 0, 0, "Error: Variable %s not declared\n", name);
+        return;
+    }
+    if (!symbols->length[v]) {
+        emitMessage(c, 1, 1, "Type Error: Variable '%s' is not an array\n", name);
+        return;
+    }
+    if (right->type == NODE_CHAR && !symbols->is_char[v]) {
+        emitMessage(c, 1, 1, "Type Error: Cannot assign char to int variable '%s'\n", name);
+        return;
+    }
+    if (right->type != NODE_CHAR && symbols->is_char[v]) {
+        emitMessage(c, 1, 1, "Type Error: Cannot assign int to char variable '%s'\n", name);
+        return;
+    }
+
+    int unchecked = uncheckedAccess(c, target);
+    int index = compileExpr(c, target->data.index.index);
+    // a char is always stored as it is, like for char variables
+    int value = right->type == NODE_CHAR ? constSlot(c, right->data.value) : compileExpr(c, right);
+    Operator op = right->type == NODE_CHAR ? OPR_ASSIGN : node->data.operator.op;
+    if (op == OPR_ASSIGN) {
+        emit(c, unchecked ? OP_STOREU : OP_STORE, v, index, value);
+        return;
+    }
+    int arith = op == OPR_DIV_ASSIGN ? OP_DIVZ : arithOp(compoundBaseOperator(op));
+    if (arith == -1) {
+        emitMessage(c, 1, 1, "Error: Unknown assignment operator %s\n", operatorName(op));
+        return;
+    }
+    int element = newTempSlot(c);
+    emit(c, unchecked ? OP_LOADU : OP_LOAD, element, index, v);
+    emit(c, arith, element, element, value);
+    emit(c, OP_STOREU, v, index, element);
+}
+
+static void compileAssign(Compiler* c, ASTNode* node) {
+    if (node->data.operator.left->type == NODE_INDEX) {
+        compileElementAssign(c, node);
+        return;
+    }
+    char* name = node->data.operator.left->data.var.identifier;
+    ASTNode* right = node->data.operator.right;
+    Operator op = node->data.operator.op;
+
+    int v = node->data.operator.left->data.var.slot;
+    if (v == -1) {
+        emitMessage(c, 0, 0, "Error: Variable %s not declared\n", name);
+        return;
+    }
+    if (c->prog->symbols->length[v]) {
+        emitMessage(c, 1, 1, "Type Error: Cannot use array '%s' without an index\n", name);
+        return;
+    }
+    if (right->type == NODE_CHAR) {
+        if (!c->prog->symbols->is_char[v]) {
+            emitMessage(c, 1, 1, "Type Error: Cannot assign char to int variable '%s'\n", name);
+            return;
+        }
+        emit(c, OP_SET, VAR_TAG | v, constSlot(c, right->data.value), 0);
+        return;
+    }
+    if (c->prog->symbols->is_char[v]) {
+        emitMessage(c, 1, 1, "Type Error: Cannot assign int to char variable '%s'\n", name);
+        return;
+    }
+
+    int value = compileExpr(c, right);
+    switch (op) {
+        case OPR_ASSIGN:     emit(c, OP_SET, VAR_TAG | v, value, 0); break;
+        case OPR_ADD_ASSIGN: emit(c, OP_ADD, VAR_TAG | v, VAR_TAG | v, value); break;
+        case OPR_SUB_ASSIGN: emit(c, OP_SUB, VAR_TAG | v, VAR_TAG | v, value); break;
+        case OPR_MUL_ASSIGN: emit(c, OP_MUL, VAR_TAG | v, VAR_TAG | v, value); break;
+        case OPR_MOD_ASSIGN: emit(c, OP_MOD, VAR_TAG | v, VAR_TAG | v, value); break;
+        case OPR_DIV_ASSIGN: emit(c, OP_DIVZ, VAR_TAG | v, VAR_TAG | v, value); break;
+        default: emitMessage(c, 1, 1, "Error: Unknown assignment operator %s\n", operatorName(op)); break;
+    }
+}
+
+static int addIODesc(Compiler* c, ASTNode* node) {
+    BytecodeProgram* p = c->prog;
+    p->io = growArray(p->io, &c->ioCap, p->nio + 1, sizeof(IODesc));
+    IODesc* d = &p->io[p->nio];
+    d->format = node->data.print_scan_stmt.string;
+    d->count = node->data.print_scan_stmt.count;
+    d->args = node->data.print_scan_stmt.args;
+    d->print = node->data.print_scan_stmt.print;
+    d->scan = node->data.print_scan_stmt.scan;
+    return p->nio++;
+}
+
+static void compileStmt(Compiler* c, ASTNode* node);
+
+// Function to add the descriptor of an OP_PFOR, its chunk code is compiled after the program
+static int addParallelDesc(Compiler* c, ASTNode* node, int counter, int limit) {
+    BytecodeProgram* p = c->prog;
+    p->parallel = growArray(p->parallel, &c->parallelCap, p->nparallel + 1, sizeof(ParallelDesc));
+    c->parallelNodes = growArray(c->parallelNodes, &c->nodesCap, p->nparallel + 1, sizeof(ASTNode*));
+    int step = node->data.for_loop_block.step;
+    if (node->data.for_loop_block.update->type == NODE_DEC) step = -step;
+    p->parallel[p->nparallel] = (ParallelDesc){node->data.for_loop_block.parallel, counter, limit, step, -1, -1};
+    c->parallelNodes[p->nparallel] = node;
+    return p->nparallel++;
+}
+
+// Compiles the chunk code of a parallel descriptor; a loop lowered twice (inside the
+// two copies of a hoisted loop) shares one chunk code
+static void compileChunk(Compiler* c, int i) {
+    ParallelDesc* d = &c->prog->parallel[i];
+    ASTNode* node = c->parallelNodes[i];
+    for (int j = 0; j < i; j++) {
+        if (c->parallelNodes[j] != node) continue;
+        d->chunk = c->prog->parallel[j].chunk;
+        d->chunkEnd = c->prog->parallel[j].chunkEnd;
+        return;
+    }
+    ASTNode* update = node->data.for_loop_block.update;
+    int inc = update->type == NODE_INC;
+    d->chunk = c->prog->ncode;
+    d->chunkEnd = HIDDEN_TAG | c->prog->nhidden++;
+    // a loop is only split when all of its accesses are in bounds
+    c->nfast = 0;
+    if (node->data.for_loop_block.hoisted) c->fast[c->nfast++] = node;
+    compileStmt(c, node->data.for_loop_block.stmts);
+    c->nfast = 0;
+    c->temps = 0;
+    int step = compileExpr(c, update->data.operator.left);
+    emit(c, inc ? OP_ADD : OP_SUB, d->counter, d->counter, step);
+    emit(c, inc ? OP_JLT : OP_JGT, d->chunk, d->counter, d->chunkEnd);
+    emit(c, OP_HALT, 0, 0, 0);
+}
+
+// Compiles a rotated for loop: body, step, then the test against the limit
+static void compileCountedLoop(Compiler* c, ASTNode* node, int counter) {
+    ASTNode* update = node->data.for_loop_block.update;
+    int inc = update->type == NODE_INC;
+
+    int toCond = emit(c, OP_JMP, -1, 0, 0);
+    int body = c->prog->ncode;
+    compileStmt(c, node->data.for_loop_block.stmts);
+    c->temps = 0;
+    int step = compileExpr(c, update->data.operator.left);
+    emit(c, inc ? OP_ADD : OP_SUB, counter, counter, step);
+    patch(c, toCond, c->prog->ncode);
+    c->temps = 0;
+    int limit = compileExpr(c, node->data.for_loop_block.limit);
+    emit(c, inc ? OP_JLT : OP_JGT, body, counter, limit);
+}
+
+static void compileStmt(Compiler* c, ASTNode* node) {
+    if (!node) return;
+    c->temps = 0;
+
+    switch (node->type) {
+        case NODE_PROG:
+            compileStmt(c, node->data.program.varDecl);
+            compileStmt(c, node->data.program.stmtblock);
+            break;
+
+        case NODE_VARDEC:
+            // declarations were resolved into slots before compiling
+            break;
+
+        case NODE_STMTS:
+            for (int i = 0; i < node->data.statements.count; i++)
+                compileStmt(c, node->data.statements.statements[i]);
+            break;
+
+        case NODE_ASSIGN:
+            compileAssign(c, node);
+            break;
+
+        case NODE_IF: {
+            int skip = compileCond(c, node->data.if_while_block.condition, -1, 0);
+            compileStmt(c, node->data.if_while_block.stmts);
+            patch(c, skip, c->prog->ncode);
+            break;
+        }
+
+        case NODE_IF_ELSE: {
+            int toElse = compileCond(c, node->data.if_else_block.condition, -1, 0);
+            compileStmt(c, node->data.if_else_block.stmts);
+            int toEnd = emit(c, OP_JMP, -1, 0, 0);
+            patch(c, toElse, c->prog->ncode);
+            compileStmt(c, node->data.if_else_block.else_part);
+            patch(c, toEnd, c->prog->ncode);
+            break;
+        }
+
+        case NODE_WHILE: {
+            // rotated loop: the condition sits at the bottom and jumps back to the body
+            int toCond = emit(c, OP_JMP, -1, 0, 0);
+            int body = c->prog->ncode;
+            compileStmt(c, node->data.if_while_block.stmts);
+            patch(c, toCond, c->prog->ncode);
+            c->temps = 0;
+            compileCond(c, node->data.if_while_block.condition, body, 1);
+            break;
+        }
+
+        case NODE_FOR: {
+            ASTNode* init = node->data.for_loop_block.init;
+            ASTNode* update = node->data.for_loop_block.update;
+            compileAssign(c, init);
+
+            char* name = init->data.operator.left->data.var.identifier;
+            int v = init->data.operator.left->data.var.slot;
+            if (v == -1) {
+                emitMessage(c, 0, 0, "Error: Variable %s not declared\n", name);
+                break;
+            }
+            // an array counter was reported by the initialization
+            if (c->prog->symbols->length[v]) break;
+            // a char loop variable counts in its (otherwise unused) integer value
+            int counter = c->prog->symbols->is_char[v] ? hiddenSlot(c, v) : (VAR_TAG | v);
+            // a parallel loop is first offered to the worker pool, which skips it when split
+            int toExit = -1;
+            if (node->data.for_loop_block.parallel && !c->inChunk) {
+                c->temps = 0;
+                int limit = compileExpr(c, node->data.for_loop_block.limit);
+                toExit = emit(c, OP_PFOR, addParallelDesc(c, node, counter, limit), -1, 0);
+            }
+            if (!node->data.for_loop_block.hoisted) {
+                compileCountedLoop(c, node, counter);
+                if (toExit >= 0) c->prog->code[toExit].b = c->prog->ncode;
+                break;
+            }
+
+            // the bounds are tested once: the fast copy of the loop runs when the
+            // counter and the limit lie in the range where every access is in bounds
+            int low = constSlot(c, node->data.for_loop_block.low);
+            int high = constSlot(c, node->data.for_loop_block.high);
+            int toChecked[2];
+            c->temps = 0;
+            if (update->type == NODE_INC) {
+                toChecked[0] = emit(c, OP_JLT, -1, counter, low);
+                int limit = compileExpr(c, node->data.for_loop_block.limit);
+                toChecked[1] = emit(c, OP_JGT, -1, limit, high);
+            } else {
+                int limit = compileExpr(c, node->data.for_loop_block.limit);
+                toChecked[0] = emit(c, OP_JLT, -1, limit, low);
+                toChecked[1] = emit(c, OP_JGT, -1, counter, high);
+            }
+            c->fast[c->nfast++] = node;
+            compileCountedLoop(c, node, counter);
+            c->nfast--;
+            int toEnd = emit(c, OP_JMP, -1, 0, 0);
+            patch(c, toChecked[0], c->prog->ncode);
+            patch(c, toChecked[1], c->prog->ncode);
+            compileCountedLoop(c, node, counter);
+            patch(c, toEnd, c->prog->ncode);
+            if (toExit >= 0) c->prog->code[toExit].b = c->prog->ncode;
+            break;
+        }
+
+        case NODE_PRINT:
+            emit(c, OP_PRINT, addIODesc(c, node), 0, 0);
+            break;
+
+        case NODE_SCAN:
+            emit(c, OP_SCAN, addIODesc(c, node), 0, 0);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static int relocate(BytecodeProgram* p, int operand) {
+    int index = operand & ~TAG_MASK;
+    switch (operand & TAG_MASK) {
+        case TEMP_TAG:   return p->nvars + p->nhidden + index;
+        case CONST_TAG:  return p->nvars + p->nhidden + p->ntemps + index;
+        case HIDDEN_TAG: return p->nvars + index;
+        default:         return index;
+    }
+}
+
+// Function to lower the AST into bytecode
+BytecodeProgram* compileBytecode(ASTNode* root, SymbolTable* symbols) {
+    Compiler c;
+    memset(&c, 0, sizeof(c));
+    c.prog = calloc(1, sizeof(BytecodeProgram));
+    if (!c.prog) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    c.prog->symbols = symbols;
+    c.prog->nvars = symbols->count;
+
+    compileStmt(&c, root);
+    emit(&c, OP_HALT, 0, 0, 0);
+    c.inChunk = 1;
+    for (int i = 0; i < c.prog->nparallel; i++) compileChunk(&c, i);
+
+    BytecodeProgram* p = c.prog;
+    p->nslots = p->nvars + p->nhidden + p->ntemps + p->nconsts;
+    for (int i = 0; i < p->ncode; i++) {
+        Instr* in = &p->code[i];
+        int slots = opInfo[in->op].slots;
+        if (slots & SLOT_A) in->a = relocate(p, in->a);
+        if (slots & SLOT_B) in->b = relocate(p, in->b);
+        if (slots & SLOT_C) in->c = relocate(p, in->c);
+    }
+    for (int i = 0; i < p->nparallel; i++) {
+        ParallelDesc* d = &p->parallel[i];
+        d->counter = relocate(p, d->counter);
+        d->limit = relocate(p, d->limit);
+        d->chunkEnd = relocate(p, d->chunkEnd);
+    }
+
+    free(c.hiddenOf);
+    free(c.parallelNodes);
+    freeConstPool(&c.consts);
+    return p;
+}
+
+// Function to print a slot operand of the disassembly
+static void printSlot(BytecodeProgram* p, int slot) {
+    int constBase = p->nslots - p->nconsts;
+    if (slot < p->nvars) printf("%s", p->symbols->names[slot]);
+    else if (slot < p->nvars + p->nhidden) printf("h%d", slot - p->nvars);
+    else if (slot < constBase) printf("r%d", slot - p->nvars - p->nhidden);
+    else printf("#%d", p->consts[slot - constBase]);
+}
+
+// Function to print the bytecode in a readable format
+void printBytecode(BytecodeProgram* p) {
+    for (int i = 0; i < p->ncode; i++) {
+        Instr* in = &p->code[i];
+        int slots = opInfo[in->op].slots;
+        printf("%4d  %-6s", i, opInfo[in->op].name);
+        if (in->op == OP_JMP || (in->op >= OP_JLT && in->op <= OP_JNE)) printf(" @%d", in->a);
+        if (in->op == OP_STORE || in->op == OP_STOREU) printf(" %s", p->symbols->names[in->a]);
+        if (slots & SLOT_A) { printf(" "); printSlot(p, in->a); }
+        if (slots & SLOT_B) { printf(" "); printSlot(p, in->b); }
+        if (slots & SLOT_C) { printf(" "); printSlot(p, in->c); }
+        if (in->op == OP_LOAD || in->op == OP_LOADU) printf(" %s", p->symbols->names[in->c]);
+        if (in->op == OP_PRINT || in->op == OP_SCAN) printf(" %s", p->io[in->a].format);
+        if (in->op == OP_PFOR) printf(" @%d, chunks @%d\n", in->b, p->parallel[in->a].chunk);
+        else if (in->op == OP_MSG) printf(" %s", p->msgs[in->a].text);
+        else printf("\n");
+    }
+}
+
+// Function to free a compiled program (strings are owned by the AST)
+void freeBytecode(BytecodeProgram* p) {
+    if (!p) return;
+    for (int i = 0; i < p->nmsgs; i++) free(p->msgs[i].text);
+    free(p->io);
+    free(p->msgs);
+    free(p->parallel);
+    free(p->code);
+    free(p->consts);
+    free(p);
+}
@@ -0,0 +1,404 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bytecode.h"
+#include "simulation.h"
+
+// Native code generation for x86-64 Linux. The bytecode is translated one instruction
+// at a time into machine code that works on the same frame as the VM:
+//   rbx = frame registers, r12 = assigned flags, r13 = the NativeCode being run,
+//   r14 = array elements.
+// Constants are folded into immediates, print, scan, diagnostics and split loops call
+// back into the VM runtime, so the output is the same as with runBytecode. The entry
+// jumps to the code of the instruction it is given, the chunk code of a split loop is
+// entered that way by every worker thread with a NativeCode of its own.
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+
+typedef void (*NativeEntry)(NativeCode* native, int* r, unsigned char* assigned, int* elements, const void* start);
+
+struct NativeCode {
+    BytecodeProgram* prog;
+    void* memory;
+    size_t size;
+    NativeEntry entry;
+    size_t* offsets;    // code of each instruction, from the start of memory
+
+    // state of the current run, read by the callbacks
+    int* r;
+    unsigned char* assigned;
+    int* elements;
+    FILE* out;
+};
+
+typedef struct {
+    unsigned char* bytes;
+    size_t len;
+    size_t cap;
+} CodeBuffer;
+
+// x86 register numbers used in ModRM fields
+enum { EAX = 0, ECX = 1 };
+
+static void emitByte(CodeBuffer* b, unsigned char byte) {
+    if (b->len == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 4096;
+        b->bytes = realloc(b->bytes, b->cap);
+        if (!b->bytes) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    b->bytes[b->len++] = byte;
+}
+
+static void emitBytes(CodeBuffer* b, const char* bytes, int count) {
+    for (int i = 0; i < count; i++) emitByte(b, (unsigned char)bytes[i]);
+}
+
+static void emit32(CodeBuffer* b, int32_t value) {
+    uint32_t v = (uint32_t)value;
+    for (int i = 0; i < 4; i++) emitByte(b, (unsigned char)(v >> (8 * i)));
+}
+
+static void emit64(CodeBuffer* b, uint64_t value) {
+    for (int i = 0; i < 8; i++) emitByte(b, (unsigned char)(value >> (8 * i)));
+}
+
+// Returns 1 if slot is a constant register, its value goes to *value
+static int constSlot(BytecodeProgram* p, int slot, int* value) {
+    int base = p->nslots - p->nconsts;
+    if (slot < base) return 0;
+    *value = p->consts[slot - base];
+    return 1;
+}
+
+// reg := r[slot]
+static void emitLoad(CodeBuffer* b, BytecodeProgram* p, int reg, int slot) {
+    int value;
+    if (constSlot(p, slot, &value)) {
+        emitByte(b, 0xB8 + reg);                    // mov reg, imm32
+        emit32(b, value);
+    } else {
+        emitByte(b, 0x8B);                          // mov reg, [rbx + disp32]
+        emitByte(b, 0x83 | reg << 3);
+        emit32(b, slot * 4);
+    }
+}
+
+// r[slot] := eax
+static void emitStore(CodeBuffer* b, int slot) {
+    emitByte(b, 0x89);                              // mov [rbx + disp32], eax
+    emitByte(b, 0x83);
+    emit32(b, slot * 4);
+}
+
+// assigned[slot] := 1
+static void emitMark(CodeBuffer* b, int slot) {
+    emitBytes(b, "\x41\xC6\x84\x24", 4);            // mov byte [r12 + disp32], 1
+    emit32(b, slot);
+    emitByte(b, 1);
+}
+
+// Loads r[b] into eax and applies op with r[c]; an immediate form is used for constants
+static void emitArith(CodeBuffer* b, BytecodeProgram* p, unsigned char regOp, unsigned char immOp, const Instr* in) {
+    int value;
+    emitLoad(b, p, EAX, in->b);
+    if (immOp && constSlot(p, in->c, &value)) {
+        emitByte(b, immOp);                         // op eax, imm32
+        emit32(b, value);
+    } else {
+        emitLoad(b, p, ECX, in->c);
+        emitByte(b, regOp);                         // op eax, ecx
+        emitByte(b, 0xC8);
+    }
+}
+
+// Function to call fn(native, arg) with the native code as the first argument
+static void emitCall(CodeBuffer* b, void* fn, int arg) {
+    emitBytes(b, "\x4C\x89\xEF", 3);                // mov rdi, r13
+    emitByte(b, 0xBE);                              // mov esi, imm32
+    emit32(b, arg);
+    emitBytes(b, "\x48\xB8", 2);                    // mov rax, imm64
+    emit64(b, (uint64_t)(uintptr_t)fn);
+    emitBytes(b, "\xFF\xD0", 2);                    // call rax
+}
+
+static void emitEpilogue(CodeBuffer* b) {
+    emitBytes(b, "\x41\x5F\x41\x5E", 4);            // pop r15; pop r14
+    emitBytes(b, "\x41\x5D\x41\x5C\x5B\xC3", 6);    // pop r13; pop r12; pop rbx; ret
+}
+
+// Runtime callbacks of the native code
+static void nativePrint(NativeCode* n, int index) {
+    vmPrint(n->prog, &n->prog->io[index], n->r, n->out);
+}
+
+static void nativeScan(NativeCode* n, int index) {
+    vmScan(n->prog, &n->prog->io[index], n->r, n->assigned);
+}
+
+static void nativeMessage(NativeCode* n, int index) {
+    Message* m = &n->prog->msgs[index];
+    fputs(m->text, m->to_stderr ? stderr : n->out);
+    if (m->fatal) exit(EXIT_FAILURE);
+}
+
+// Function to run chunk code on the registers of one worker thread
+static void runNativeChunk(void* engine, const ParallelDesc* d, int* r, unsigned char* assigned, FILE* out) {
+    NativeCode worker = *(NativeCode*)engine;
+    worker.r = r;
+    worker.assigned = assigned;
+    worker.out = out;
+    worker.entry(&worker, r, assigned, worker.elements, (char*)worker.memory + worker.offsets[d->chunk]);
+}
+
+static int nativeParallel(NativeCode* n, int index) {
+    return runParallelFor(n->prog, &n->prog->parallel[index], n->r, n->assigned, runNativeChunk, n);
+}
+
+static void nativeIndexError(NativeCode* n, int array, int index) {
+    SymbolTable* symbols = n->prog->symbols;
+    reportIndexError(symbols->names[array], index, symbols->length[array]);
+}
+
+// Checks the index in ecx against the length of array, a bad index goes to edx for the report
+static void emitBoundsCheck(CodeBuffer* b, BytecodeProgram* p, int array) {
+    emitBytes(b, "\x81\xF9", 2);                    // cmp ecx, imm32
+    emit32(b, p->symbols->length[array]);
+    emitByte(b, 0x72);                              // jb over the call
+    size_t skip = b->len;
+    emitByte(b, 0);
+    emitBytes(b, "\x89\xCA", 2);                    // mov edx, ecx
+    emitCall(b, (void*)nativeIndexError, array);
+    b->bytes[skip] = (unsigned char)(b->len - skip - 1);
+}
+
+static void nativeDivisionByZero(NativeCode* n, int unused) {
+    (void)n;
+    (void)unused;
+    fprintf(stderr, "Error: Division by zero\n");
+    exit(EXIT_FAILURE);
+}
+
+// Condition codes, indexed from OP_SLT / OP_JLT: lt, le, gt, ge, eq, ne
+static const unsigned char conditionCode[6] = {0x0C, 0x0E, 0x0F, 0x0D, 0x04, 0x05};
+
+typedef struct {
+    size_t at;          // position of the rel32 field
+    int target;         // instruction index
+} Fixup;
+
+// Function to translate a bytecode program into native code, NULL if it cannot be mapped
+NativeCode* compileNative(BytecodeProgram* p) {
+    // element offsets are encoded as 32-bit displacements
+    if (p->symbols->nelements > INT32_MAX / 4) return NULL;
+    CodeBuffer b = {NULL, 0, 0};
+    size_t* offsets = malloc((p->ncode + 1) * sizeof(size_t));
+    Fixup* fixups = malloc((p->ncode + 1) * sizeof(Fixup));
+    NativeCode* n = calloc(1, sizeof(NativeCode));
+    if (!offsets || !fixups || !n) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    int nfixups = 0;
+
+    // push rbx; push r12; push r13; push r14; push r15 (leaves the stack 16-byte aligned for calls)
+    // mov r13, rdi; mov rbx, rsi; mov r12, rdx; mov r14, rcx; jmp r8
+    emitBytes(&b, "\x53\x41\x54\x41\x55\x41\x56\x41\x57", 9);
+    emitBytes(&b, "\x49\x89\xFD\x48\x89\xF3\x49\x89\xD4\x49\x89\xCE", 12);
+    emitBytes(&b, "\x41\xFF\xE0", 3);
+
+    for (int i = 0; i < p->ncode; i++) {
+        const Instr* in = &p->code[i];
+        offsets[i] = b.len;
+        switch (in->op) {
+            case OP_MOV:
+            case OP_SET: {
+                int value;
+                if (constSlot(p, in->b, &value)) {
+                    emitByte(&b, 0xC7);             // mov dword [rbx + disp32], imm32
+                    emitByte(&b, 0x83);
+                    emit32(&b, in->a * 4);
+                    emit32(&b, value);
+                } else {
+                    emitLoad(&b, p, EAX, in->b);
+                    emitStore(&b, in->a);
+                }
+                if (in->op == OP_SET) emitMark(&b, in->a);
+                break;
+            }
+            case OP_ADD:
+                emitArith(&b, p, 0x01, 0x05, in);
+                emitStore(&b, in->a);
+                break;
+            case OP_SUB:
+                emitArith(&b, p, 0x29, 0x2D, in);
+                emitStore(&b, in->a);
+                break;
+            case OP_MUL:
+                emitLoad(&b, p, EAX, in->b);
+                emitLoad(&b, p, ECX, in->c);
+                emitBytes(&b, "\x0F\xAF\xC1", 3);   // imul eax, ecx
+                emitStore(&b, in->a);
+                break;
+            case OP_DIV:
+            case OP_MOD:
+            case OP_DIVZ:
+                emitLoad(&b, p, EAX, in->b);
+                emitLoad(&b, p, ECX, in->c);
+                if (in->op == OP_DIVZ) {
+                    emitBytes(&b, "\x85\xC9\x75", 3);   // test ecx, ecx; jne over the call
+                    size_t skip = b.len;
+                    emitByte(&b, 0);
+                    emitCall(&b, (void*)nativeDivisionByZero, 0);
+                    b.bytes[skip] = (unsigned char)(b.len - skip - 1);
+                }
+                emitBytes(&b, "\x99\xF7\xF9", 3);   // cdq; idiv ecx (traps like the VM on zero)
+                if (in->op == OP_MOD) emitBytes(&b, "\x89\xD0", 2);    // mov eax, edx
+                emitStore(&b, in->a);
+                break;
+            case OP_SLT: case OP_SLE: case OP_SGT:
+            case OP_SGE: case OP_SEQ: case OP_SNE:
+                emitArith(&b, p, 0x39, 0x3D, in);   // cmp
+                emitBytes(&b, "\x0F", 1);           // setcc al; movzx eax, al
+                emitByte(&b, 0x90 | conditionCode[in->op - OP_SLT]);
+                emitBytes(&b, "\xC0\x0F\xB6\xC0", 4);
+                emitStore(&b, in->a);
+                break;
+            case OP_LOAD:
+            case OP_LOADU:
+                emitLoad(&b, p, ECX, in->b);
+                if (in->op == OP_LOAD) emitBoundsCheck(&b, p, in->c);
+                emitBytes(&b, "\x41\x8B\x84\x8E", 4);   // mov eax, [r14 + rcx*4 + disp32]
+                emit32(&b, p->symbols->offset[in->c] * 4);
+                emitStore(&b, in->a);
+                break;
+            case OP_STORE:
+            case OP_STOREU:
+                emitLoad(&b, p, ECX, in->b);
+                if (in->op == OP_STORE) emitBoundsCheck(&b, p, in->a);
+                emitLoad(&b, p, EAX, in->c);
+                emitBytes(&b, "\x41\x89\x84\x8E", 4);   // mov [r14 + rcx*4 + disp32], eax
+                emit32(&b, p->symbols->offset[in->a] * 4);
+                break;
+            case OP_JMP:
+                emitByte(&b, 0xE9);                 // jmp rel32
+                fixups[nfixups++] = (Fixup){b.len, in->a};
+                emit32(&b, 0);
+                break;
+            case OP_JLT: case OP_JLE: case OP_JGT:
+            case OP_JGE: case OP_JEQ: case OP_JNE:
+                emitArith(&b, p, 0x39, 0x3D, in);   // cmp
+                emitByte(&b, 0x0F);                 // jcc rel32
+                emitByte(&b, 0x80 | conditionCode[in->op - OP_JLT]);
+                fixups[nfixups++] = (Fixup){b.len, in->a};
+                emit32(&b, 0);
+                break;
+            case OP_PRINT:
+                emitCall(&b, (void*)nativePrint, in->a);
+                break;
+            case OP_SCAN:
+                emitCall(&b, (void*)nativeScan, in->a);
+                break;
+            case OP_MSG:
+                emitCall(&b, (void*)nativeMessage, in->a);
+                break;
+            case OP_PFOR:
+                emitCall(&b, (void*)nativeParallel, in->a);
+                emitBytes(&b, "\x85\xC0\x0F\x85", 4);   // test eax, eax; jne rel32 past the loop
+                fixups[nfixups++] = (Fixup){b.len, in->b};
+                emit32(&b, 0);
+                break;
+            case OP_HALT:
+            default:
+                emitEpilogue(&b);
+                break;
+        }
+    }
+    offsets[p->ncode] = b.len;
+    emitEpilogue(&b);
+
+    for (int i = 0; i < nfixups; i++) {
+        int32_t rel = (int32_t)(offsets[fixups[i].target] - (fixups[i].at + 4));
+        memcpy(b.bytes + fixups[i].at, &rel, 4);
+    }
+    free(fixups);
+
+    // map writable, copy, then flip to executable
+    void* memory = mmap(NULL, b.len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        free(b.bytes);
+        free(offsets);
+        free(n);
+        return NULL;
+    }
+    memcpy(memory, b.bytes, b.len);
+    free(b.bytes);
+    if (mprotect(memory, b.len, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, b.len);
+        free(offsets);
+        free(n);
+        return NULL;
+    }
+
+    n->prog = p;
+    n->memory = memory;
+    n->size = b.len;
+    n->entry = (NativeEntry)memory;
+    n->offsets = offsets;
+    return n;
+}
+
+// Function to run native code on a fresh frame, like runBytecode
+void runNative(NativeCode* n, Frame* frame) {
+    BytecodeProgram* p = n->prog;
+    n->r = calloc(p->nslots + 1, sizeof(int));
+    n->assigned = calloc(p->nvars + 1, 1);
+    n->elements = calloc(p->symbols->nelements + 1, sizeof(int));
+    if (!n->r || !n->assigned || !n->elements) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(n->r + p->nslots - p->nconsts, p->consts, p->nconsts * sizeof(int));
+
+    n->out = stdout;
+    n->entry(n, n->r, n->assigned, n->elements, (char*)n->memory + n->offsets[0]);
+
+    storeFrame(p, n->r, n->assigned, n->elements, frame);
+    free(n->r);
+    free(n->assigned);
+    free(n->elements);
+    n->r = NULL;
+    n->assigned = NULL;
+    n->elements = NULL;
+}
+
+void freeNative(NativeCode* n) {
+    if (!n) return;
+    munmap(n->memory, n->size);
+    free(n->offsets);
+    free(n);
+}
+
+#else
+
+// Other platforms have no native backend, callers fall back to the VM
+NativeCode* compileNative(BytecodeProgram* p) {
+    (void)p;
+    return NULL;
+}
+
+void runNative(NativeCode* n, Frame* frame) {
+    (void)n;
+    (void)frame;
+}
+
+void freeNative(NativeCode* n) {
+    (void)n;
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "alloc.h"
+#include "bytecode.h"
+#include "parallel.h"
+#include "simulation.h"
+#include "output.h"
+#include "input.h"
+
+// Function to execute a print descriptor
+void vmPrint(BytecodeProgram* p, IODesc* d, int* r, FILE* out) {
+    (void)p;
+    writePrint(out, d->print, r, NULL);
+}
+
+// Function to execute a scan descriptor
+void vmScan(BytecodeProgram* p, IODesc* d, int* r, unsigned char* assigned) {
+    (void)p;
+    runScan(d->scan, r, NULL, assigned);
+}
+
+// Function to copy the final variable values and array elements into the frame
+void storeFrame(BytecodeProgram* p, int* r, unsigned char* assigned, int* elements, Frame* frame) {
+    SymbolTable* symbols = p->symbols;
+    for (int v = 0; v < p->nvars; v++) {
+        if (symbols->is_char[v]) {
+            frame->char_value[v] = (char)r[v];
+        } else {
+            frame->int_value[v] = r[v];
+        }
+        frame->assigned[v] = assigned[v];
+        for (int i = symbols->offset[v]; i < symbols->offset[v] + symbols->length[v]; i++) {
+            if (symbols->is_char[v]) frame->char_elements[i] = (char)elements[i];
+            else frame->int_elements[i] = elements[i];
+        }
+    }
+}
+
+// A split loop of either engine: each thread runs chunk code on its own registers
+typedef struct {
+    const ParallelDesc* d;
+    ChunkCode run;
+    void* engine;
+    int start;
+    int** r;
+    unsigned char** assigned;
+} ChunkLoop;
+
+static void runChunkCode(void* context, int t, long long first, long long end, FILE* out) {
+    ChunkLoop* loop = context;
+    int* r = loop->r[t];
+    r[loop->d->counter] = (int)(loop->start + first * loop->d->step);
+    r[loop->d->chunkEnd] = (int)(loop->start + end * loop->d->step);
+    loop->run(loop->engine, loop->d, r, loop->assigned[t], out);
+}
+
+int runParallelFor(BytecodeProgram* p, const ParallelDesc* d, int* r, unsigned char* assigned, ChunkCode run, void* engine) {
+    // the trip count of the rotated loop, as runCountedLoop computes it
+    long long start = r[d->counter];
+    long long distance = d->step > 0 ? (long long)r[d->limit] - start : start - r[d->limit];
+    long long size = d->step > 0 ? d->step : -(long long)d->step;
+    long long trips = distance > 0 ? (distance + size - 1) / size : 0;
+    long long last = start + trips * d->step;
+    if (last < INT_MIN || last > INT_MAX) return 0;
+    int threads = splitThreads(d->loop, (int)start, d->step, trips);
+    if (!threads) return 0;
+
+    ParallelLoop* parallel = d->loop;
+    ChunkLoop loop = {d, run, engine, (int)start, allocArray(threads, sizeof(int*)), allocArray(threads, sizeof(unsigned char*))};
+    for (int t = 0; t < threads; t++) {
+        loop.r[t] = allocArray(p->nslots + 1, sizeof(int));
+        loop.assigned[t] = allocArray(p->nvars + 1, 1);
+        memcpy(loop.r[t], r, p->nslots * sizeof(int));
+        memcpy(loop.assigned[t], assigned, p->nvars);
+        // reductions start from the identity of their operator
+        for (int i = 0; i < parallel->nslots; i++) {
+            if (parallel->kinds[i] != PARALLEL_PRIVATE) loop.r[t][parallel->slots[i]] = parallel->kinds[i] == PARALLEL_PRODUCT;
+        }
+    }
+    int lastThread = runSplitLoop(trips, threads, runChunkCode, &loop);
+
+    // scalars and char loop counters end as after the last iteration, reductions
+    // combine the partial results in thread order
+    int* lastR = loop.r[lastThread];
+    for (int i = 0; i < parallel->nslots; i++) {
+        int slot = parallel->slots[i];
+        if (parallel->kinds[i] != PARALLEL_PRIVATE) {
+            for (int t = 0; t < threads; t++) r[slot] = combinePartial(parallel->kinds[i], r[slot], loop.r[t][slot]);
+            continue;
+        }
+        r[slot] = lastR[slot];
+        assigned[slot] = loop.assigned[lastThread][slot];
+    }
+    memcpy(r + p->nvars, lastR + p->nvars, p->nhidden * sizeof(int));
+    r[d->counter] = (int)last;
+
+    for (int t = 0; t < threads; t++) {
+        free(loop.r[t]);
+        free(loop.assigned[t]);
+    }
+    free(loop.r);
+    free(loop.assigned);
+    return 1;
+}
+
+#if defined(__GNUC__)
+#define VM_CASE(op) case op: L_##op:
+#define VM_NEXT() goto *dispatch[pc->op]
+#else
+#define VM_CASE(op) case op:
+#define VM_NEXT() goto next
+#endif
+
+typedef struct {
+    BytecodeProgram* p;
+    int* elements;
+} VMChunk;
+
+static void execute(BytecodeProgram* p, const Instr* pc, int* r, unsigned char* assigned, int* elements, FILE* out);
+
+static void runVMChunk(void* engine, const ParallelDesc* d, int* r, unsigned char* assigned, FILE* out) {
+    VMChunk* vm = engine;
+    execute(vm->p, vm->p->code + d->chunk, r, assigned, vm->elements, out);
+}
+
+// Dispatch loop of the register VM, from pc to the next halt; prints go to out
+static void execute(BytecodeProgram* p, const Instr* pc, int* r, unsigned char* assigned, int* elements, FILE* out) {
+    const Instr* code = p->code;
+    const int* length = p->symbols->length;
+    const int* offset = p->symbols->offset;
+
+#if defined(__GNUC__)
+    static void* dispatch[OP_COUNT] = {
+        [OP_HALT] = &&L_OP_HALT, [OP_MOV] = &&L_OP_MOV, [OP_SET] = &&L_OP_SET,
+        [OP_ADD] = &&L_OP_ADD, [OP_SUB] = &&L_OP_SUB, [OP_MUL] = &&L_OP_MUL,
+        [OP_DIV] = &&L_OP_DIV, [OP_MOD] = &&L_OP_MOD, [OP_DIVZ] = &&L_OP_DIVZ,
+        [OP_SLT] = &&L_OP_SLT, [OP_SLE] = &&L_OP_SLE, [OP_SGT] = &&L_OP_SGT,
+        [OP_SGE] = &&L_OP_SGE, [OP_SEQ] = &&L_OP_SEQ, [OP_SNE] = &&L_OP_SNE,
+        [OP_LOAD] = &&L_OP_LOAD, [OP_LOADU] = &&L_OP_LOADU, [OP_STORE] = &&L_OP_STORE,
+        [OP_STOREU] = &&L_OP_STOREU,
+        [OP_JMP] = &&L_OP_JMP, [OP_JLT] = &&L_OP_JLT, [OP_JLE] = &&L_OP_JLE,
+        [OP_JGT] = &&L_OP_JGT, [OP_JGE] = &&L_OP_JGE, [OP_JEQ] = &&L_OP_JEQ,
+        [OP_JNE] = &&L_OP_JNE, [OP_PRINT] = &&L_OP_PRINT, [OP_SCAN] = &&L_OP_SCAN,
+        [OP_MSG] = &&L_OP_MSG, [OP_PFOR] = &&L_OP_PFOR,
+    };
+#else
+next:
+#endif
+    switch (pc->op) {
+        VM_CASE(OP_MOV)
+            r[pc->a] = r[pc->b]; pc++; VM_NEXT();
+        VM_CASE(OP_SET)
+            r[pc->a] = r[pc->b]; assigned[pc->a] = 1; pc++; VM_NEXT();
+        VM_CASE(OP_ADD)
+            r[pc->a] = r[pc->b] + r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SUB)
+            r[pc->a] = r[pc->b] - r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_MUL)
+            r[pc->a] = r[pc->b] * r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_DIV)
+            r[pc->a] = r[pc->b] / r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_MOD)
+            r[pc->a] = r[pc->b] % r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_DIVZ)
+            if (r[pc->c] == 0) {
+                fprintf(stderr, "Error: Division by zero\n");
+                exit(EXIT_FAILURE);
+            }
+            r[pc->a] = r[pc->b] / r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SLT)
+            r[pc->a] = r[pc->b] < r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SLE)
+            r[pc->a] = r[pc->b] <= r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SGT)
+            r[pc->a] = r[pc->b] > r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SGE)
+            r[pc->a] = r[pc->b] >= r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SEQ)
+            r[pc->a] = r[pc->b] == r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_SNE)
+            r[pc->a] = r[pc->b] != r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_LOAD)
+            if ((unsigned)r[pc->b] >= (unsigned)length[pc->c])
+                reportIndexError(p->symbols->names[pc->c], r[pc->b], length[pc->c]);
+            r[pc->a] = elements[offset[pc->c] + r[pc->b]]; pc++; VM_NEXT();
+        VM_CASE(OP_LOADU)
+            r[pc->a] = elements[offset[pc->c] + r[pc->b]]; pc++; VM_NEXT();
+        VM_CASE(OP_STORE)
+            if ((unsigned)r[pc->b] >= (unsigned)length[pc->a])
+                reportIndexError(p->symbols->names[pc->a], r[pc->b], length[pc->a]);
+            elements[offset[pc->a] + r[pc->b]] = r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_STOREU)
+            elements[offset[pc->a] + r[pc->b]] = r[pc->c]; pc++; VM_NEXT();
+        VM_CASE(OP_JMP)
+            pc = code + pc->a; VM_NEXT();
+        VM_CASE(OP_JLT)
+            pc = r[pc->b] < r[pc->c] ? code + pc->a : pc + 1; VM_NEXT();
+        VM_CASE(OP_JLE)
+            pc = r[pc->b] <= r[pc->c] ? code + pc->a : pc + 1; VM_NEXT();
+        VM_CASE(OP_JGT)
+            pc = r[pc->b] > r[pc->c] ? code + pc->a : pc + 1; VM_NEXT();
+        VM_CASE(OP_JGE)
+            pc = r[pc->b] >= r[pc->c] ? code + pc->a : pc + 1; VM_NEXT();
+        VM_CASE(OP_JEQ)
+            pc = r[pc->b] == r[pc->c] ? code + pc->a : pc + 1; VM_NEXT();
+        VM_CASE(OP_JNE)
+            pc = r[pc->b] != r[pc->c] ? code + pc->a : pc + 1; VM_NEXT();
+        VM_CASE(OP_PRINT)
+            vmPrint(p, &p->io[pc->a], r, out); pc++; VM_NEXT();
+        VM_CASE(OP_SCAN)
+            vmScan(p, &p->io[pc->a], r, assigned); pc++; VM_NEXT();
+        VM_CASE(OP_MSG) {
+            Message* m = &p->msgs[pc->a];
+            fputs(m->text, m->to_stderr ? stderr : out);
+            if (m->fatal) exit(EXIT_FAILURE);
+            pc++; VM_NEXT();
+        }
+        VM_CASE(OP_PFOR) {
+            VMChunk vm = {p, elements};
+            pc = runParallelFor(p, &p->parallel[pc->a], r, assigned, runVMChunk, &vm) ? code + pc->b : pc + 1;
+            VM_NEXT();
+        }
+        VM_CASE(OP_HALT)
+        default:
+            break;
+    }
+}
+
+void runBytecode(BytecodeProgram* p, Frame* frame) {
+    int* r = calloc(p->nslots + 1, sizeof(int));
+    unsigned char* assigned = calloc(p->nvars + 1, 1);
+    int* elements = calloc(p->symbols->nelements + 1, sizeof(int));
+    if (!r || !assigned || !elements) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(r + p->nslots - p->nconsts, p->consts, p->nconsts * sizeof(int));
+    execute(p, p->code, r, assigned, elements, stdout);
+    storeFrame(p, r, assigned, elements, frame);
+    free(r);
+    free(assigned);
+    free(elements);
+}
@@ -0,0 +1,557 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "fold.h"
+
+// Set by the Makefile to a checksum of the compiler sources
+#ifndef COMPILER_VERSION
+#define COMPILER_VERSION __DATE__ " " __TIME__
+#endif
+
+#define CACHE_MAGIC "CSIMAST"
+#define CACHE_NULL 0xff         // tag of a missing child
+
+// Fixed part of a cache file, followed by payloadLength bytes of varints:
+// the interned names in id order, then the tree in preorder
+typedef struct {
+    char magic[8];
+    unsigned format;
+    unsigned fold;
+    unsigned long long versionHash;
+    // stamp of the source when it was stored, all zero if it was too recent to trust
+    unsigned long long device;
+    unsigned long long inode;
+    long long mtimeSeconds;
+    long long mtimeNanos;
+    unsigned long long sourceLength;
+    unsigned long long sourceHash;
+    unsigned long long payloadLength;
+    unsigned long long payloadHash;
+} CacheHeader;
+
+// Header expected for a source, and the file it is cached in
+typedef struct {
+    CacheHeader header;
+    int hashed;             // header.sourceHash is set
+    char path[PATH_MAX];
+} CacheEntry;
+
+// FNV-1a, 64 bit, over whole words with a fold of the high half back in; the
+// bytes after the last whole word go in one at a time
+static unsigned long long hashBytes(unsigned long long h, const void* data, size_t length) {
+    const unsigned char* p = data;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        unsigned long long word;
+        memcpy(&word, p + i, sizeof(word));
+        h = (h ^ word) * 1099511628211ULL;
+        h ^= h >> 32;
+    }
+    for (; i < length; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+#define HASH_SEED 14695981039346656037ULL
+#define STAMP_SLACK 2           // seconds within which a source may change unseen
+
+// Function to find the cache directory of the user, NULL if there is none
+const char* defaultCacheDir(void) {
+    static char path[PATH_MAX];
+    const char* base = getenv("XDG_CACHE_HOME");
+    int n;
+    if (base && base[0] == '/') {
+        n = snprintf(path, sizeof(path), "%s/compiler_sim", base);
+    } else if ((base = getenv("HOME")) && base[0]) {
+        n = snprintf(path, sizeof(path), "%s/.cache/compiler_sim", base);
+    } else {
+        return NULL;
+    }
+    return n > 0 && (size_t)n < sizeof(path) ? path : NULL;
+}
+
+// Function to create a directory and its parents, returns 0 on success
+static int makeDirectories(const char* dir) {
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s", dir) >= (int)sizeof(path)) return -1;
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return mkdir(path, 0755) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+// Function to fill the entry of a source from its stat alone: the header fields
+// but the source hash, and the cache file, which is named after the absolute
+// path, the compiler version and the options that shape the tree. Returns 0 if
+// the source is not a regular file.
+static int identifySource(const char* path, const CompileOptions* options, const char* dir, CacheEntry* entry) {
+    char absolute[PATH_MAX];
+    struct stat st;
+    if (!path || stat(path, &st) != 0 || !S_ISREG(st.st_mode) || !realpath(path, absolute)) return 0;
+    CacheHeader* header = &entry->header;
+    memset(header, 0, sizeof(CacheHeader));
+    memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header->format = CACHE_FORMAT;
+    header->fold = options->fold ? 1 : 0;
+    header->versionHash = hashBytes(HASH_SEED, COMPILER_VERSION, strlen(COMPILER_VERSION));
+    // a source written in the last moments may change again within the same
+    // mtime, so it is only ever recognized by its hash
+    if (st.st_mtime < time(NULL) - STAMP_SLACK) {
+        header->device = st.st_dev;
+        header->inode = st.st_ino;
+        header->mtimeSeconds = st.st_mtim.tv_sec;
+        header->mtimeNanos = st.st_mtim.tv_nsec;
+    }
+    header->sourceLength = (unsigned long long)st.st_size;
+    entry->hashed = 0;
+
+    unsigned long long key = hashBytes(HASH_SEED, &header->format, sizeof(unsigned) * 2);
+    key = hashBytes(key, &header->versionHash, sizeof(unsigned long long));
+    key = hashBytes(key, absolute, strlen(absolute));
+    int n = snprintf(entry->path, sizeof(entry->path), "%s/%016llx.ast", dir, key);
+    return n > 0 && (size_t)n < sizeof(entry->path);
+}
+
+// Function to hash the source of an entry once, returns 0 if it cannot be read
+// or no longer has the length it had when identified
+static int hashSource(const char* path, CacheEntry* entry) {
+    if (entry->hashed) return 1;
+    SourceMap map;
+    if (mapSourceFile(path, &map) != 0) return 0;
+    entry->header.sourceHash = hashBytes(HASH_SEED, map.text, map.length);
+    entry->hashed = map.length == entry->header.sourceLength;
+    unmapSourceFile(&map);
+    return entry->hashed;
+}
+
+// Function to tell whether a cache header was stored for the source as it is now
+static int sameStamp(const CacheHeader* stored, const CacheHeader* current) {
+    return current->inode != 0 && stored->device == current->device && stored->inode == current->inode &&
+           stored->mtimeSeconds == current->mtimeSeconds && stored->mtimeNanos == current->mtimeNanos;
+}
+
+// ---- writing -------------------------------------------------------------
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t cap;
+} Writer;
+
+static void putByte(Writer* w, unsigned char byte) {
+    if (w->length == w->cap) {
+        w->cap = w->cap ? w->cap * 2 : 1 << 16;
+        w->data = realloc(w->data, w->cap);
+        if (!w->data) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    w->data[w->length++] = byte;
+}
+
+// LEB128, signed values are zigzag encoded first
+static void putUnsigned(Writer* w, unsigned long long value) {
+    while (value >= 0x80) {
+        putByte(w, (unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    putByte(w, (unsigned char)value);
+}
+
+static void putInt(Writer* w, int value) {
+    putUnsigned(w, ((unsigned long long)(unsigned)value << 1) ^ (unsigned long long)(value < 0 ? -1LL : 0));
+}
+
+static void putNode(Writer* w, Interner* names, ASTNode* node);
+
+static void putArgs(Writer* w, ll* args) {
+    int count = 0;
+    for (ll* arg = args; arg; arg = arg->next) count++;
+    putUnsigned(w, count);
+    for (ll* arg = args; arg; arg = arg->next) putUnsigned(w, arg->name);
+}
+
+static void putNode(Writer* w, Interner* names, ASTNode* node) {
+    if (!node) {
+        putByte(w, CACHE_NULL);
+        return;
+    }
+    putByte(w, (unsigned char)node->type);
+    putUnsigned(w, node->line);
+    putUnsigned(w, node->column);
+    switch (node->type) {
+        case NODE_PROG:
+            putNode(w, names, node->data.program.varDecl);
+            putNode(w, names, node->data.program.stmtblock);
+            break;
+        case NODE_VARDEC: {
+            // the declaration list is long and flat, it is written as a count
+            int count = 0;
+            for (ASTNode* d = node; d; d = d->data.var_list.next) count++;
+            putUnsigned(w, count);
+            for (ASTNode* d = node; d; d = d->data.var_list.next) {
+                putByte(w, strcmp(d->data.var_list.type, "char") == 0);
+                putNode(w, names, d->data.var_list.variable);
+            }
+            break;
+        }
+        case NODE_STMTS:
+            putUnsigned(w, node->data.statements.count);
+            for (int i = 0; i < node->data.statements.count; i++) putNode(w, names, node->data.statements.statements[i]);
+            break;
+        case NODE_FOR:
+            putNode(w, names, node->data.for_loop_block.init);
+            putNode(w, names, node->data.for_loop_block.limit);
+            putNode(w, names, node->data.for_loop_block.update);
+            putNode(w, names, node->data.for_loop_block.stmts);
+            break;
+        case NODE_WHILE:
+        case NODE_IF:
+            putNode(w, names, node->data.if_while_block.condition);
+            putNode(w, names, node->data.if_while_block.stmts);
+            break;
+        case NODE_IF_ELSE:
+            putNode(w, names, node->data.if_else_block.condition);
+            putNode(w, names, node->data.if_else_block.stmts);
+            putNode(w, names, node->data.if_else_block.else_part);
+            break;
+        case NODE_NUMBER:
+            putInt(w, node->data.integer.value);
+            putInt(w, node->data.integer.base);
+            break;
+        case NODE_CHAR:
+            putByte(w, (unsigned char)node->data.value);
+            break;
+        case NODE_ASSIGN:
+        case NODE_INC:
+        case NODE_DEC:
+        case NODE_OP:
+        case NODE_RELOP:
+            putUnsigned(w, node->data.operator.op);
+            putNode(w, names, node->data.operator.left);
+            putNode(w, names, node->data.operator.right);
+            break;
+        case NODE_VAR:
+            putUnsigned(w, node->data.var.name);
+            putUnsigned(w, node->data.var.length);
+            break;
+        case NODE_SCAN:
+        case NODE_PRINT: {
+            const char* text = node->data.print_scan_stmt.string;
+            putUnsigned(w, intern(names, text, strlen(text)));
+            putArgs(w, node->data.print_scan_stmt.args);
+            break;
+        }
+        case NODE_INDEX:
+            putNode(w, names, node->data.index.array);
+            putNode(w, names, node->data.index.index);
+            break;
+    }
+}
+
+// Function to write the folded tree of a unit to its entry, through a temporary
+// file so that a concurrent reader never sees a partial file. Errors only cost
+// the next run a parse.
+static void storeCachedUnit(CompilationUnit* unit, CacheEntry* entry, const char* dir) {
+    char temp[PATH_MAX];
+    if (!unit->root || !hashSource(unit->path, entry)) return;
+    if (snprintf(temp, sizeof(temp), "%s.XXXXXX", entry->path) >= (int)sizeof(temp) || makeDirectories(dir) != 0) return;
+    CacheHeader header = entry->header;
+
+    Writer w = {0};
+    Interner* names = &unit->names;
+    // string constants are interned too, so every name a node refers to exists already
+    int count = names->count;
+    putUnsigned(&w, count);
+    for (int id = 0; id < count; id++) {
+        size_t length = strlen(names->strings[id]);
+        putUnsigned(&w, length);
+        for (size_t i = 0; i < length; i++) putByte(&w, (unsigned char)names->strings[id][i]);
+    }
+    putNode(&w, names, unit->root);
+    header.payloadLength = w.length;
+    header.payloadHash = hashBytes(HASH_SEED, w.data, w.length);
+
+    int fd = mkstemp(temp);
+    if (fd >= 0) {
+        FILE* out = fdopen(fd, "wb");
+        int ok = out && fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(w.data, 1, w.length, out) == w.length;
+        if (out) ok = fclose(out) == 0 && ok;
+        else close(fd);
+        if (!ok || rename(temp, entry->path) != 0) unlink(temp);
+    }
+    free(w.data);
+}
+
+// ---- reading -------------------------------------------------------------
+
+typedef struct {
+    const unsigned char* pos;
+    const unsigned char* end;
+    int failed;
+    CompilationUnit* unit;
+} Reader;
+
+static unsigned char getByte(Reader* r) {
+    if (r->pos == r->end) {
+        r->failed = 1;
+        return 0;
+    }
+    return *r->pos++;
+}
+
+static unsigned long long getUnsigned(Reader* r) {
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        unsigned char byte = getByte(r);
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    r->failed = 1;
+    return 0;
+}
+
+static int getInt(Reader* r) {
+    unsigned long long v = getUnsigned(r);
+    return (int)(long long)((v >> 1) ^ (0 - (v & 1)));
+}
+
+// Function to read a count or an id that must be below limit
+static int getBounded(Reader* r, unsigned long long limit) {
+    unsigned long long v = getUnsigned(r);
+    if (v >= limit) {
+        r->failed = 1;
+        return 0;
+    }
+    return (int)v;
+}
+
+static int getName(Reader* r) {
+    return getBounded(r, (unsigned long long)r->unit->names.count);
+}
+
+static ASTNode* getNode(Reader* r) {
+    unsigned char type = getByte(r);
+    if (r->failed || type == CACHE_NULL) return NULL;
+    if (type > NODE_INDEX) {
+        r->failed = 1;
+        return NULL;
+    }
+    CompilationUnit* unit = r->unit;
+    Arena* arena = &unit->arena;
+    int line = getBounded(r, INT_MAX);
+    int column = getBounded(r, INT_MAX);
+    ASTNode* node;
+    switch ((NodeType)type) {
+        case NODE_PROG: {
+            ASTNode* decls = getNode(r);
+            node = createProgramNode(arena, NODE_PROG, decls, getNode(r));
+            break;
+        }
+        case NODE_VARDEC: {
+            int count = getBounded(r, INT_MAX);
+            ASTNode* list = NULL;
+            for (int i = 0; i < count && !r->failed; i++) {
+                char* dtype = getByte(r) ? "char" : "int";
+                list = createVarDeclNode(arena, NODE_VARDEC, dtype, getNode(r), list);
+                if (!list->data.var_list.variable) r->failed = 1;
+            }
+            node = reverseVarDeclList(list);
+            if (!node) return NULL;
+            break;
+        }
+        case NODE_STMTS: {
+            int count = getBounded(r, INT_MAX);
+            node = createStatementsNode(arena);
+            for (int i = 0; i < count && !r->failed; i++) {
+                ASTNode* stmt = getNode(r);
+                if (stmt) addStatement(arena, node, stmt);
+                else r->failed = 1;
+            }
+            break;
+        }
+        case NODE_FOR: {
+            ASTNode* init = getNode(r);
+            ASTNode* limit = getNode(r);
+            ASTNode* update = getNode(r);
+            node = createForLoopNode(arena, NODE_FOR, init, limit, update, getNode(r));
+            if (!init || !init->data.operator.left || !limit || !update || !node->data.for_loop_block.stmts) r->failed = 1;
+            break;
+        }
+        case NODE_WHILE:
+        case NODE_IF: {
+            ASTNode* condition = getNode(r);
+            node = createIfOrWhileLoopNode(arena, type, condition, getNode(r));
+            break;
+        }
+        case NODE_IF_ELSE: {
+            ASTNode* condition = getNode(r);
+            ASTNode* stmts = getNode(r);
+            node = createIfElseLadderNode(arena, NODE_IF_ELSE, condition, stmts, getNode(r));
+            break;
+        }
+        case NODE_NUMBER: {
+            int value = getInt(r);
+            node = createNumberNode(arena, value, getInt(r));
+            break;
+        }
+        case NODE_CHAR:
+            node = createCharacterNode(arena, (char)getByte(r));
+            break;
+        case NODE_ASSIGN:
+        case NODE_INC:
+        case NODE_DEC:
+        case NODE_OP:
+        case NODE_RELOP: {
+            Operator op = (Operator)getBounded(r, OPR_DEC + 1);
+            ASTNode* left = getNode(r);
+            node = createOperatorNode(arena, type, left, getNode(r), op);
+            break;
+        }
+        case NODE_VAR: {
+            int name = getName(r);
+            node = createArrayVariable(arena, &unit->names, name, getBounded(r, MAX_ARRAY_LENGTH + 1));
+            break;
+        }
+        case NODE_SCAN:
+        case NODE_PRINT: {
+            char* text = unit->names.strings[getName(r)];
+            int count = getBounded(r, INT_MAX);
+            int* ids = malloc((count + 1) * sizeof(int));
+            if (!ids) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+            for (int i = 0; i < count; i++) ids[i] = getName(r);
+            ll* args = NULL;
+            for (int i = count - 1; i >= 0 && !r->failed; i--)
+                args = createArgList(arena, unit->names.strings[ids[i]], ids[i], args);
+            free(ids);
+            node = createPrintOrScanNode(arena, type, text, args, count);
+            break;
+        }
+        case NODE_INDEX: {
+            ASTNode* array = getNode(r);
+            node = createIndexNode(arena, array, getNode(r));
+            if (!array || array->type != NODE_VAR) r->failed = 1;
+            break;
+        }
+        default:
+            r->failed = 1;
+            return NULL;
+    }
+    return setLocation(node, line, column);
+}
+
+// Function to rebuild the names and the tree of a unit from a mapped payload
+static int readPayload(CompilationUnit* unit, const unsigned char* data, size_t length) {
+    Reader r = {data, data + length, 0, unit};
+    int count = getBounded(&r, INT_MAX);
+    for (int id = 0; id < count && !r.failed; id++) {
+        size_t size = (size_t)getBounded(&r, INT_MAX);
+        if (size > (size_t)(r.end - r.pos)) break;
+        // the names were distinct when written, so each one gets its old id back
+        if (intern(&unit->names, (const char*)r.pos, size) != id) r.failed = 1;
+        r.pos += size;
+    }
+    if (unit->names.count != count) r.failed = 1;
+    ASTNode* root = r.failed ? NULL : getNode(&r);
+    if (r.failed || !root || root->type != NODE_PROG || r.pos != r.end) return 0;
+    unit->root = root;
+    return 1;
+}
+
+// Function to record the current stamp of the source in a cache file whose
+// source hash matched, so that the next run skips the hash again
+static void refreshStamp(const CacheEntry* entry, CacheHeader* header) {
+    if (entry->header.inode == 0) return;
+    int fd = open(entry->path, O_WRONLY);
+    if (fd < 0) return;
+    header->device = entry->header.device;
+    header->inode = entry->header.inode;
+    header->mtimeSeconds = entry->header.mtimeSeconds;
+    header->mtimeNanos = entry->header.mtimeNanos;
+    // the stamp is the only part that changes, so a reader of a torn header at
+    // worst hashes the source, and a failed write only costs the next run a hash
+    ssize_t written = pwrite(fd, header, sizeof(CacheHeader), 0);
+    (void)written;
+    close(fd);
+}
+
+// Function to load the tree of a unit from its entry, returns 1 on a hit. The
+// source is hashed only if its stamp differs from the stored one.
+static int loadCachedUnit(CompilationUnit* unit, const CompileOptions* options, CacheEntry* entry) {
+    int fd = open(entry->path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    unsigned char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+
+    CacheHeader header;
+    const CacheHeader* expected = &entry->header;
+    memcpy(&header, data, sizeof(header));
+    const unsigned char* payload = data + sizeof(header);
+    int hit = memcmp(header.magic, expected->magic, sizeof(header.magic)) == 0 &&
+              header.format == expected->format && header.fold == expected->fold &&
+              header.versionHash == expected->versionHash && header.sourceLength == expected->sourceLength &&
+              header.payloadLength == size - sizeof(header) &&
+              header.payloadHash == hashBytes(HASH_SEED, payload, header.payloadLength);
+    int stale = hit && !sameStamp(&header, expected);
+    if (stale) {
+        hit = hashSource(unit->path, entry) && header.sourceHash == expected->sourceHash;
+        if (hit) refreshStamp(entry, &header);
+    }
+    if (hit) {
+        madvise(data, size, MADV_SEQUENTIAL);
+        hit = readPayload(unit, payload, header.payloadLength);
+        if (!hit) {
+            // start the unit over for the parser
+            internFree(&unit->names);
+            arenaFree(&unit->arena);
+            arenaInit(&unit->arena);
+            internInit(&unit->names, &unit->arena);
+        }
+    }
+    munmap(data, size);
+    unit->cached = hit;
+    unit->folded = hit && options->fold;
+    return hit;
+}
+
+// Function to load a unit from the cache or parse it, a parsed unit is folded
+// and stored for the next run
+int parseOrLoadUnit(CompilationUnit* unit, const CompileOptions* options) {
+    CacheEntry entry;
+    if (!options->cacheDir || !identifySource(unit->path, options, options->cacheDir, &entry)) return parseUnit(unit);
+    if (loadCachedUnit(unit, options, &entry)) return 0;
+    int status = parseUnit(unit);
+    if (status == 0) {
+        if (options->fold) {
+            unit->root = foldConstants(&unit->arena, unit->root);
+            unit->folded = 1;
+        }
+        // the source was hashed at most once, here or in loadCachedUnit
+        storeCachedUnit(unit, &entry, options->cacheDir);
+    }
+    return status;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <pthread.h>
+#include "driver.h"
+#include "fold.h"
+#include "bounds.h"
+#include "parallel.h"
+#include "cache.h"
+
+// Function to fold and resolve a parsed unit
+void analyzeUnit(CompilationUnit* unit, const CompileOptions* options) {
+    if (unit->symbols) return;
+    if (options->fold && !unit->folded) unit->root = foldConstants(&unit->arena, unit->root);
+    unit->symbols = resolveProgram(&unit->arena, &unit->names, unit->root);
+    markCountedLoops(unit->root, unit->symbols);
+    if (options->parallel) markParallelLoops(&unit->arena, unit->root, unit->symbols);
+    if (options->hoist) hoistBoundsChecks(unit->root, unit->symbols);
+}
+
+// Function to get the optimized three address code of a unit
+TACProgram* unitTAC(CompilationUnit* unit, const CompileOptions* options) {
+    analyzeUnit(unit, options);
+    if (!unit->tac) {
+        unit->tac = generate3AC(unit->root, unit->symbols);
+        optimizeTAC(unit->tac, options->passes);
+        if (options->registers) allocateRegisters(unit->tac, options->registers);
+    }
+    return unit->tac;
+}
+
+// Shared state of a batch: workers take the next file index under the lock
+typedef struct {
+    char** files;
+    int nfiles;
+    int next;
+    int failed;
+    char** results;     // status line of each file
+    const CompileOptions* options;
+    pthread_mutex_t lock;
+} Batch;
+
+static char* formatResult(const char* fmt, ...) {
+    va_list args, copy;
+    va_start(args, fmt);
+    va_copy(copy, args);
+    int size = vsnprintf(NULL, 0, fmt, copy) + 1;
+    va_end(copy);
+    char* line = malloc(size);
+    if (!line) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    vsnprintf(line, size, fmt, args);
+    va_end(args);
+    return line;
+}
+
+// Function to run one file through every compile phase, returns its status line
+static char* compileFile(const char* path, const CompileOptions* options, int* ok) {
+    CompilationUnit* unit = createCompilationUnit(path);
+    char* result;
+    int status = parseOrLoadUnit(unit, options);
+    *ok = status == 0;
+    if (status < 0) {
+        result = formatResult("%s: Error opening file: %s\n", path, strerror(errno));
+    } else if (status > 0) {
+        result = formatResult("%s: %s", path, unit->error);
+    } else {
+        TACProgram* tac = unitTAC(unit, options);
+        unit->program = compileBytecode(unit->root, unit->symbols);
+        if (tac->unallocated)
+            result = formatResult("%s: ok (%d quads, %d instructions, %d run-time diagnostics, peak register pressure %d)\n",
+                                  path, tac->ncode, unit->program->ncode, tac->nmsgs, tac->pressure);
+        else
+            result = formatResult("%s: ok (%d quads, %d instructions, %d run-time diagnostics)\n",
+                                  path, tac->ncode, unit->program->ncode, tac->nmsgs);
+    }
+    freeCompilationUnit(unit);
+    return result;
+}
+
+static void* batchWorker(void* arg) {
+    Batch* batch = arg;
+    for (;;) {
+        pthread_mutex_lock(&batch->lock);
+        int i = batch->next++;
+        pthread_mutex_unlock(&batch->lock);
+        if (i >= batch->nfiles) break;
+
+        int ok;
+        char* result = compileFile(batch->files[i], batch->options, &ok);
+        pthread_mutex_lock(&batch->lock);
+        batch->results[i] = result;
+        if (!ok) batch->failed++;
+        pthread_mutex_unlock(&batch->lock);
+    }
+    return NULL;
+}
+
+// Function to compile a list of files in parallel
+int compileBatch(char** files, int nfiles, int threads, const CompileOptions* options) {
+    char** results = calloc(nfiles + 1, sizeof(char*));
+    pthread_t* workers = malloc((threads + 1) * sizeof(pthread_t));
+    if (!results || !workers) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    Batch batch = {.files = files, .nfiles = nfiles, .results = results, .options = options};
+    pthread_mutex_init(&batch.lock, NULL);
+    if (threads > nfiles) threads = nfiles;
+
+    // the calling thread works too
+    int started = 0;
+    while (started < threads - 1 && pthread_create(&workers[started], NULL, batchWorker, &batch) == 0) started++;
+    batchWorker(&batch);
+    for (int t = 0; t < started; t++) pthread_join(workers[t], NULL);
+
+    for (int i = 0; i < nfiles; i++) {
+        fputs(batch.results[i], stdout);
+        free(batch.results[i]);
+    }
+    printf("%d of %d files compiled\n", nfiles - batch.failed, nfiles);
+
+    pthread_mutex_destroy(&batch.lock);
+    free(batch.results);
+    free(workers);
+    return batch.failed;
+}
@@ -4,36 +4,62 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/resource.h>
 #include "ast.h"
-extern FILE *yyin;
-extern int yylineno;
-extern char* yytext;
-int yyparse();
-void yyerror(const char *s);
-int yylex();
-ASTNode* root;
+#include "unit.h"
+#include "driver.h"
+#include "cache.h"
+#include "output.h"
+#include "input.h"
+#include "profile.h"
+#include "parallel.h"
 %}
 
 %code requires { 
     #include "ast.h"
+    #include "unit.h"
     #include "3_ac.h"
     #include "simulation.h"
+    #include "bytecode.h"
+    #ifndef YY_TYPEDEF_YY_SCANNER_T
+    #define YY_TYPEDEF_YY_SCANNER_T
+    typedef void* yyscan_t;
+    #endif
 }
 
+%code {
+    // Reentrant scanner interface generated by flex from parser.l
+    int yylex(YYSTYPE* yylval, YYLTYPE* yylloc, yyscan_t scanner);
+    int yylex_init_extra(CompilationUnit* unit, yyscan_t* scanner);
+    void yyset_in(FILE* in, yyscan_t scanner);
+    struct yy_buffer_state* yy_scan_buffer(char* base, size_t size, yyscan_t scanner);
+    char* yyget_text(yyscan_t scanner);
+    void yyset_lineno(int line, yyscan_t scanner);
+    void yyset_column(int column, yyscan_t scanner);
+    int yylex_destroy(yyscan_t scanner);
+    void yyerror(YYLTYPE* loc, yyscan_t scanner, CompilationUnit* unit, const char* s);
+}
+
+%define api.pure full
+%locations
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner} {CompilationUnit* unit}
+
 %union {
     char* str;
     int num;
     char c;
+    int name;   // interned identifier
+    Operator op;
     ASTNode* ast;
     struct {
         int val;
         int base;
     } pair;
     ll * l;
-    struct {
-        char* str;
-        int inc; // inc if 1
-    } incdec;
     struct {
         ll* l;
         int count;
@@ -45,15 +71,16 @@ ASTNode* root;
 %token <str>  STRINGCONST 
 %token <c> CHARCONST
 %token <pair> INTCONST
-%token <ast> ID
+%token <name> ID
 
 %token BEGI END PROGRAM VARDECL
 %token <str> PRINT SCAN IF ELSE WHILE FOR INT CHAR
-%token TO THEN DO NUM
-%token <str> INC DEC
-%token <str> ADD SUB MUL DIV MOD
-%token <str> ASSIGN ADD_ASSIGN SUB_ASSIGN MUL_ASSIGN DIV_ASSIGN MOD_ASSIGN
-%token <str> GT LT GE LE EQ NE
+%token TO THEN DO
+%token <num> NUM
+%token <op> INC DEC
+%token <op> ADD SUB MUL DIV MOD
+%token <op> ASSIGN ADD_ASSIGN SUB_ASSIGN MUL_ASSIGN DIV_ASSIGN MOD_ASSIGN
+%token <op> GT LT GE LE EQ NE
 
 %token LPAREN RPAREN LBRACKET RBRACKET SEMICOLON COLON COMMA
 
@@ -61,53 +88,64 @@ ASTNode* root;
 %left ADD SUB
 %left MUL DIV MOD
 
-%type <str> Type AssignOp RelOp
-%type <incdec> ForIncDec
+%type <str> Type
+%type <op> AssignOp RelOp ForIncDec
 %type <arglist> ExpList IdList ScanArgs  PrintArgs
-%type <ast> Program VarDeclBlock VarDeclList VarDecl StmtBlock BlockStmt Stmt AssignStmt IfStmt WhileStmt ForStmt PrintStmt ScanStmt Exp Condition Var
+%type <ast> Program VarDeclBlock VarDeclList VarDecl StmtBlock BlockStmt Stmt AssignStmt IfStmt WhileStmt ForStmt PrintStmt ScanStmt Exp Condition Var Index
 
 %%
 
 Program         : BEGI PROGRAM COLON VarDeclBlock StmtBlock END PROGRAM     {   
-                                                                                $$ = createProgramNode(NODE_PROG,$4, $5);
-                                                                                root = $$; 
+                                                                                $$ = createProgramNode(&unit->arena, NODE_PROG,$4, $5);
+                                                                                unit->root = $$; 
                                                                             }
                 ;
 
-VarDeclBlock    : BEGI VARDECL COLON VarDeclList END VARDECL {$$ = $4;}
+VarDeclBlock    : BEGI VARDECL COLON VarDeclList END VARDECL {$$ = reverseVarDeclList($4);}
                 ;
 
-VarDeclList     : VarDecl VarDeclList {$1->data.var_list.next = $2; $$ = $1;}
+VarDeclList     : VarDeclList VarDecl {$2->data.var_list.next = $1; $$ = $2;} // built reversed to keep the parser stack flat
                 | /* empty */ {$$ = NULL;}
                 ;
 
-VarDecl         : LPAREN Var COMMA Type RPAREN SEMICOLON {$$ = createVarDeclNode(NODE_VARDEC, $4, $2, NULL);  }
+VarDecl         : LPAREN Var COMMA Type RPAREN SEMICOLON {$$ = createVarDeclNode(&unit->arena, NODE_VARDEC, $4, $2, NULL);  }
                 ;
 
-Var             : ID {$$ = $1;}
-                | ID LBRACKET NUM RBRACKET {$$ = $1;} // Find a way to store the number and pass it to simulation.h
+Var             : ID {$$ = createVariable(&unit->arena, &unit->names, $1);}
+                | ID LBRACKET NUM RBRACKET {
+                                                if ($3 <= 0 || $3 > MAX_ARRAY_LENGTH) {
+                                                    yyerror(&@3, scanner, unit, "invalid array size");
+                                                    YYERROR;
+                                                }
+                                                $$ = createArrayVariable(&unit->arena, &unit->names, $1, $3);
+                                            }
                 ;
 
 Type            : INT {$$ = $1;}
                 | CHAR {$$ = $1;}
                 ;
 
-StmtBlock       : /* empty */ { $$ = createStatementsNode();}
-                | StmtBlock Stmt { $$ = addStatement($1, $2);}
+StmtBlock       : /* empty */ { $$ = createStatementsNode(&unit->arena);}
+                | StmtBlock Stmt { $$ = addStatement(&unit->arena, $1, $2);}
                 ;
 
 BlockStmt       : BEGI StmtBlock END {$$ = $2;}
                 ;
 
-Stmt            : AssignStmt {$$ = $1;}
-                | IfStmt {$$ = $1;}
-                | WhileStmt {$$ = $1;}
-                | ForStmt {$$ = $1;}
-                | PrintStmt {$$ = $1;}
-                | ScanStmt {$$ = $1;}
+Stmt            : AssignStmt {$$ = setLocation($1, @1.first_line, @1.first_column);}
+                | IfStmt {$$ = setLocation($1, @1.first_line, @1.first_column);}
+                | WhileStmt {$$ = setLocation($1, @1.first_line, @1.first_column);}
+                | ForStmt {$$ = setLocation($1, @1.first_line, @1.first_column);}
+                | PrintStmt {$$ = setLocation($1, @1.first_line, @1.first_column);}
+                | ScanStmt {$$ = setLocation($1, @1.first_line, @1.first_column);}
+                ;
+
+AssignStmt      : ID AssignOp Exp SEMICOLON {$$ = createOperatorNode(&unit->arena, NODE_ASSIGN, createVariable(&unit->arena, &unit->names, $1), $3, $2);}
+                | ID LBRACKET Index RBRACKET AssignOp Exp SEMICOLON {$$ = createOperatorNode(&unit->arena, NODE_ASSIGN, createIndexNode(&unit->arena, createVariable(&unit->arena, &unit->names, $1), $3), $6, $5);}
                 ;
 
-AssignStmt      : ID AssignOp Exp SEMICOLON {$$ = createOperatorNode(NODE_ASSIGN, $1, $3, $2);} // add array assign below as needed
+Index           : Exp {$$ = $1;}
+                | NUM {$$ = createNumberNode(&unit->arena, $1, 10);}
                 ;
 
 AssignOp        : ASSIGN {$$ = $1;}
@@ -118,54 +156,55 @@ AssignOp        : ASSIGN {$$ = $1;}
                 | MOD_ASSIGN {$$ = $1;} 
                 ;
 
-IfStmt		    : IF LPAREN Condition RPAREN BlockStmt SEMICOLON   {$$ = createIfOrWhileLoopNode(NODE_IF, $3, $5);}      
-                | IF LPAREN Condition RPAREN BlockStmt ELSE BlockStmt SEMICOLON  {$$ = createIfElseLadderNode(NODE_IF_ELSE, $3, $5, $7);} 
+IfStmt		    : IF LPAREN Condition RPAREN BlockStmt SEMICOLON   {$$ = createIfOrWhileLoopNode(&unit->arena, NODE_IF, $3, $5);}      
+                | IF LPAREN Condition RPAREN BlockStmt ELSE BlockStmt SEMICOLON  {$$ = createIfElseLadderNode(&unit->arena, NODE_IF_ELSE, $3, $5, $7);} 
                 ;
                 
-WhileStmt	    : WHILE LPAREN Condition RPAREN DO BlockStmt SEMICOLON {$$ = createIfOrWhileLoopNode(NODE_WHILE, $3, $6);}
+WhileStmt	    : WHILE LPAREN Condition RPAREN DO BlockStmt SEMICOLON {$$ = createIfOrWhileLoopNode(&unit->arena, NODE_WHILE, $3, $6);}
          	    ;
 
-ForStmt         : FOR ID ASSIGN Exp TO Exp ForIncDec Exp DO BlockStmt SEMICOLON {$$ = createForLoopNode(NODE_FOR, $2, createOperatorNode(NODE_ASSIGN, $2, $4, $3), $6, createOperatorNode((($<incdec.inc>7 ==1)? NODE_INC : NODE_DEC), $8, NULL, $<incdec.str>7), $10);}
+ForStmt         : FOR ID ASSIGN Exp TO Exp ForIncDec Exp DO BlockStmt SEMICOLON {ASTNode* var = createVariable(&unit->arena, &unit->names, $2); $$ = createForLoopNode(&unit->arena, NODE_FOR, createOperatorNode(&unit->arena, NODE_ASSIGN, var, $4, $3), $6, createOperatorNode(&unit->arena, (($7 == OPR_INC)? NODE_INC : NODE_DEC), $8, NULL, $7), $10);}
                 ;
 
-ForIncDec       : INC {$$.inc = 1; $$.str = $1;}
-                | DEC {$$.str = $1; $$.inc = 0;}
+ForIncDec       : INC {$$ = $1;}
+                | DEC {$$ = $1;}
                 ;
 
-PrintStmt       : PRINT LPAREN STRINGCONST PrintArgs RPAREN SEMICOLON {$$ = createPrintOrScanNode(NODE_PRINT, "print", $3, $<arglist.l>4, $<arglist.count>4); }
+PrintStmt       : PRINT LPAREN STRINGCONST PrintArgs RPAREN SEMICOLON {$$ = createPrintOrScanNode(&unit->arena, NODE_PRINT, $3, $<arglist.l>4, $<arglist.count>4); }
                 ;
 
 PrintArgs       : COMMA ExpList {$$ = $2;}
                 | {$<arglist.l>$ = (ll*)NULL; $<arglist.count>$ = 0;}
                 ;
 
-ExpList         : Exp {$<arglist.l>$ = createArgList($1->data.identifier, NULL); $<arglist.count>$ = 1;}
-                | Exp COMMA ExpList {$<arglist.l>$ = createArgList($1->data.identifier, $<arglist.l>3); $<arglist.count>$ = $<arglist.count>3 + 1;}
+ExpList         : Exp {$<arglist.l>$ = createArgList(&unit->arena, $1->data.var.identifier, $1->data.var.name, NULL); $<arglist.count>$ = 1;}
+                | Exp COMMA ExpList {$<arglist.l>$ = createArgList(&unit->arena, $1->data.var.identifier, $1->data.var.name, $<arglist.l>3); $<arglist.count>$ = $<arglist.count>3 + 1;}
                 ;
 
-ScanStmt        : SCAN LPAREN STRINGCONST ScanArgs RPAREN SEMICOLON { $$ = createPrintOrScanNode(NODE_SCAN, "scan", $3, $<arglist.l>4, $<arglist.count>4);}
+ScanStmt        : SCAN LPAREN STRINGCONST ScanArgs RPAREN SEMICOLON { $$ = createPrintOrScanNode(&unit->arena, NODE_SCAN, $3, $<arglist.l>4, $<arglist.count>4);}
                 ;
 
 ScanArgs        : COMMA IdList {$$ = $2;}
                 | {$<arglist.l>$ = (ll*)NULL; $<arglist.count>$ = 0;}
                 ;
 
-IdList          : ID {$<arglist.l>$ = createArgList($1->data.identifier, NULL); $<arglist.count>$ = 1;}
-                | ID COMMA IdList {$<arglist.l>$ = createArgList($1->data.identifier, $<arglist.l>3); $<arglist.count>$ = $<arglist.count>3 + 1;}
+IdList          : ID {$<arglist.l>$ = createArgList(&unit->arena, unit->names.strings[$1], $1, NULL); $<arglist.count>$ = 1;}
+                | ID COMMA IdList {$<arglist.l>$ = createArgList(&unit->arena, unit->names.strings[$1], $1, $<arglist.l>3); $<arglist.count>$ = $<arglist.count>3 + 1;}
                 ;
 
-Exp	  	        : ID {$$ =$1;}
-                | CHARCONST {$$ = createCharacterNode($1);}
-                | INTCONST { $$ = createNumberNode($<pair.val>1, $<pair.base>1);}
+Exp	  	        : ID {$$ = createVariable(&unit->arena, &unit->names, $1);}
+                | ID LBRACKET Index RBRACKET {$$ = createIndexNode(&unit->arena, createVariable(&unit->arena, &unit->names, $1), $3);}
+                | CHARCONST {$$ = createCharacterNode(&unit->arena, $1);}
+                | INTCONST { $$ = createNumberNode(&unit->arena, $<pair.val>1, $<pair.base>1);}
                 | LPAREN Exp RPAREN {$$ = $2;}
-                | Exp ADD Exp { $$ = createOperatorNode(NODE_OP, $1, $3, $2);}
-                | Exp SUB Exp { $$ = createOperatorNode(NODE_OP, $1, $3, $2);}
-                | Exp MUL Exp { $$ = createOperatorNode(NODE_OP, $1, $3, $2);}
-                | Exp DIV Exp { $$ = createOperatorNode(NODE_OP, $1, $3, $2);}
-                | Exp MOD Exp { $$ = createOperatorNode(NODE_OP, $1, $3, $2);}
+                | Exp ADD Exp { $$ = createOperatorNode(&unit->arena, NODE_OP, $1, $3, $2);}
+                | Exp SUB Exp { $$ = createOperatorNode(&unit->arena, NODE_OP, $1, $3, $2);}
+                | Exp MUL Exp { $$ = createOperatorNode(&unit->arena, NODE_OP, $1, $3, $2);}
+                | Exp DIV Exp { $$ = createOperatorNode(&unit->arena, NODE_OP, $1, $3, $2);}
+                | Exp MOD Exp { $$ = createOperatorNode(&unit->arena, NODE_OP, $1, $3, $2);}
                 ;
 
-Condition       : Exp RelOp Exp {$$ = createOperatorNode(NODE_RELOP, $1, $3, $2);}
+Condition       : Exp RelOp Exp {$$ = createOperatorNode(&unit->arena, NODE_RELOP, $1, $3, $2);}
                 ;
 
 RelOp           : GT {$$ = $1;}
@@ -178,49 +217,316 @@ RelOp           : GT {$$ = $1;}
 
 %%
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Error : %s before token '%s'\n", s, yytext);
+void yyerror(YYLTYPE* loc, yyscan_t scanner, CompilationUnit* unit, const char *s) {
+    (void)loc;
+    if (!unit->error[0]) snprintf(unit->error, sizeof(unit->error), "Error : %s before token '%s'\n", s, yyget_text(scanner));
 }
 
-void inputLoop(){
-    printf("1. AST\n2. 3 Address Code\n3. Simulation of code\n");
-    printf("Select an option (1-3, 0 to exit): \n");
+int mapSources = 1;
+
+// Function to parse the unit's source file, every call gets a scanner of its own.
+// The file is scanned in place from a mapping; other files go through stdio.
+int parseUnit(CompilationUnit* unit){
+    SourceMap* map = &unit->source;
+    FILE* in = NULL;
+    int mapped = mapSources ? mapSourceFile(unit->path, map) : 1;
+    if(mapped < 0) return -1;
+    if(mapped > 0 && !(in = fopen(unit->path, "r"))) return -1;
+
+    yyscan_t scanner;
+    if(yylex_init_extra(unit, &scanner) != 0 || (!in && !yy_scan_buffer(map->text, map->length + 2, scanner))){
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    if(in){
+        yyset_in(in, scanner);
+    }else{
+        // buffers given to flex do not start with a position
+        yyset_lineno(1, scanner);
+        yyset_column(0, scanner);
+    }
+    int status = yyparse(scanner, unit) == 0 ? 0 : 1;
+    yylex_destroy(scanner);
+    if(in) fclose(in);
+    unmapSourceFile(map);
+    return status;
+}
+
+ExecEngine engine = ENGINE_VM;
+int dumpBytecode = 0;
+CompileOptions options = {1, PASS_ALL, 1, TAC_REGISTERS, NULL, 1};
+int caching = 1;
+char* emitCPath = NULL;
+int showStats = 0;
+int profiling = 0;
+char* profilePath = NULL;
+int benchmarking = 0;
+
+void inputLoop(CompilationUnit* unit){
+    analyzeUnit(unit, &options);
+    ASTNode* root = unit->root;
+    printf("1. AST\n2. 3 Address Code\n3. Simulation of code\n4. C code\n");
+    printf("Select an option (1-4, 0 to exit): \n");
     int choice;
-    scanf("%d", &choice);
+    inputScanInt(&choice);
     while(choice != 0){
         if(choice == 1){
             printf("---------------------\nAbstract Syntax Tree: \n---------------------\n");
             printAST(root); 
         }else if(choice == 2){
             printf("---------------\n3 Address Code: \n---------------\n");
-            generate3AC(root);
+            TACProgram* tac = unitTAC(unit, &options);
+            printTAC(tac, stdout);
+            if(options.passes) printf("\nInstructions: %d before optimization, %d after\n", tac->unoptimized, tac->ncode);
+            if(options.passes & PASS_STRENGTH) printf("Strength reduction: %d multiplications in %d loops replaced by %d running additions, %d fewer multiplications per iteration\n",
+                                                     tac->reducedMuls, tac->reducedLoops, tac->runningAdds, tac->mulsPerIteration);
+            if(tac->unallocated) printf("Temps: %d in %d registers and %d spill slots, peak register pressure %d\n",
+                                        tac->unallocated, tac->registers, tac->spillSlots, tac->pressure);
         }else if(choice == 3){
             printf("-------------------------\nOutput of your test code:\n-------------------------\n"); 
-            evaluateAST(root);
-            printSymbolTable();
+            Frame* frame = createFrame(unit->symbols);
+            if(profiling){
+                // statements are only timed by the tree walker
+                frame->profile = createProfile(root, profilePath);
+                startProfile(frame->profile);
+                evaluateAST(root, frame);
+                finishProfile(frame->profile, stderr);
+                freeProfile(frame->profile);
+            }else if(engine == ENGINE_TREE){
+                evaluateAST(root, frame);
+            }else{
+                if(!unit->program){
+                    if(engine == ENGINE_TAC){
+                        unit->program = assembleTAC(unitTAC(unit, &options));
+                    }else{
+                        unit->program = compileBytecode(root, unit->symbols);
+                    }
+                    if(dumpBytecode) printBytecode(unit->program);
+                    if(engine == ENGINE_JIT && !(unit->native = compileNative(unit->program))){
+                        fprintf(stderr, "Native code is not supported here, using the VM\n");
+                        engine = ENGINE_VM;
+                    }
+                }
+                if(unit->native) runNative(unit->native, frame);
+                else runBytecode(unit->program, frame);
+            }
+            printSymbolTable(frame);
+            freeFrame(frame);
+        }else if(choice == 4){
+            printf("-------\nC code: \n-------\n");
+            generateC(unitTAC(unit, &options), stdout);
         }else{
             printf("Try a valid choice!\n");
         }
-        printf("\nSelect an option (1-3, 0 to exit): \n");
-        scanf("%d", &choice);
+        printf("\nSelect an option (1-4, 0 to exit): \n");
+        inputScanInt(&choice);
     } 
-    freeAST(root);
+}
+
+// Function to translate the program to a C file without entering the menu
+int emitC(CompilationUnit* unit, const char* path){
+    TACProgram* tac = unitTAC(unit, &options);
+    FILE* out = fopen(path, "w");
+    if(!out){
+        perror("Error opening output file");
+        return 1;
+    }
+    generateC(tac, out);
+    fclose(out);
+    return 0;
+}
+
+static double elapsedMs(const struct timespec* start){
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e3 + (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Function to time every phase of one file separately for make bench. The AST and
+// the program output go to /dev/null, the timings to the original stdout as
+// "<file>\t<phase>\t<ms>" lines. Program input is read from stdin.
+int benchmark(const char* path){
+    fflush(stdout);
+    int null = open("/dev/null", O_WRONLY);
+    int saved = dup(STDOUT_FILENO);
+    FILE* report = saved >= 0 ? fdopen(saved, "w") : NULL;
+    if(null < 0 || !report || dup2(null, STDOUT_FILENO) < 0){
+        perror("Error redirecting output");
+        return 1;
+    }
+    close(null);
+    const char* name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    struct timespec start;
+
+    CompilationUnit* unit = createCompilationUnit(path);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = parseUnit(unit);
+    double parse = elapsedMs(&start);
+    if(status != 0){
+        if(status < 0) perror("Error opening file");
+        else fputs(unit->error, stderr);
+        freeCompilationUnit(unit);
+        fclose(report);
+        return 1;
+    }
+    fprintf(report, "%s\tparse\t%.3f\n", name, parse);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    analyzeUnit(unit, &options);
+    fprintf(report, "%s\tanalyze\t%.3f\n", name, elapsedMs(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    printAST(unit->root);
+    fflush(stdout);
+    fprintf(report, "%s\tast\t%.3f\n", name, elapsedMs(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unit->tac = generate3AC(unit->root, unit->symbols);
+    fprintf(report, "%s\ttac\t%.3f\n", name, elapsedMs(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    optimizeTAC(unit->tac, options.passes);
+    fprintf(report, "%s\toptimize\t%.3f\n", name, elapsedMs(&start));
+
+    if(options.registers){
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        allocateRegisters(unit->tac, options.registers);
+        fprintf(report, "%s\tregalloc\t%.3f\n", name, elapsedMs(&start));
+    }
+
+    Frame* frame = createFrame(unit->symbols);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    evaluateAST(unit->root, frame);
+    fflush(stdout);
+    fprintf(report, "%s\teval\t%.3f\n", name, elapsedMs(&start));
+
+    freeFrame(frame);
+    freeCompilationUnit(unit);
+    fclose(report);
+    return 0;
+}
+
+void usage(const char* prog){
+    fprintf(stderr, "Usage: %s [--engine=vm|tac|jit|tree] [--dump-bytecode] [--no-fold] [--no-hoist] [--passes=propagate,cse,dce,peephole,sccp,licm,strength|all|none] [--registers=<n>] [--emit-c=<file>] [--no-mmap] [--stats] [--profile[=<file>]] [--threads=<n>] [--cache-dir=<dir>|--no-cache] <input file>\n", prog);
+    fprintf(stderr, "       %s --batch [--jobs=<n>] [--no-fold] [--no-hoist] [--passes=...] [--registers=<n>] [--cache-dir=<dir>|--no-cache] <input file>...\n", prog);
+    fprintf(stderr, "       %s --bench [--threads=<n>] [--no-fold] [--no-hoist] [--passes=...] [--registers=<n>] <input file>\n", prog);
 }
 
 int main(int argc, char *argv[]){
-    if (argc != 2){
-        fprintf(stderr, "Usage: %s <input file>\n", argv[0]);
+    initOutput();
+    char** files = malloc(argc * sizeof(char*));
+    int nfiles = 0;
+    int batch = 0;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    long threads = jobs;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--engine=vm") == 0){
+            engine = ENGINE_VM;
+        }else if (strcmp(argv[i], "--engine=tac") == 0){
+            engine = ENGINE_TAC;
+        }else if (strcmp(argv[i], "--engine=jit") == 0){
+            engine = ENGINE_JIT;
+        }else if (strcmp(argv[i], "--engine=tree") == 0){
+            engine = ENGINE_TREE;
+        }else if (strcmp(argv[i], "--dump-bytecode") == 0){
+            dumpBytecode = 1;
+        }else if (strcmp(argv[i], "--no-fold") == 0){
+            options.fold = 0;
+        }else if (strcmp(argv[i], "--no-hoist") == 0){
+            options.hoist = 0;
+        }else if (strncmp(argv[i], "--passes=", 9) == 0){
+            options.passes = parseTACPasses(argv[i] + 9);
+            if (options.passes < 0){
+                usage(argv[0]);
+                return 1;
+            }
+        }else if (strncmp(argv[i], "--registers=", 12) == 0 && argv[i][12]){
+            char* end;
+            long n = strtol(argv[i] + 12, &end, 10);
+            if (*end || n < 0 || n > 1 << 20){
+                usage(argv[0]);
+                return 1;
+            }
+            options.registers = (int)n;
+        }else if (strncmp(argv[i], "--emit-c=", 9) == 0 && argv[i][9]){
+            emitCPath = argv[i] + 9;
+        }else if (strcmp(argv[i], "--no-mmap") == 0){
+            mapSources = 0;
+        }else if (strcmp(argv[i], "--stats") == 0){
+            showStats = 1;
+        }else if (strcmp(argv[i], "--profile") == 0){
+            profiling = 1;
+        }else if (strncmp(argv[i], "--profile=", 10) == 0 && argv[i][10]){
+            profiling = 1;
+            profilePath = argv[i] + 10;
+        }else if (strncmp(argv[i], "--cache-dir=", 12) == 0 && argv[i][12]){
+            options.cacheDir = argv[i] + 12;
+        }else if (strcmp(argv[i], "--no-cache") == 0){
+            caching = 0;
+        }else if (strcmp(argv[i], "--bench") == 0){
+            benchmarking = 1;
+        }else if (strcmp(argv[i], "--batch") == 0){
+            batch = 1;
+        }else if (strncmp(argv[i], "--jobs=", 7) == 0 && atoi(argv[i] + 7) > 0){
+            jobs = atoi(argv[i] + 7);
+        }else if (strncmp(argv[i], "--threads=", 10) == 0 && atoi(argv[i] + 10) > 0){
+            threads = atoi(argv[i] + 10);
+        }else if (argv[i][0] == '-' || (nfiles && !batch)){
+            usage(argv[0]);
+            return 1;
+        }else{
+            files[nfiles++] = argv[i];
+        }
+    }
+    if (!nfiles || (nfiles > 1 && !batch)){
+        usage(argv[0]);
         return 1;
     }
-    yyin = fopen(argv[1], "r");
-    if (!yyin){
+    // trees are cached in the user's cache directory unless told otherwise
+    if (!caching) options.cacheDir = NULL;
+    else if (!options.cacheDir) options.cacheDir = defaultCacheDir();
+    setWorkerThreads(threads > 0 ? (int)threads : 1);
+    // batches only compile, and the 3AC engine runs every loop on the calling thread
+    options.parallel = threads > 1 && !batch && (benchmarking || engine != ENGINE_TAC);
+    if (batch){
+        int failed = compileBatch(files, nfiles, jobs > 0 ? (int)jobs : 1, &options);
+        free(files);
+        return failed ? 1 : 0;
+    }
+
+    if (benchmarking){
+        int failed = benchmark(files[0]);
+        free(files);
+        return failed;
+    }
+
+    CompilationUnit* unit = createCompilationUnit(files[0]);
+    free(files);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = parseOrLoadUnit(unit, &options);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (showStats){
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        fprintf(stderr, "Parsed %s in %.2f ms (%s), peak RSS %ld KB\n", unit->path,
+                (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6,
+                unit->cached ? "cache" : mapSources ? "mmap" : "stdio", usage.ru_maxrss);
+    }
+    if (status < 0){
         perror("Error opening file");
+        freeCompilationUnit(unit);
         return 1;
     }
-    if (yyparse() == 0){
+    if (status > 0){
+        fputs(unit->error, stderr);
+        status = 0;
+    }else if (emitCPath){
+        status = emitC(unit, emitCPath);
+    }else{
         printf("Input successfully parsed.\n");
-        inputLoop();
+        inputLoop(unit);
     }
-    fclose(yyin);
-    return 0;
+    freeCompilationUnit(unit);
+    return status;
 }
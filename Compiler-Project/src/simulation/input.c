@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "input.h"
+#include "output.h"
+#include "simulation.h"
+
+#define INPUT_BLOCK_SIZE (1 << 16)
+
+// Unread input is pos .. end, either the mapped file or the last block read
+static struct {
+    const unsigned char* pos;
+    const unsigned char* end;
+    unsigned char* buffer;
+    int started;
+    int eof;
+} in;
+
+// Function to map stdin if it is a regular file, starting at the current offset
+static void mapInput(void) {
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return;
+    off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+    if (offset < 0 || offset >= st.st_size) return;
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+    if (map == MAP_FAILED) return;
+    in.pos = (const unsigned char*)map + offset;
+    in.end = (const unsigned char*)map + st.st_size;
+    in.eof = 1;     // the whole file is visible, nothing left to read
+}
+
+// Function to make more input available, returns 0 at end of input
+static int refill(void) {
+    if (!in.started) {
+        in.started = 1;
+        mapInput();
+        if (in.pos != in.end) return 1;
+    }
+    if (in.eof) return 0;
+    if (!in.buffer && !(in.buffer = malloc(INPUT_BLOCK_SIZE))) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    flushOutputForInput();
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, in.buffer, INPUT_BLOCK_SIZE);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        in.eof = 1;
+        return 0;
+    }
+    in.pos = in.buffer;
+    in.end = in.buffer + n;
+    return 1;
+}
+
+static inline int peekChar(void) {
+    if (in.pos == in.end && !refill()) return EOF;
+    return *in.pos;
+}
+
+int inputChar(void) {
+    int c = peekChar();
+    if (c != EOF) in.pos++;
+    return c;
+}
+
+// Skips white space like a scanf directive, returns the next character
+static int skipSpace(void) {
+    int c;
+    while ((c = peekChar()) == ' ' || (c >= '\t' && c <= '\r')) in.pos++;
+    return c;
+}
+
+// Consumes c if it is the next character, a mismatch is left unread
+static int matchChar(int c) {
+    if (peekChar() != c) return 0;
+    in.pos++;
+    return 1;
+}
+
+// Function to parse a decimal integer with scanf's %d rules: the value is read
+// as a long that saturates on overflow, then narrowed to int
+int inputScanInt(int* value) {
+    int c = skipSpace();
+    if (c == EOF) return EOF;
+    int negative = 0;
+    if (c == '-' || c == '+') {
+        negative = c == '-';
+        in.pos++;
+        c = peekChar();
+    }
+    if (c < '0' || c > '9') return 0;
+
+    unsigned long magnitude = 0;
+    unsigned long limit = negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    int overflow = 0;
+    do {
+        unsigned digit = c - '0';
+        if (magnitude > (limit - digit) / 10) overflow = 1;
+        else magnitude = magnitude * 10 + digit;
+        in.pos++;
+    } while ((c = peekChar()) >= '0' && c <= '9');
+
+    long result;
+    if (overflow) result = negative ? LONG_MIN : LONG_MAX;
+    else result = negative ? (long)(0 - magnitude) : (long)magnitude;
+    *value = (int)result;
+    return 1;
+}
+
+int inputScanChar(char* c) {
+    int ch = skipSpace();
+    if (ch == EOF) return EOF;
+    in.pos++;
+    *c = (char)ch;
+    return 1;
+}
+
+int inputScanPair(int* value, int* base) {
+    if (!matchChar('(')) return peekChar() == EOF ? EOF : 0;
+    int status = inputScanInt(value);
+    if (status != 1) return status;
+    if (!matchChar(',')) return 1;
+    if (inputScanInt(base) != 1) return 1;
+    matchChar(')');
+    return 2;
+}
+
+// Function to compile a scan format into literal runs and variable reads
+ScanTemplate* compileScan(Arena* arena, SymbolTable* symbols, const char* format, ll* args) {
+    ScanTemplate* t = arenaCalloc(arena, sizeof(ScanTemplate));
+    int placeholders = 0;
+    for (const char* f = format + 1; *f && *f != '"'; f++) placeholders += *f == '@';
+    t->parts = arenaAlloc(arena, (placeholders + 1) * sizeof(ScanPart));
+
+    // the quotes are part of the format, matching starts after the opening one
+    const char* start = format + 1;
+    const char* f;
+    ll* arg = args;
+    for (f = start; *f && *f != '"'; f++) {
+        if (*f != '@') continue;
+        if (!arg) {
+            t->error = "Error: Too few arguments provided for placeholders in scan\n";
+            break;
+        }
+        if (arg->slot < 0) {
+            t->notice = formatArgumentError(arena, "Error: Variable %s not declared\n", arg->string);
+            break;
+        }
+        if (symbols->length[arg->slot]) {
+            t->error = formatArgumentError(arena, "Type Error: Cannot use array '%s' without an index\n", arg->string);
+            break;
+        }
+        t->parts[t->nparts++] = (ScanPart){start, (int)(f - start), arg->slot, symbols->is_char[arg->slot]};
+        start = f + 1;
+        arg = arg->next;
+    }
+    t->tail = start;
+    t->tailLength = (int)(f - start);
+    if (!t->error && arg) t->error = "Error: Too many arguments provided for placeholders in scan\n";
+    return t;
+}
+
+// Every literal character must be the next input character
+static void matchLiteral(const char* text, int length) {
+    for (int i = 0; i < length; i++) {
+        int c = inputChar();
+        if (c != (unsigned char)text[i]) {
+            fprintf(stderr, "Scan format mismatch! Expected '%c', but got '%c'.\n", text[i], c == EOF ? '\0' : c);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Function to execute a scan template
+void runScan(const ScanTemplate* t, int* ints, char* chars, unsigned char* assigned) {
+    for (int i = 0; i < t->nparts; i++) {
+        const ScanPart* part = &t->parts[i];
+        matchLiteral(part->text, part->length);
+        if (!part->is_char) ints[part->slot] = scanIntValue();
+        else if (chars) chars[part->slot] = scanCharValue();
+        else ints[part->slot] = scanCharValue();
+        assigned[part->slot] = 1;
+    }
+    matchLiteral(t->tail, t->tailLength);
+    if (t->notice) fputs(t->notice, stdout);
+    if (t->error) {
+        fputs(t->error, stderr);
+        exit(EXIT_FAILURE);
+    }
+}
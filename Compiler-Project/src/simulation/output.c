@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+static int interactiveInput;
+
+// Function to set up stdout before anything is written to it. Output to a terminal
+// stays line buffered, anything else is written in large blocks.
+void initOutput(void) {
+    if (!isatty(STDOUT_FILENO)) setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+    interactiveInput = isatty(STDIN_FILENO);
+}
+
+// Function to show pending output before a scan waits for the user
+void flushOutputForInput(void) {
+    if (interactiveInput) fflush(stdout);
+}
+
+// Function to format the diagnostic of a bad argument into the arena
+char* formatArgumentError(Arena* arena, const char* fmt, const char* name) {
+    int size = snprintf(NULL, 0, fmt, name) + 1;
+    char* text = arenaAlloc(arena, size);
+    snprintf(text, size, fmt, name);
+    return text;
+}
+
+// Function to split a print format into segments, argument errors are found here once
+PrintTemplate* compilePrint(Arena* arena, SymbolTable* symbols, const char* format, ll* args, int count) {
+    PrintTemplate* t = arenaCalloc(arena, sizeof(PrintTemplate));
+    int placeholders = 0;
+    for (const char* f = format; *f; f++) placeholders += *f == '@';
+    t->parts = arenaAlloc(arena, (placeholders + 1) * sizeof(PrintPart));
+
+    const char* start = format;
+    const char* f;
+    ll* arg = args;
+    int printed = 0;
+    for (f = format; *f; f++) {
+        if (*f != '@') continue;
+        if (!arg) {
+            t->error = "Error: Too few arguments provided for placeholders in print\n";
+            break;
+        }
+        if (arg->slot < 0) {
+            t->error = formatArgumentError(arena, "Error: Variable %s not declared\n", arg->string);
+            break;
+        }
+        if (symbols->length[arg->slot]) {
+            t->error = formatArgumentError(arena, "Type Error: Cannot use array '%s' without an index\n", arg->string);
+            break;
+        }
+        t->parts[t->nparts++] = (PrintPart){start, (int)(f - start), arg->slot, symbols->is_char[arg->slot]};
+        start = f + 1;
+        arg = arg->next;
+        printed++;
+    }
+    t->tail = start;
+    t->tailLength = (int)(f - start);
+    if (!t->error && printed < count) t->error = "Error: Too many arguments passed to print\n";
+    return t;
+}
+
+static void writeInt(FILE* out, int value) {
+    char digits[12];
+    char* p = digits + sizeof(digits);
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (value < 0) *--p = '-';
+    fwrite(p, 1, digits + sizeof(digits) - p, out);
+}
+
+// Function to execute a print template
+void runPrint(const PrintTemplate* t, const int* ints, const char* chars) {
+    writePrint(stdout, t, ints, chars);
+}
+
+void writePrint(FILE* out, const PrintTemplate* t, const int* ints, const char* chars) {
+    for (int i = 0; i < t->nparts; i++) {
+        const PrintPart* part = &t->parts[i];
+        if (part->length) fwrite(part->text, 1, part->length, out);
+        if (part->is_char) putc(chars ? chars[part->slot] : (char)ints[part->slot], out);
+        else writeInt(out, ints[part->slot]);
+    }
+    fwrite(t->tail, 1, t->tailLength, out);
+    if (t->error) {
+        fputs(t->error, stderr);
+        exit(EXIT_FAILURE);
+    }
+    putc('\n', out);
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "profile.h"
+#include "simulation.h"
+
+static Profile* running;    // profile of the program being run, reported if it exits early
+
+static void* checkedAlloc(void* ptr) {
+    if (!ptr) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+static long long nowNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Function to number the statements of a block and of the blocks nested in them
+static void numberStatements(Profile* profile, ASTNode* block, int parent) {
+    if (!block || block->type != NODE_STMTS) return;
+    for (int i = 0; i < block->data.statements.count; i++) {
+        ASTNode* stmt = block->data.statements.statements[i];
+        if (profile->count % 64 == 0)
+            profile->entries = checkedAlloc(realloc(profile->entries, (profile->count + 64) * sizeof(ProfileEntry)));
+        int id = profile->count++;
+        profile->entries[id] = (ProfileEntry){stmt, parent, -1, 0, 0, 0, 0};
+        stmt->profile = id;
+
+        ASTNode* body = NULL;
+        switch (stmt->type) {
+            case NODE_FOR:
+                body = stmt->data.for_loop_block.stmts;
+                break;
+            case NODE_WHILE:
+                body = stmt->data.if_while_block.stmts;
+                break;
+            case NODE_IF:
+                numberStatements(profile, stmt->data.if_while_block.stmts, id);
+                break;
+            case NODE_IF_ELSE:
+                numberStatements(profile, stmt->data.if_else_block.stmts, id);
+                numberStatements(profile, stmt->data.if_else_block.else_part, id);
+                break;
+            default:
+                break;
+        }
+        if (body) {
+            if (body->data.statements.count) profile->entries[id].body = profile->count;
+            numberStatements(profile, body, id);
+        }
+    }
+}
+
+// Function to create the profile of a program, path names the machine readable copy
+Profile* createProfile(ASTNode* root, const char* path) {
+    Profile* profile = checkedAlloc(calloc(1, sizeof(Profile)));
+    profile->path = path;
+    profile->current = -1;
+    if (root && root->type == NODE_PROG) numberStatements(profile, root->data.program.stmtblock, -1);
+    return profile;
+}
+
+void freeProfile(Profile* profile) {
+    if (!profile) return;
+    if (running == profile) running = NULL;
+    free(profile->entries);
+    free(profile);
+}
+
+void profileStatement(Profile* profile, ASTNode* stmt, Frame* frame) {
+    ProfileEntry* entry = &profile->entries[stmt->profile];
+    entry->count++;
+    profile->current = stmt->profile;
+    entry->started_ns = nowNanoseconds();
+    evaluateAST(stmt, frame);
+    long long elapsed = nowNanoseconds() - entry->started_ns;
+    entry->total_ns += elapsed;
+    if (entry->parent >= 0) profile->entries[entry->parent].nested_ns += elapsed;
+    profile->current = entry->parent;
+}
+
+// Function to name a statement in the report
+static void describeStatement(ASTNode* stmt, char* text, size_t size) {
+    switch (stmt->type) {
+        case NODE_ASSIGN: {
+            ASTNode* target = stmt->data.operator.left;
+            if (target->type == NODE_INDEX)
+                snprintf(text, size, "%s[] %s", target->data.index.array->data.var.identifier, operatorName(stmt->data.operator.op));
+            else
+                snprintf(text, size, "%s %s", target->data.var.identifier, operatorName(stmt->data.operator.op));
+            break;
+        }
+        case NODE_FOR:
+            snprintf(text, size, "for %s", stmt->data.for_loop_block.init->data.operator.left->data.var.identifier);
+            break;
+        case NODE_WHILE:
+            snprintf(text, size, "while");
+            break;
+        case NODE_IF:
+        case NODE_IF_ELSE:
+            snprintf(text, size, "if");
+            break;
+        case NODE_PRINT:
+            snprintf(text, size, "print");
+            break;
+        case NODE_SCAN:
+            snprintf(text, size, "scan");
+            break;
+        default:
+            snprintf(text, size, "statement");
+            break;
+    }
+}
+
+static long long selfTime(const ProfileEntry* entry) {
+    return entry->total_ns - entry->nested_ns;
+}
+
+static Profile* sortedProfile;
+
+// Hottest first, statements with the same self time keep source order
+static int compareEntries(const void* a, const void* b) {
+    const ProfileEntry* x = &sortedProfile->entries[*(const int*)a];
+    const ProfileEntry* y = &sortedProfile->entries[*(const int*)b];
+    long long dx = selfTime(x), dy = selfTime(y);
+    if (dx != dy) return dx < dy ? 1 : -1;
+    return *(const int*)a - *(const int*)b;
+}
+
+// Function to write every statement as one tab separated line, in source order
+static void writeProfile(Profile* profile) {
+    FILE* out = fopen(profile->path, "w");
+    if (!out) {
+        perror("Error opening profile file");
+        return;
+    }
+    fprintf(out, "line\tcolumn\tstatement\tcount\titerations\ttotal_ns\tself_ns\n");
+    for (int i = 0; i < profile->count; i++) {
+        ProfileEntry* entry = &profile->entries[i];
+        char text[64];
+        describeStatement(entry->node, text, sizeof(text));
+        fprintf(out, "%d\t%d\t%s\t%lld\t", entry->node->line, entry->node->column, text, entry->count);
+        if (entry->body >= 0) fprintf(out, "%lld", profile->entries[entry->body].count);
+        fprintf(out, "\t%lld\t%lld\n", entry->total_ns, selfTime(entry));
+    }
+    fclose(out);
+}
+
+static void reportAtExit(void) {
+    if (running) finishProfile(running, stderr);
+}
+
+// Function to mark the start of a profiled run
+void startProfile(Profile* profile) {
+    static int registered;
+    if (!registered) registered = atexit(reportAtExit) == 0;
+    running = profile;
+    profile->start_ns = nowNanoseconds();
+}
+
+void finishProfile(Profile* profile, FILE* out) {
+    if (running == profile) running = NULL;
+    long long now = nowNanoseconds();
+    long long elapsed = now - profile->start_ns;
+    // a run-time error left the current statement and the ones around it open
+    for (int id = profile->current; id >= 0; id = profile->entries[id].parent) {
+        ProfileEntry* entry = &profile->entries[id];
+        entry->total_ns += now - entry->started_ns;
+        if (entry->parent >= 0) profile->entries[entry->parent].nested_ns += now - entry->started_ns;
+    }
+    profile->current = -1;
+    int* order = checkedAlloc(malloc((profile->count + 1) * sizeof(int)));
+    int executed = 0;
+    for (int i = 0; i < profile->count; i++) {
+        if (profile->entries[i].count) order[executed++] = i;
+    }
+    sortedProfile = profile;
+    qsort(order, executed, sizeof(int), compareEntries);
+
+    fprintf(out, "\nProfile: %d of %d statements executed, %.3f ms\n", executed, profile->count, elapsed / 1e6);
+    fprintf(out, " %-9s | %-12s | %-12s | %-10s | %-10s | %-6s | %s\n", "line:col", "count", "iterations", "total ms", "self ms", "self %", "statement");
+    for (int k = 0; k < executed && k < PROFILE_REPORT_LINES; k++) {
+        ProfileEntry* entry = &profile->entries[order[k]];
+        char position[24], iterations[24], text[64];
+        snprintf(position, sizeof(position), "%d:%d", entry->node->line, entry->node->column);
+        if (entry->body >= 0) snprintf(iterations, sizeof(iterations), "%lld", profile->entries[entry->body].count);
+        else snprintf(iterations, sizeof(iterations), "-");
+        describeStatement(entry->node, text, sizeof(text));
+        fprintf(out, " %-9s | %-12lld | %-12s | %-10.3f | %-10.3f | %5.1f%% | %s\n", position, entry->count, iterations,
+                entry->total_ns / 1e6, selfTime(entry) / 1e6, elapsed ? 100.0 * selfTime(entry) / elapsed : 0.0, text);
+    }
+    if (executed > PROFILE_REPORT_LINES) fprintf(out, " ... %d more\n", executed - PROFILE_REPORT_LINES);
+    free(order);
+    if (profile->path) writeProfile(profile);
+}
@@ -1,107 +1,126 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "ast.h"
+#include "simulation.h"
+#include "output.h"
+#include "input.h"
+#include "profile.h"
+#include "parallel.h"
 
-// Structure to store a single Variable entry
-typedef struct Symbol {
-    char name[100];
-    int int_value;
-    char char_value;
-    int is_char; // 1 if char, 0 else
-    int assigned; // 1 if assigned, 0 else
-    struct Symbol* next;
-} Symbol;
-
-// Symbol Table
-Symbol* symbol_table = NULL;
-
-// Function to convert Integer constant to Decimal
-int convertToDecimal(int value, int base){
+// Function to convert Integer constant to Decimal, returns 0 and fills msg if the literal is invalid
+int tryConvertToDecimal(int value, int base, int* result, char* msg, size_t size){
     if(base != 2 && base != 8 && base != 10){
-        printf("Base encountered: %d, expected values: 2, 8, 10\n", base);
-        exit(EXIT_FAILURE);
+        snprintf(msg, size, "Base encountered: %d, expected values: 2, 8, 10\n", base);
+        return 0;
+    }
+    if(base == 10){
+        // every digit is valid, folded literals may also be negative
+        *result = value;
+        return 1;
     }
     int temp = value;
-    int result = 0;
+    int decimal = 0;
     int multiplier = 1;
     while(value > 0){
         int digit = value % 10;
         if(digit >= base){
-            printf("Expected digit < base %d, in the integer (%d, %d)\n", base, temp, base);
-            exit(EXIT_FAILURE);
+            snprintf(msg, size, "Expected digit < base %d, in the integer (%d, %d)\n", base, temp, base);
+            return 0;
         }
-        result += digit * multiplier;
+        decimal += digit * multiplier;
         multiplier *= base;
         value /= 10;
     }
+    *result = decimal;
+    return 1;
+}
+
+// Function to convert Integer constant to Decimal
+int convertToDecimal(int value, int base){
+    int result;
+    char msg[128];
+    if(!tryConvertToDecimal(value, base, &result, msg, sizeof(msg))){
+        printf("%s", msg);
+        exit(EXIT_FAILURE);
+    }
     return result;
 }
 
-// Lookup variables
-Symbol* lookupSymbol(const char* name){
-    Symbol* current = symbol_table;
-    while(current){
-        if (strcmp(current->name, name) == 0) return current;
-        current = current->next;
+// Utility to read a char value for scan
+char scanCharValue(){
+    char input;
+    if(inputScanChar(&input) != 2){
+        printf("Error: Invalid input for char\n");
+        exit(EXIT_FAILURE);
     }
-    return NULL;
+    return input;
 }
 
-// Utility to add/update variable in symbol table
-void updateSymbolTable(char* name, int is_char, int int_val, char char_val, int assigned) {
-    Symbol* current = symbol_table;
-    while (current){
-        if(strcmp(current->name, name) == 0){
-            if(is_char){
-                current->char_value = char_val;
-            }else{
-                current->int_value = int_val;
-            }
-            current->assigned = assigned;
-            return;
-        }
-        current = current->next;
+// Utility to read an (value, base) integer for scan
+int scanIntValue(){
+    int input = 0, base = 0;
+    if(inputScanPair(&input, &base) != 2){
+        printf("Error: Invalid input format for int. Expected (value, base)\n");
+        printf("%d %d ", input, base);
+        exit(EXIT_FAILURE);
     }
-    // New Variable
-    Symbol* new_symbol = (Symbol*)malloc(sizeof(Symbol));
-    strcpy(new_symbol->name, name);
-    new_symbol->int_value = int_val;
-    new_symbol->char_value = char_val;
-    new_symbol->is_char = is_char;
-    new_symbol->assigned = assigned;
-    new_symbol->next = symbol_table;
-    symbol_table = new_symbol;
+    return convertToDecimal(input, base);
 }
 
-// Utility to declare variable (without assigning)
-void declareSymbol(char* name, int is_char){
-    updateSymbolTable(name, is_char, 0, '\0', 0);
+// Function to report an array access outside of the array
+void reportIndexError(const char* name, int index, int length){
+    fprintf(stderr, "Error: Index %d out of bounds for array '%s' of size %d\n", index, name, length);
+    exit(EXIT_FAILURE);
 }
 
-// Utility to scan input
-void scanSymbol(Symbol* sym) {
-    if(sym->is_char){
-        char input;
-        if(scanf(" %c", &input) != 2){
-            printf("Error: Invalid input for char\n");
-            exit(EXIT_FAILURE);
-        }
-        sym->char_value = input;
-    }else{
-        int input, base;
-        if(scanf("(%d, %d)", &input, &base) != 2){
-            printf("Error: Invalid input format for int. Expected (value, base)\n");
-            printf("%d %d ", input, base);
+// Utility to reject an index on a variable that is not an array
+static void checkArray(SymbolTable* symbols, int slot){
+    if(!symbols->length[slot]){
+        fprintf(stderr, "Type Error: Variable '%s' is not an array\n", symbols->names[slot]);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void checkIndex(SymbolTable* symbols, int slot, int index){
+    if((unsigned)index >= (unsigned)symbols->length[slot])
+        reportIndexError(symbols->names[slot], index, symbols->length[slot]);
+}
+
+// Function to apply an assignment operator to an integer location
+static void applyAssignment(Operator op, int* value, int val){
+    switch(op){
+        case OPR_ASSIGN:
+            *value = val;
+            break;
+        case OPR_ADD_ASSIGN:
+            *value += val;
+            break;
+        case OPR_SUB_ASSIGN:
+            *value -= val;
+            break;
+        case OPR_MUL_ASSIGN:
+            *value *= val;
+            break;
+        case OPR_MOD_ASSIGN:
+            *value %= val;
+            break;
+        case OPR_DIV_ASSIGN:
+            if(val == 0){
+                fprintf(stderr, "Error: Division by zero\n");
+                exit(EXIT_FAILURE);
+            }
+            *value /= val;
+            break;
+        default:
+            fprintf(stderr, "Error: Unknown assignment operator %s\n", operatorName(op));
             exit(EXIT_FAILURE);
-        }
-        sym->int_value = convertToDecimal(input, base);
     }
-    sym->assigned = 1;
 }
 
 // Function to evaluate expressions recursively
-int evaluateExpression(ASTNode* node){
+int evaluateExpression(ASTNode* node, Frame* frame){
     if(!node) return 0;
 
     switch(node->type){
@@ -109,26 +128,50 @@ int evaluateExpression(ASTNode* node){
             return convertToDecimal(node->data.integer.value, node->data.integer.base);
 
         case NODE_VAR:
-            Symbol* sym = lookupSymbol(node->data.identifier);
-            if(!sym){
-                fprintf(stderr, "Variable %s not declared!\n", node->data.identifier);
+            int slot = node->data.var.slot;
+            if(slot < 0){
+                fprintf(stderr, "Variable %s not declared!\n", node->data.var.identifier);
+                exit(EXIT_FAILURE);
+            }
+            if(frame->symbols->length[slot]){
+                fprintf(stderr, "Type Error: Cannot use array '%s' without an index\n", node->data.var.identifier);
+                exit(EXIT_FAILURE);
+            }
+            if(frame->symbols->is_char[slot]){
+                fprintf(stderr, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", frame->symbols->names[slot]);
+                exit(EXIT_FAILURE);
+            }
+            return frame->int_value[slot];
+
+        case NODE_INDEX:{
+            ASTNode* array = node->data.index.array;
+            int slot = array->data.var.slot;
+            if(slot < 0){
+                fprintf(stderr, "Variable %s not declared!\n", array->data.var.identifier);
                 exit(EXIT_FAILURE);
             }
-            if(sym->is_char){
-                fprintf(stderr, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", sym->name);
+            checkArray(frame->symbols, slot);
+            if(frame->symbols->is_char[slot]){
+                fprintf(stderr, "Type Error: Cannot use char variable '%s' in arithmetic expression!\n", frame->symbols->names[slot]);
                 exit(EXIT_FAILURE);
             }
-            return sym->int_value;
+            int index = evaluateExpression(node->data.index.index, frame);
+            checkIndex(frame->symbols, slot, index);
+            return frame->int_elements[frame->symbols->offset[slot] + index];
+        }
 
         case NODE_OP:
-            int left = evaluateExpression(node->data.operator.left);
-            int right = evaluateExpression(node->data.operator.right);
-            if(strcmp(node->data.operator.operator, "+") == 0) return left + right;
-            if(strcmp(node->data.operator.operator, "-") == 0) return left - right;
-            if(strcmp(node->data.operator.operator, "*") == 0) return left * right;
-            if(strcmp(node->data.operator.operator, "/") == 0) return left / right;
-            if(strcmp(node->data.operator.operator, "%") == 0) return left % right;
-            fprintf(stderr, "Unknown operator: %s\n", node->data.operator.operator);
+            int left = evaluateExpression(node->data.operator.left, frame);
+            int right = evaluateExpression(node->data.operator.right, frame);
+            switch(node->data.operator.op){
+                case OPR_ADD: return left + right;
+                case OPR_SUB: return left - right;
+                case OPR_MUL: return left * right;
+                case OPR_DIV: return left / right;
+                case OPR_MOD: return left % right;
+                default: break;
+            }
+            fprintf(stderr, "Unknown operator: %s\n", operatorName(node->data.operator.op));
             exit(EXIT_FAILURE);
 
         default:
@@ -138,19 +181,22 @@ int evaluateExpression(ASTNode* node){
 }
 
 // Function to evaluate conditions
-int evaluateCondition(ASTNode* node){
+int evaluateCondition(ASTNode* node, Frame* frame){
     if(!node) return 0;
 
     if(node->type == NODE_RELOP){
-        int left = evaluateExpression(node->data.operator.left);
-        int right = evaluateExpression(node->data.operator.right);
-        if(strcmp(node->data.operator.operator, "<") == 0) return left < right;
-        if(strcmp(node->data.operator.operator, ">") == 0) return left > right;
-        if(strcmp(node->data.operator.operator, "<=") == 0) return left <= right;
-        if(strcmp(node->data.operator.operator, ">=") == 0) return left >= right;
-        if(strcmp(node->data.operator.operator, "=") == 0) return left == right;
-        if(strcmp(node->data.operator.operator, "<>") == 0) return left != right;
-        fprintf(stderr, "Unknown relational operator: %s\n", node->data.operator.operator);
+        int left = evaluateExpression(node->data.operator.left, frame);
+        int right = evaluateExpression(node->data.operator.right, frame);
+        switch(node->data.operator.op){
+            case OPR_LT: return left < right;
+            case OPR_GT: return left > right;
+            case OPR_LE: return left <= right;
+            case OPR_GE: return left >= right;
+            case OPR_EQ: return left == right;
+            case OPR_NE: return left != right;
+            default: break;
+        }
+        fprintf(stderr, "Unknown relational operator: %s\n", operatorName(node->data.operator.op));
         exit(EXIT_FAILURE);
     }
 
@@ -158,223 +204,179 @@ int evaluateCondition(ASTNode* node){
     exit(EXIT_FAILURE);
 }
 
+// Function to assign to an array element: the index and the value are evaluated
+// before the element is checked against the bounds of the array
+static void assignElement(ASTNode* node, Frame* frame){
+    ASTNode* target = node->data.operator.left;
+    ASTNode* right = node->data.operator.right;
+    char* var_name = target->data.index.array->data.var.identifier;
+    int slot = target->data.index.array->data.var.slot;
+    if(slot < 0){
+        printf("Error: Variable %s not declared\n", var_name);
+        return;
+    }
+    SymbolTable* symbols = frame->symbols;
+    checkArray(symbols, slot);
+    int is_char = symbols->is_char[slot];
+    if(right->type == NODE_CHAR && !is_char){
+        fprintf(stderr, "Type Error: Cannot assign char to int variable '%s'\n", var_name);
+        exit(EXIT_FAILURE);
+    }
+    if(right->type != NODE_CHAR && is_char){
+        fprintf(stderr, "Type Error: Cannot assign int to char variable '%s'\n", var_name);
+        exit(EXIT_FAILURE);
+    }
+    int index = evaluateExpression(target->data.index.index, frame);
+    if(right->type == NODE_CHAR){
+        checkIndex(symbols, slot, index);
+        frame->char_elements[symbols->offset[slot] + index] = right->data.value;
+        return;
+    }
+    int val = evaluateExpression(right, frame);
+    checkIndex(symbols, slot, index);
+    applyAssignment(node->data.operator.op, &frame->int_elements[symbols->offset[slot] + index], val);
+}
+
+// Function to run a counted for loop with a trip count computed on entry, returns 0
+// without running it if the counter would leave the int range (the general loop
+// then runs instead)
+static int runCountedLoop(ASTNode* node, Frame* frame, int* counter){
+    long long start = *counter;
+    long long limit = evaluateExpression(node->data.for_loop_block.limit, frame);
+    int step = node->data.for_loop_block.step;
+    int inc = node->data.for_loop_block.update->type == NODE_INC;
+    long long distance = inc ? limit - start : start - limit;
+    long long trips = distance > 0 ? (distance + step - 1) / step : 0;
+    long long last = inc ? start + trips * step : start - trips * step;
+    if(last < INT_MIN || last > INT_MAX) return 0;
+
+    ASTNode* body = node->data.for_loop_block.stmts;
+    int value = (int)start;
+    if(!inc) step = -step;
+    if(node->data.for_loop_block.parallel && runParallelLoop(node, frame, value, step, trips)) return 1;
+    for(; trips > 0; trips--){
+        evaluateAST(body, frame);
+        value += step;
+        *counter = value;
+    }
+    return 1;
+}
+
 // Recursive function to evaluate the AST
-void evaluateAST(ASTNode* node){
+void evaluateAST(ASTNode* node, Frame* frame){
     if(!node) return;
 
     switch(node->type){
         case NODE_PROG:{
-            evaluateAST(node->data.program.varDecl);
-            evaluateAST(node->data.program.stmtblock);
+            evaluateAST(node->data.program.varDecl, frame);
+            evaluateAST(node->data.program.stmtblock, frame);
             break;
         }
         case NODE_VARDEC:{
             ASTNode* temp = node;
             while(temp){
-                declareSymbol(temp->data.var_list.variable->data.identifier, strcmp(temp->data.var_list.type, "char") == 0);
+                resetSlot(frame, temp->data.var_list.variable->data.var.slot);
                 temp = temp->data.var_list.next;
             }
             break;
         }
         case NODE_ASSIGN:{ 
-            char* var_name = node->data.operator.left->data.identifier;
-            Symbol* sym = lookupSymbol(var_name);
-            if(!sym){
+            if(node->data.operator.left->type == NODE_INDEX){
+                assignElement(node, frame);
+                break;
+            }
+            char* var_name = node->data.operator.left->data.var.identifier;
+            int slot = node->data.operator.left->data.var.slot;
+            if(slot < 0){
                 printf("Error: Variable %s not declared\n", var_name);
                 break;
             }
+            if(frame->symbols->length[slot]){
+                fprintf(stderr, "Type Error: Cannot use array '%s' without an index\n", var_name);
+                exit(EXIT_FAILURE);
+            }
+            int is_char = frame->symbols->is_char[slot];
             if (node->data.operator.right->type == NODE_CHAR) {
-                if (!sym->is_char) {
+                if (!is_char) {
                     fprintf(stderr, "Type Error: Cannot assign char to int variable '%s'\n", var_name);
                     exit(EXIT_FAILURE);
                 }
             } else {
-                if (sym->is_char) {
+                if (is_char) {
                     fprintf(stderr, "Type Error: Cannot assign int to char variable '%s'\n", var_name);
                     exit(EXIT_FAILURE);
                 }
             }    
             if(node->data.operator.right->type == NODE_CHAR){
-                updateSymbolTable(var_name, 1, 0, node->data.operator.right->data.value, 1);
+                frame->char_value[slot] = node->data.operator.right->data.value;
+                frame->assigned[slot] = 1;
             }else{
-                int val = evaluateExpression(node->data.operator.right);
-        
-                if(strcmp(node->data.operator.operator, ":=") == 0){
-                    updateSymbolTable(var_name, 0, val, '\0', 1);
-                }
-                else if(strcmp(node->data.operator.operator, "+=") == 0){
-                    sym->int_value += val;
-                }
-                else if(strcmp(node->data.operator.operator, "-=") == 0){
-                    sym->int_value -= val;
-                }
-                else if(strcmp(node->data.operator.operator, "*=") == 0){
-                    sym->int_value *= val;
-                }
-                else if(strcmp(node->data.operator.operator, "%=") == 0){
-                    sym->int_value %= val;
-                }
-                else if(strcmp(node->data.operator.operator, "/=") == 0){
-                    if(val == 0){
-                        fprintf(stderr, "Error: Division by zero\n");
-                        exit(EXIT_FAILURE);
-                    }
-                    sym->int_value /= val;
-                }
-                else{
-                    fprintf(stderr, "Error: Unknown assignment operator %s\n", node->data.operator.operator);
-                    exit(EXIT_FAILURE);
-                }
+                int val = evaluateExpression(node->data.operator.right, frame);
+                applyAssignment(node->data.operator.op, &frame->int_value[slot], val);
+                if(node->data.operator.op == OPR_ASSIGN) frame->assigned[slot] = 1;
             }
             break;
         }
         case NODE_STMTS:{
-            for(int i = 0; i < node->data.statements.count; i++)
-                evaluateAST(node->data.statements.statements[i]);
+            for(int i = 0; i < node->data.statements.count; i++){
+                if(frame->profile) profileStatement(frame->profile, node->data.statements.statements[i], frame);
+                else evaluateAST(node->data.statements.statements[i], frame);
+            }
             break;
         }
         case NODE_IF:{
-            if(evaluateCondition(node->data.if_while_block.condition))
-                evaluateAST(node->data.if_while_block.stmts);
+            if(evaluateCondition(node->data.if_while_block.condition, frame))
+                evaluateAST(node->data.if_while_block.stmts, frame);
             break;
         }
         case NODE_IF_ELSE:{
-            if(evaluateCondition(node->data.if_else_block.condition))
-                evaluateAST(node->data.if_else_block.stmts);
+            if(evaluateCondition(node->data.if_else_block.condition, frame))
+                evaluateAST(node->data.if_else_block.stmts, frame);
             else
-                evaluateAST(node->data.if_else_block.else_part);
+                evaluateAST(node->data.if_else_block.else_part, frame);
             break;
         }
         case NODE_FOR:{
-            evaluateAST(node->data.for_loop_block.init);
-            char* var_name = node->data.for_loop_block.init->data.operator.left->data.identifier;
-            Symbol* sym = lookupSymbol(var_name);
-            if(!sym){
+            evaluateAST(node->data.for_loop_block.init, frame);
+            char* var_name = node->data.for_loop_block.init->data.operator.left->data.var.identifier;
+            int slot = node->data.for_loop_block.init->data.operator.left->data.var.slot;
+            if(slot < 0){
                 printf("Error: Variable %s not declared\n", var_name);
                 break;
             }
+            int* counter = &frame->int_value[slot];
             ASTNode* n = node->data.for_loop_block.update->data.operator.left;
+            if(node->data.for_loop_block.counted && runCountedLoop(node, frame, counter)) break;
 
             if(node->data.for_loop_block.update->type == NODE_INC){
-                while(sym->int_value < evaluateExpression(node->data.for_loop_block.limit)){      
-                    evaluateAST(node->data.for_loop_block.stmts);
-                    sym->int_value += convertToDecimal(n->data.integer.value, n->data.integer.base);
+                while(*counter < evaluateExpression(node->data.for_loop_block.limit, frame)){      
+                    evaluateAST(node->data.for_loop_block.stmts, frame);
+                    *counter += evaluateExpression(n, frame);
                 }
                 break;
             }
             else if(node->data.for_loop_block.update->type == NODE_DEC){
-                while(sym->int_value > evaluateExpression(node->data.for_loop_block.limit)){      
-                    evaluateAST(node->data.for_loop_block.stmts);
-                    sym->int_value -= convertToDecimal(n->data.integer.value, n->data.integer.base);
+                while(*counter > evaluateExpression(node->data.for_loop_block.limit, frame)){      
+                    evaluateAST(node->data.for_loop_block.stmts, frame);
+                    *counter -= evaluateExpression(n, frame);
                 }
                 break;
             }
         } 
         case NODE_WHILE:{
-            while(evaluateCondition(node->data.if_while_block.condition))
-                evaluateAST(node->data.if_while_block.stmts);
+            while(evaluateCondition(node->data.if_while_block.condition, frame))
+                evaluateAST(node->data.if_while_block.stmts, frame);
             break;
         }
         case NODE_PRINT:{
-            const char* format = node->data.print_scan_stmt.string;
-            ll* arg_node = node->data.print_scan_stmt.args;
-            int arg_idx = 0;
-            
-            for (int i = 0; format[i] != '\0'; i++) {
-                if (format[i] == '@') {
-                    if (!arg_node) {
-                        fprintf(stderr, "Error: Too few arguments provided for placeholders in print\n");
-                        exit(EXIT_FAILURE);
-                    }
-            
-                    Symbol* sym = lookupSymbol(arg_node->string);
-                    if (!sym) {
-                        fprintf(stderr, "Error: Variable %s not declared\n", arg_node->string);
-                        exit(EXIT_FAILURE);
-                    }
-            
-                    if (sym->is_char) {
-                        printf("%c", sym->char_value);
-                    } else {
-                        printf("%d", sym->int_value);
-                    }
-            
-                    arg_node = arg_node->next;
-                    arg_idx++;
-                } else {
-                    putchar(format[i]);
-                }
-            }
-            
-            if (arg_idx < node->data.print_scan_stmt.count) {
-                fprintf(stderr, "Error: Too many arguments passed to print\n");
-                exit(EXIT_FAILURE);
-            }
-            
-            printf("\n");
+            writePrint(frame->output, node->data.print_scan_stmt.print, frame->int_value, frame->char_value);
             break;
         }
         case NODE_SCAN:{
-            const char* format = node->data.print_scan_stmt.string;
-            ll* arg_node = node->data.print_scan_stmt.args;
-            int arg_idx = 0;
-            for (int i = 1; format[i] != '"'; i++) {
-                if (format[i] == '@') {
-                    if (!arg_node) {
-                        fprintf(stderr, "Error: Too few arguments provided for placeholders in scan\n");
-                        exit(EXIT_FAILURE);
-                    }
-                    Symbol* sym = lookupSymbol(arg_node->string);
-                    if (!sym) {
-                        printf("Error: Variable %s not declared\n", arg_node->string);
-                        break;
-                    }
-                        
-                    scanSymbol(sym);
-                    arg_node = arg_node->next;
-                    arg_idx++;
-                }else{
-                    char c;
-                    scanf("%c", &c);
-                    if(c != format[i]){
-                        fprintf(stderr, "Scan format mismatch! Expected '%c', but got '%c'.\n", format[i], c);
-                        exit(EXIT_FAILURE);
-                    }
-                }
-            }
-
-            if (arg_node != NULL) {
-                fprintf(stderr, "Error: Too many arguments provided for placeholders in scan\n");
-                exit(EXIT_FAILURE);
-            }
+            runScan(node->data.print_scan_stmt.scan, frame->int_value, frame->char_value, frame->assigned);
             break;
         }
         default:
             break;
     }
 }
-
-// Function to print the symbol table
-void printSymbolTable(){
-    printf("\nSymbol Table:\n");
-    printf("-------------------------------------\n");
-    printf(" %-10s | %-6s | %-10s \n", "Name", "Type", "Value");
-    printf("-------------------------------------\n");
-
-    Symbol* current = symbol_table;
-    while(current){
-        if(current->is_char){
-            if(current->assigned)
-                printf(" %-10s | %-6s | '%c'      \n", current->name, "char", current->char_value);
-            else
-                printf(" %-10s | %-6s | (unassigned) \n", current->name, "char");
-        }else{
-            if(current->assigned)
-                printf(" %-10s | %-6s | (%d, 10) \n", current->name, "int", current->int_value);
-            else
-                printf(" %-10s | %-6s | (unassigned) \n", current->name, "int");
-        }
-        current = current->next;
-    }
-    printf("-------------------------------------\n");
-}
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ast.h"
+#include "symtab.h"
+#include "output.h"
+#include "input.h"
+
+static void* checkedAlloc(void* ptr) {
+    if (!ptr) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+// Function to create an empty symbol table for a unit with nnames interned names
+SymbolTable* createSymbolTable(int nnames) {
+    SymbolTable* table = checkedAlloc(calloc(1, sizeof(SymbolTable)));
+    table->slotOf = checkedAlloc(calloc(nnames + 1, sizeof(int)));
+    table->nnames = nnames;
+    return table;
+}
+
+// Lookup variables by interned name, returns the slot or -1
+int lookupSymbol(SymbolTable* table, int name) {
+    if (name < 0 || name >= table->nnames) return -1;
+    return table->slotOf[name] - 1;
+}
+
+// Utility to declare a variable or an array of length elements, a redeclaration keeps
+// the slot and type of the first one
+int declareSymbol(SymbolTable* table, int name, char* text, int is_char, int length) {
+    int slot = lookupSymbol(table, name);
+    if (slot != -1) return slot;
+
+    if (table->count == table->cap) {
+        table->cap = table->cap ? table->cap * 2 : 16;
+        table->names = checkedAlloc(realloc(table->names, table->cap * sizeof(char*)));
+        table->is_char = checkedAlloc(realloc(table->is_char, table->cap));
+        table->length = checkedAlloc(realloc(table->length, table->cap * sizeof(int)));
+        table->offset = checkedAlloc(realloc(table->offset, table->cap * sizeof(int)));
+    }
+    if (length > INT_MAX - table->nelements) {
+        fprintf(stderr, "Error: Too many array elements declared\n");
+        exit(EXIT_FAILURE);
+    }
+    slot = table->count++;
+    table->names[slot] = text;
+    table->is_char[slot] = is_char;
+    table->length[slot] = length;
+    table->offset[slot] = table->nelements;
+    table->nelements += length;
+    table->slotOf[name] = slot + 1;
+    return slot;
+}
+
+// Function to free the symbol table (names are owned by the unit's interner)
+void freeSymbolTable(SymbolTable* table) {
+    if (!table) return;
+    free(table->names);
+    free(table->is_char);
+    free(table->length);
+    free(table->offset);
+    free(table->slotOf);
+    free(table);
+}
+
+// Function to assign slots to all variable uses below a node
+static void resolveNode(Arena* arena, SymbolTable* table, ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case NODE_VAR:
+            node->data.var.slot = lookupSymbol(table, node->data.var.name);
+            break;
+
+        case NODE_INDEX:
+            resolveNode(arena, table, node->data.index.array);
+            resolveNode(arena, table, node->data.index.index);
+            break;
+
+        case NODE_STMTS:
+            for (int i = 0; i < node->data.statements.count; i++)
+                resolveNode(arena, table, node->data.statements.statements[i]);
+            break;
+
+        case NODE_ASSIGN:
+        case NODE_INC:
+        case NODE_DEC:
+        case NODE_OP:
+        case NODE_RELOP:
+            resolveNode(arena, table, node->data.operator.left);
+            resolveNode(arena, table, node->data.operator.right);
+            break;
+
+        case NODE_FOR:
+            resolveNode(arena, table, node->data.for_loop_block.init);
+            resolveNode(arena, table, node->data.for_loop_block.limit);
+            resolveNode(arena, table, node->data.for_loop_block.update);
+            resolveNode(arena, table, node->data.for_loop_block.stmts);
+            break;
+
+        case NODE_WHILE:
+        case NODE_IF:
+            resolveNode(arena, table, node->data.if_while_block.condition);
+            resolveNode(arena, table, node->data.if_while_block.stmts);
+            break;
+
+        case NODE_IF_ELSE:
+            resolveNode(arena, table, node->data.if_else_block.condition);
+            resolveNode(arena, table, node->data.if_else_block.stmts);
+            resolveNode(arena, table, node->data.if_else_block.else_part);
+            break;
+
+        case NODE_PRINT:
+        case NODE_SCAN:
+            for (ll* arg = node->data.print_scan_stmt.args; arg; arg = arg->next)
+                arg->slot = lookupSymbol(table, arg->name);
+            if (node->type == NODE_PRINT)
+                node->data.print_scan_stmt.print = compilePrint(arena, table, node->data.print_scan_stmt.string,
+                                                                node->data.print_scan_stmt.args, node->data.print_scan_stmt.count);
+            else
+                node->data.print_scan_stmt.scan = compileScan(arena, table, node->data.print_scan_stmt.string,
+                                                              node->data.print_scan_stmt.args);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Resolution pass: declares the VarDecl block, maps every variable use to its slot
+// and compiles the print and scan statements
+SymbolTable* resolveProgram(Arena* arena, const Interner* names, ASTNode* root) {
+    SymbolTable* table = createSymbolTable(names->count);
+    if (!root || root->type != NODE_PROG) return table;
+
+    for (ASTNode* decl = root->data.program.varDecl; decl; decl = decl->data.var_list.next) {
+        ASTNode* var = decl->data.var_list.variable;
+        var->data.var.slot = declareSymbol(table, var->data.var.name, var->data.var.identifier,
+                                           strcmp(decl->data.var_list.type, "char") == 0, var->data.var.length);
+    }
+    resolveNode(arena, table, root->data.program.stmtblock);
+    return table;
+}
+
+// Function to create a zeroed frame for one execution
+Frame* createFrame(SymbolTable* table) {
+    Frame* frame = checkedAlloc(malloc(sizeof(Frame)));
+    int n = table->count + 1;
+    frame->symbols = table;
+    frame->int_value = checkedAlloc(calloc(n, sizeof(int)));
+    frame->char_value = checkedAlloc(calloc(n, 1));
+    frame->assigned = checkedAlloc(calloc(n, 1));
+    frame->int_elements = checkedAlloc(calloc(table->nelements + 1, sizeof(int)));
+    frame->char_elements = checkedAlloc(calloc(table->nelements + 1, 1));
+    frame->profile = NULL;
+    frame->output = stdout;
+    frame->sequential = 0;
+    return frame;
+}
+
+// Utility to reset a variable to its declared (unassigned) state
+void resetSlot(Frame* frame, int slot) {
+    frame->int_value[slot] = 0;
+    frame->char_value[slot] = '\0';
+    frame->assigned[slot] = 0;
+    int length = frame->symbols->length[slot];
+    if (length) {
+        memset(frame->int_elements + frame->symbols->offset[slot], 0, length * sizeof(int));
+        memset(frame->char_elements + frame->symbols->offset[slot], 0, length);
+    }
+}
+
+void freeFrame(Frame* frame) {
+    if (!frame) return;
+    free(frame->int_value);
+    free(frame->char_value);
+    free(frame->assigned);
+    free(frame->int_elements);
+    free(frame->char_elements);
+    free(frame);
+}
+
+// Function to print the row of an array, long arrays show their first elements
+static void printArrayRow(Frame* frame, int slot) {
+    SymbolTable* table = frame->symbols;
+    int length = table->length[slot];
+    int shown = length < SYMBOL_TABLE_ELEMENTS ? length : SYMBOL_TABLE_ELEMENTS;
+    char type[24];
+    snprintf(type, sizeof(type), "%s[%d]", table->is_char[slot] ? "char" : "int", length);
+    printf(" %-10s | %-6s | [", table->names[slot], type);
+    for (int i = 0; i < shown; i++) {
+        int at = table->offset[slot] + i;
+        if (i) printf(", ");
+        if (!table->is_char[slot]) printf("%d", frame->int_elements[at]);
+        else if (frame->char_elements[at]) printf("'%c'", frame->char_elements[at]);
+        else printf("'\\0'");
+    }
+    printf("%s] \n", shown < length ? ", ..." : "");
+}
+
+// Function to print the symbol table, most recently declared first
+void printSymbolTable(Frame* frame) {
+    SymbolTable* table = frame->symbols;
+    printf("\nSymbol Table:\n");
+    printf("-------------------------------------\n");
+    printf(" %-10s | %-6s | %-10s \n", "Name", "Type", "Value");
+    printf("-------------------------------------\n");
+
+    for (int slot = table->count - 1; slot >= 0; slot--) {
+        const char* name = table->names[slot];
+        if (table->length[slot]) {
+            printArrayRow(frame, slot);
+        } else if (table->is_char[slot]) {
+            if (frame->assigned[slot])
+                printf(" %-10s | %-6s | '%c'      \n", name, "char", frame->char_value[slot]);
+            else
+                printf(" %-10s | %-6s | (unassigned) \n", name, "char");
+        } else {
+            if (frame->assigned[slot])
+                printf(" %-10s | %-6s | (%d, 10) \n", name, "int", frame->int_value[slot]);
+            else
+                printf(" %-10s | %-6s | (unassigned) \n", name, "int");
+        }
+    }
+    printf("-------------------------------------\n");
+}
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "alloc.h"
+#include "parallel.h"
+#include "simulation.h"
+
+// Worker pool of the engines. A split loop is one job: its iterations are cut into
+// chunks that the threads take in order under the pool lock. The engine runs each
+// chunk on the state of the thread that took it, so the scalars of different
+// threads never mix. A chunk prints into its own buffer, and the buffers are
+// written to stdout in chunk order as soon as all earlier ones are.
+
+typedef struct {
+    ChunkRunner run;
+    void* context;
+    long long trips;
+    int nchunks;
+    int next;               // next chunk to take
+    int emitted;            // chunks whose output is on stdout
+    char** text;            // output of each chunk
+    size_t* length;
+    unsigned char* done;
+    int lastThread;         // thread that ran the last chunk
+} Job;
+
+static struct {
+    pthread_t* threads;
+    int started;            // helper threads, the calling thread works too
+    pthread_mutex_t lock;
+    pthread_cond_t wake, done;
+    Job* job;
+    long generation;        // jobs handed out so far
+    int busy;               // helpers still working on the current job
+} pool = {NULL, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0};
+
+static int workerThreads = 1;
+
+void setWorkerThreads(int threads) {
+    workerThreads = threads > 0 ? threads : 1;
+}
+
+// Function to run chunks of a job as thread t until none is left
+static void runChunks(Job* job, int t) {
+    for (;;) {
+        pthread_mutex_lock(&pool.lock);
+        int c = job->next++;
+        pthread_mutex_unlock(&pool.lock);
+        if (c >= job->nchunks) break;
+
+        FILE* out = open_memstream(&job->text[c], &job->length[c]);
+        if (!out) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        job->run(job->context, t, job->trips * c / job->nchunks, job->trips * (c + 1) / job->nchunks, out);
+        fclose(out);
+
+        pthread_mutex_lock(&pool.lock);
+        job->done[c] = 1;
+        if (c == job->nchunks - 1) job->lastThread = t;
+        while (job->emitted < job->nchunks && job->done[job->emitted]) {
+            int e = job->emitted++;
+            fwrite(job->text[e], 1, job->length[e], stdout);
+            free(job->text[e]);
+        }
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+static void* loopWorker(void* arg) {
+    int t = (int)(intptr_t)arg;
+    long seen = 0;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.generation == seen) pthread_cond_wait(&pool.wake, &pool.lock);
+        seen = pool.generation;
+        Job* job = pool.job;
+        pthread_mutex_unlock(&pool.lock);
+        runChunks(job, t);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.busy == 0) pthread_cond_signal(&pool.done);
+    }
+    return NULL;
+}
+
+// Function to start the helper threads once, before the first job
+static void startPool(void) {
+    pool.threads = allocArray(workerThreads, sizeof(pthread_t));
+    while (pool.started < workerThreads - 1 &&
+           pthread_create(&pool.threads[pool.started], NULL, loopWorker, (void*)(intptr_t)(pool.started + 1)) == 0)
+        pool.started++;
+}
+
+int splitThreads(ParallelLoop* loop, int start, int step, long long trips) {
+    if (workerThreads < 2 || trips < 2 || trips * loop->work < PARALLEL_MIN_WORK) return 0;
+    long long last = start + (trips - 1) * step;
+    if ((start < last ? start : last) < loop->low || (start > last ? start : last) > loop->high) return 0;
+    if (!pool.threads) startPool();
+    return pool.started + 1;
+}
+
+int runSplitLoop(long long trips, int threads, ChunkRunner run, void* context) {
+    Job job = {0};
+    job.run = run;
+    job.context = context;
+    job.trips = trips;
+    job.nchunks = trips < (long long)threads * PARALLEL_CHUNKS ? (int)trips : threads * PARALLEL_CHUNKS;
+    job.text = allocArray(job.nchunks, sizeof(char*));
+    job.length = allocArray(job.nchunks, sizeof(size_t));
+    job.done = allocArray(job.nchunks, 1);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.job = &job;
+    pool.busy = pool.started;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    runChunks(&job, 0);
+    pthread_mutex_lock(&pool.lock);
+    while (pool.busy) pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    free(job.text);
+    free(job.length);
+    free(job.done);
+    return job.lastThread;
+}
+
+int combinePartial(ParallelKind kind, int total, int part) {
+    if (kind == PARALLEL_PRODUCT) return (int)((unsigned)total * (unsigned)part);
+    return (int)((unsigned)total + (unsigned)part);
+}
+
+// A loop of the AST walker being split: each thread has a copy of the frame
+typedef struct {
+    ASTNode* body;
+    int counter;
+    int start, step;
+    Frame** frames;
+} TreeLoop;
+
+static void runTreeChunk(void* context, int t, long long first, long long end, FILE* out) {
+    TreeLoop* loop = context;
+    Frame* frame = loop->frames[t];
+    frame->output = out;
+    int* counter = &frame->int_value[loop->counter];
+    for (long long i = first; i < end; i++) {
+        *counter = (int)(loop->start + i * loop->step);
+        evaluateAST(loop->body, frame);
+    }
+}
+
+// Function to copy the scalars of a frame for one thread; reductions start from
+// the identity of their operator
+static Frame* workerFrame(Frame* frame, ParallelLoop* loop) {
+    int n = frame->symbols->count + 1;
+    Frame* copy = allocArray(1, sizeof(Frame));
+    *copy = *frame;
+    copy->int_value = allocArray(n, sizeof(int));
+    copy->char_value = allocArray(n, 1);
+    copy->assigned = allocArray(n, 1);
+    memcpy(copy->int_value, frame->int_value, n * sizeof(int));
+    memcpy(copy->char_value, frame->char_value, n);
+    memcpy(copy->assigned, frame->assigned, n);
+    copy->sequential = 1;
+    for (int i = 0; i < loop->nslots; i++) {
+        if (loop->kinds[i] == PARALLEL_SUM) copy->int_value[loop->slots[i]] = 0;
+        if (loop->kinds[i] == PARALLEL_PRODUCT) copy->int_value[loop->slots[i]] = 1;
+    }
+    return copy;
+}
+
+int runParallelLoop(ASTNode* node, Frame* frame, int start, int step, long long trips) {
+    ParallelLoop* parallel = node->data.for_loop_block.parallel;
+    if (frame->sequential || frame->profile) return 0;
+    int threads = splitThreads(parallel, start, step, trips);
+    if (!threads) return 0;
+
+    TreeLoop loop;
+    loop.body = node->data.for_loop_block.stmts;
+    loop.counter = node->data.for_loop_block.init->data.operator.left->data.var.slot;
+    loop.start = start;
+    loop.step = step;
+    loop.frames = allocArray(threads, sizeof(Frame*));
+    for (int t = 0; t < threads; t++) loop.frames[t] = workerFrame(frame, parallel);
+    int lastThread = runSplitLoop(trips, threads, runTreeChunk, &loop);
+
+    // scalars end as after the last iteration, reductions combine the partial
+    // results in thread order
+    Frame* lastFrame = loop.frames[lastThread];
+    for (int i = 0; i < parallel->nslots; i++) {
+        int slot = parallel->slots[i];
+        if (parallel->kinds[i] != PARALLEL_PRIVATE) {
+            for (int t = 0; t < threads; t++)
+                frame->int_value[slot] = combinePartial(parallel->kinds[i], frame->int_value[slot], loop.frames[t]->int_value[slot]);
+            continue;
+        }
+        frame->int_value[slot] = lastFrame->int_value[slot];
+        frame->char_value[slot] = lastFrame->char_value[slot];
+        frame->assigned[slot] = lastFrame->assigned[slot];
+    }
+    frame->int_value[loop.counter] = (int)(start + trips * step);
+
+    for (int t = 0; t < threads; t++) {
+        free(loop.frames[t]->int_value);
+        free(loop.frames[t]->char_value);
+        free(loop.frames[t]->assigned);
+        free(loop.frames[t]);
+    }
+    free(loop.frames);
+    return 1;
+}